@@ -1,8 +1,20 @@
 #pragma once
 #include "Prerequisites.h"
+#include "CpuFeatures.h"
 
 /**
  * @brief Class for converting between ASCII characters and binary representations.
+ * @details The text form is eight '0'/'1' digits per byte, most significant bit first, with
+ *          one space between bytes: 9 characters per byte. The static codec writes into
+ *          buffers the caller owns and allocates nothing per byte. Encoding copies 8 digits
+ *          per byte from a table; with SSSE3, 16 bytes become 144 characters in nine byte
+ *          shuffles. Decoding checks whole blocks against the canonical layout first: with
+ *          SSSE3 a block of 144 characters is validated with one comparison per vector and
+ *          its digits are packed back with movemask; without it, every 9 characters are
+ *          checked and packed as one 64-bit word. Text that is not canonical (other
+ *          whitespace, short tokens such as "1010") goes through the token parser, which
+ *          accepts everything the original binaryToString did and reports the position of
+ *          any character that is not a binary digit.
  */
 class
 AsciiBinary {
@@ -33,16 +45,8 @@ public:
 	 */
 	std::string
 	stringToBinary(const std::string& input) {
-		std::ostringstream oss; // Use ostringstream for efficient string concatenation
-		for (char c : input) {
-			oss << bitset(c) << " "; // Append the binary representation of each character followed by a space
-		}
-
-		std::string output = oss.str();
-		if (!output.empty()) {
-			output.pop_back(); // Remove the trailing space
-		}
-
+		std::string output;
+		encode(input, output);
 		return output;
 	}
 
@@ -68,16 +72,336 @@ public:
 	 */
 	std::string
 	binaryToString(const std::string& binaryInput) {
-		std::istringstream iss(binaryInput);
-		std::string result;// Initialize an empty result string
-		std::string binary;// Temporary string to hold each binary value
+		std::string result;
+		decodeLenient(binaryInput, result);
+		return result;
+	}
+
+	/**
+	 * @brief Number of characters of the binary text of size bytes.
+	 */
+	static size_t
+	encodedSize(size_t size) {
+		return size == 0 ? 0 : size * 9 - 1;
+	}
 
-		while (iss >> binary) {
-			result += binaryToChar(binary); // Convert each binary value to character and append to result
+	/**
+	 * @brief Writes the binary text of a buffer, without a trailing space.
+	 * @param data Bytes to encode.
+	 * @param size Number of bytes.
+	 * @param out Destination with room for encodedSize(size) characters.
+	 * @param simd False to force the table path.
+	 */
+	static void
+	encodeInto(const uint8_t* data, size_t size, char* out, bool simd = true) {
+		size_t i = 0;
+#ifdef VGS_X86
+		if (simd && CpuFeatures::get().ssse3) {
+			i = encodeSsse3(data, size, out);
+		}
+#endif
+		const char* tabla = encodeTable().data();
+		for (; i < size; ++i) {
+			std::memcpy(out + 9 * i, tabla + 8 * data[i], 8);
+			if (i + 1 < size) {
+				out[9 * i + 8] = ' ';
+			}
+		}
+	}
+
+	/**
+	 * @brief Binary text of a string into a reusable string.
+	 */
+	static void
+	encode(std::string_view text, std::string& out, bool simd = true) {
+		out.resize(encodedSize(text.size()));
+		if (!text.empty()) {
+			encodeInto(reinterpret_cast<const uint8_t*>(text.data()), text.size(), &out[0], simd);
+		}
+	}
+
+	/**
+	 * @brief Most bytes that size characters of binary text can hold.
+	 */
+	static size_t
+	decodedCapacity(size_t size) {
+		return (size + 1) / 2;
+	}
+
+	/**
+	 * @brief Decodes binary text: whitespace separated tokens of 1 to 8 binary digits.
+	 * @param text Binary text.
+	 * @param size Number of characters.
+	 * @param out Destination with room for decodedCapacity(size) bytes.
+	 * @param written Receives the number of bytes decoded, also those before an error.
+	 * @param error Receives the reason when the text is not valid.
+	 * @param simd False to force the scalar paths.
+	 * @return False on a character that is not a binary digit or whitespace, or on a
+	 *         token of more than 8 digits.
+	 */
+	static bool
+	decodeInto(const char* text, size_t size, uint8_t* out, size_t& written,
+	           std::string* error = nullptr, bool simd = true) {
+		size_t i = 0;
+#ifdef VGS_X86
+		if (simd && CpuFeatures::get().ssse3) {
+			i = decodeSsse3(text, size, out);
+		}
+#endif
+		size_t n = i / 9;
+		// Bytes canonicos sueltos: 8 digitos y un espacio, o el final del texto
+		while (i + 8 <= size && canonicalByte(text + i, out[n])) {
+			n++;
+			if (i + 8 == size) {
+				written = n;
+				return true;
+			}
+			if (text[i + 8] != ' ') {
+				// El token sigue o lo separa otro espacio: lo resuelve el analizador de tokens
+				n--;
+				break;
+			}
+			i += 9;
+		}
+
+		// Analizador de tokens para el resto, con las reglas del binaryToString original
+		while (i < size) {
+			if (isSpace(text[i])) {
+				++i;
+				continue;
+			}
+			size_t inicio = i;
+			unsigned int valor = 0;
+			for (; i < size && !isSpace(text[i]); ++i) {
+				if (text[i] != '0' && text[i] != '1') {
+					written = n;
+					return fail(error, "Invalid binary digit", i, text);
+				}
+				if (i - inicio == 8) {
+					written = n;
+					return fail(error, "More than 8 digits in token", inicio);
+				}
+				valor = valor * 2 + (text[i] - '0');
+			}
+			out[n++] = static_cast<uint8_t>(valor);
+		}
+		written = n;
+		return true;
+	}
+
+	/**
+	 * @brief Decodes binary text into a reusable string.
+	 * @return False if the text is not valid; out then holds the bytes before the error.
+	 */
+	static bool
+	decode(std::string_view text, std::string& out, std::string* error = nullptr, bool simd = true) {
+		out.resize(decodedCapacity(text.size()));
+		size_t escritos = 0;
+		bool valido = text.empty() ||
+		              decodeInto(text.data(), text.size(), reinterpret_cast<uint8_t*>(&out[0]), escritos, error, simd);
+		out.resize(escritos);
+		return valido;
+	}
+
+	/**
+	 * @brief Decodes any text exactly as the original binaryToString did.
+	 * @details Valid text goes through decode(). Otherwise every whitespace separated token
+	 *          becomes one byte, its characters taken as digits whatever they are, so
+	 *          malformed files give the same bytes as before.
+	 */
+	static void
+	decodeLenient(std::string_view text, std::string& out) {
+		if (decode(text, out)) {
+			return;
+		}
+		out.clear();
+		size_t i = 0;
+		while (i < text.size()) {
+			if (isSpace(text[i])) {
+				++i;
+				continue;
+			}
+			unsigned int valor = 0;
+			for (; i < text.size() && !isSpace(text[i]); ++i) {
+				valor = valor * 2 + static_cast<unsigned int>(text[i] - '0');
+			}
+			out += static_cast<char>(valor);
 		}
-		return result;
 	}
 
 private:
+	// Los 8 bytes de un token canonico: digitos '0' o '1' con el bit bajo libre
+	static constexpr uint64_t DIGIT_PATTERN = 0x3030303030303030ull;
+
+	// Bits que no pueden cambiar en un digito
+	static constexpr uint64_t DIGIT_FIXED_BITS = 0xFEFEFEFEFEFEFEFEull;
+
+	// El bit bajo de cada caracter del token
+	static constexpr uint64_t DIGIT_LOW_BITS = 0x0101010101010101ull;
+
+	// Lleva el bit del caracter k al bit 63 - k sin acarreos entre productos
+	static constexpr uint64_t GATHER_MULTIPLIER = 0x8040201008040201ull;
+
+	/**
+	 * @brief Whitespace as std::istringstream splits tokens.
+	 */
+	static bool
+	isSpace(char c) {
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+	}
+
+	/**
+	 * @brief Fills the error message and returns false.
+	 * @param text When given, the offending character is quoted.
+	 */
+	static bool
+	fail(std::string* error, const char* reason, size_t position, const char* text = nullptr) {
+		if (error != nullptr) {
+			*error = reason;
+			if (text != nullptr) {
+				*error += " '";
+				*error += text[position];
+				*error += "'";
+			}
+			*error += " at position " + std::to_string(position);
+		}
+		return false;
+	}
+
+	/**
+	 * @brief Checks and packs 8 digits read as one little-endian word.
+	 * @return False if any of them is not '0' or '1'.
+	 */
+	static bool
+	canonicalByte(const char* digits, uint8_t& value) {
+		uint64_t palabra;
+		std::memcpy(&palabra, digits, 8);
+		if ((palabra & DIGIT_FIXED_BITS) != DIGIT_PATTERN) {
+			return false;
+		}
+		// El primer digito queda en el bit 7
+		value = static_cast<uint8_t>(((palabra & DIGIT_LOW_BITS) * GATHER_MULTIPLIER) >> 56);
+		return true;
+	}
 
-};
\ No newline at end of file
+	/**
+	 * @brief The 8 digits of every byte value.
+	 */
+	static const std::array<char, 2048>&
+	encodeTable() {
+		static const std::array<char, 2048> tabla = []() {
+			std::array<char, 2048> t{};
+			for (int b = 0; b < 256; ++b) {
+				for (int bit = 0; bit < 8; ++bit) {
+					t[8 * b + bit] = static_cast<char>('0' + ((b >> (7 - bit)) & 1));
+				}
+			}
+			return t;
+		}();
+		return tabla;
+	}
+
+#ifdef VGS_X86
+	/**
+	 * @brief Shuffles and masks that turn 16 bytes into the nine vectors of their text.
+	 * @details Character p of the block belongs to byte p / 9; p % 9 is its bit, or the
+	 *          separator when it is 8.
+	 */
+	struct
+	BlockLayout {
+		alignas(16) uint8_t source[9][16];   // Byte each character comes from, 0x80 for spaces
+		alignas(16) uint8_t bit[9][16];      // Mask of its bit, 0 for spaces
+		alignas(16) uint8_t base[9][16];     // '0' for digits, ' ' for spaces
+		alignas(16) uint8_t fixed[9][16];    // Bits that must match base: all but the digit
+	};
+
+	static const BlockLayout&
+	blockLayout() {
+		static const BlockLayout disposicion = []() {
+			BlockLayout d{};
+			for (int p = 0; p < 144; ++p) {
+				int v = p / 16;
+				int l = p % 16;
+				int bit = p % 9;
+				bool espacio = bit == 8;
+				d.source[v][l] = espacio ? 0x80 : static_cast<uint8_t>(p / 9);
+				d.bit[v][l] = espacio ? 0 : static_cast<uint8_t>(0x80 >> bit);
+				d.base[v][l] = espacio ? ' ' : '0';
+				d.fixed[v][l] = espacio ? 0xFF : 0xFE;
+			}
+			return d;
+		}();
+		return disposicion;
+	}
+
+	/**
+	 * @brief Encodes whole blocks of 16 bytes that are followed by another byte, so the
+	 *        separator after the last one is always written.
+	 * @return Number of bytes encoded.
+	 */
+	VGS_TARGET("ssse3")
+	static size_t
+	encodeSsse3(const uint8_t* data, size_t size, char* out) {
+		const BlockLayout& d = blockLayout();
+		__m128i origen[9];
+		__m128i bits[9];
+		__m128i base[9];
+		for (int v = 0; v < 9; ++v) {
+			origen[v] = _mm_load_si128(reinterpret_cast<const __m128i*>(d.source[v]));
+			bits[v] = _mm_load_si128(reinterpret_cast<const __m128i*>(d.bit[v]));
+			// Un espacio compara igual (0 == 0) y resta -1: su base es ' ' - 1
+			base[v] = _mm_add_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(d.base[v])),
+			                       _mm_cmpeq_epi8(bits[v], _mm_setzero_si128()));
+		}
+		size_t i = 0;
+		for (; i + 16 < size; i += 16) {
+			__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+			char* destino = out + 9 * i;
+			for (int v = 0; v < 9; ++v) {
+				__m128i copia = _mm_shuffle_epi8(bytes, origen[v]);
+				__m128i puesto = _mm_cmpeq_epi8(_mm_and_si128(copia, bits[v]), bits[v]);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(destino + 16 * v), _mm_sub_epi8(base[v], puesto));
+			}
+		}
+		return i;
+	}
+
+	/**
+	 * @brief Decodes whole canonical blocks of 144 characters, stopping before the first
+	 *        block that is not canonical.
+	 * @return Number of characters decoded.
+	 */
+	VGS_TARGET("ssse3")
+	static size_t
+	decodeSsse3(const char* text, size_t size, uint8_t* out) {
+		const BlockLayout& d = blockLayout();
+		// Invierte cada grupo de 8 digitos: movemask pone el primero en el bit 0
+		const __m128i invertir = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+		size_t i = 0;
+		for (; i + 144 <= size; i += 144) {
+			const char* bloque = text + i;
+			__m128i malos = _mm_setzero_si128();
+			for (int v = 0; v < 9; ++v) {
+				__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bloque + 16 * v));
+				__m128i diferencia = _mm_sub_epi8(c, _mm_load_si128(reinterpret_cast<const __m128i*>(d.base[v])));
+				malos = _mm_or_si128(malos, _mm_and_si128(diferencia, _mm_load_si128(reinterpret_cast<const __m128i*>(d.fixed[v]))));
+			}
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(malos, _mm_setzero_si128())) != 0xFFFF) {
+				break;
+			}
+			// Dos bytes por paso: sus 16 digitos juntos, el bit bajo de cada uno al bit 7
+			uint8_t* destino = out + i / 9;
+			for (int par = 0; par < 8; ++par) {
+				__m128i digitos = _mm_unpacklo_epi64(
+					_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bloque + 18 * par)),
+					_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bloque + 18 * par + 9)));
+				digitos = _mm_slli_epi16(_mm_shuffle_epi8(digitos, invertir), 7);
+				uint16_t valores = static_cast<uint16_t>(_mm_movemask_epi8(digitos));
+				destino[2 * par] = static_cast<uint8_t>(valores);
+				destino[2 * par + 1] = static_cast<uint8_t>(valores >> 8);
+			}
+		}
+		return i;
+	}
+#endif
+};
@@ -0,0 +1,368 @@
+#pragma once
+#include "Prerequisites.h"
+#include "MappedFile.h"
+#include "SipHash.h"
+
+/**
+ * @brief Keyed-hash (blind) index of the user field of an encrypted container.
+ * @details Each user is stored only as a SipHash tag computed with a key derived from the
+ *          cipher key, so the index reveals nothing without that key. The file holds open
+ *          addressing hash tables that are read straight from a memory mapping:
+ *
+ *   offset 0   Header (HEADER_SIZE bytes)
+ *                char[4]  magic "VGBI"
+ *                uint32   version
+ *                uint64   slot count of the first table (power of two)
+ *                uint64   record count
+ *                uint8[16] salt
+ *                uint64   key-check tag
+ *   offset 48  slot count entries of uint64 tag + uint64 (record number + 1), 0 = empty
+ *   then       One table per append:
+ *                uint64   slot count (power of two)
+ *                uint64   records indexed before this table
+ *                slot count entries as above
+ *
+ *          A lookup hashes the user once and probes a few adjacent slots of each table, so
+ *          its cost does not depend on the number of records. Matches must still be
+ *          confirmed against the decrypted record, since different users may share a
+ *          64-bit tag. An append writes only a table for the new records and then the
+ *          record count of the header; a table left by an interrupted append still counts
+ *          no more records than the header and is ignored. Once there are MAX_TABLES
+ *          tables the next append merges them into one, through a temporary file, which
+ *          keeps lookups bounded at an amortized cost per append. Version 1 files are the
+ *          first table alone.
+ */
+class
+BlindIndex {
+public:
+  static constexpr uint32_t VERSION = 2;
+  static constexpr uint32_t VERSION_SINGLE_TABLE = 1;
+  static constexpr size_t HEADER_SIZE = 48;
+  static constexpr size_t SLOT_SIZE = 16;
+  static constexpr size_t TABLE_HEADER_SIZE = 16;
+  static constexpr size_t MAX_TABLES = 8;
+
+  BlindIndex() = default;
+  ~BlindIndex() = default;
+
+  /**
+   * @brief Derives the index key from the cipher key and the salt of the index.
+   */
+  static SipHash::Key
+  deriveKey(const std::string& key, const SipHash::Key& salt) {
+    SipHash::Key derived = SipHash::deriveKey(key, "blind-index");
+    for (size_t i = 0; i < derived.size(); ++i) {
+      derived[i] ^= salt[i];
+    }
+    return derived;
+  }
+
+  /**
+   * @brief Writes an index for a list of users.
+   * @param path Path of the index file.
+   * @param key The cipher key.
+   * @param salt Random salt for this index.
+   * @param users User of every record, in record order.
+   * @return True if the file was written.
+   */
+  static bool
+  write(const std::string& path, const std::string& key, const SipHash::Key& salt,
+        const std::vector<std::string_view>& users) {
+    SipHash::Key indexKey = deriveKey(key, salt);
+    std::vector<std::pair<uint64_t, uint64_t>> entries;
+    entries.reserve(users.size());
+    for (size_t i = 0; i < users.size(); ++i) {
+      entries.push_back({ SipHash::hash(indexKey, users[i]), i });
+    }
+    return writeEntries(path, indexKey, salt, entries);
+  }
+
+  /**
+   * @brief Writes an index from already computed (tag, record) pairs.
+   * @details The file is written under a temporary name and then renamed, so an existing
+   *          index is replaced only once the new one is complete.
+   * @param path Path of the index file.
+   * @param indexKey Key returned by deriveKey.
+   * @param salt Salt used to derive indexKey.
+   * @param entries Tag and record number of every record.
+   * @return True if the file was written.
+   */
+  static bool
+  writeEntries(const std::string& path, const SipHash::Key& indexKey, const SipHash::Key& salt,
+               const std::vector<std::pair<uint64_t, uint64_t>>& entries) {
+    std::vector<uint8_t> file(HEADER_SIZE, 0);
+    uint64_t slots = buildTable(entries, file);
+    std::memcpy(file.data(), "VGBI", 4);
+    file[4] = static_cast<uint8_t>(VERSION);
+    SipHash::store64(slots, &file[8]);
+    SipHash::store64(entries.size(), &file[16]);
+    std::memcpy(&file[24], salt.data(), salt.size());
+    SipHash::store64(SipHash::hash(indexKey, KEY_CHECK_LABEL), &file[40]);
+
+    std::string temporal = path + ".tmp";
+    {
+      std::ofstream out(temporal, std::ios::binary | std::ios::trunc);
+      if (!out.is_open()) {
+        return false;
+      }
+      out.write(reinterpret_cast<const char*>(file.data()), file.size());
+      if (!out.flush()) {
+        return false;
+      }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporal, path, error);
+    return !error;
+  }
+
+  /**
+   * @brief Adds the users of new records to an existing index.
+   * @details Writes one table with the new users after the last table of the file and
+   *          then updates the header. With MAX_TABLES tables already in the file, the
+   *          whole index is rewritten as a single table instead.
+   * @param path Path of the index file.
+   * @param key The cipher key, checked against the index.
+   * @param first Record number of the first new user.
+   * @param users User of every new record, in record order.
+   * @param error Receives the reason when the index cannot be updated.
+   * @return True if the index was updated.
+   */
+  static bool
+  append(const std::string& path, const std::string& key, uint64_t first,
+         const std::vector<std::string_view>& users, std::string& error) {
+    BlindIndex indice;
+    if (!indice.open(path, key)) {
+      error = indice.error();
+      return false;
+    }
+    std::vector<std::pair<uint64_t, uint64_t>> nuevas;
+    nuevas.reserve(users.size());
+    for (size_t i = 0; i < users.size(); ++i) {
+      nuevas.push_back({ SipHash::hash(indice.m_key, users[i]), first + i });
+    }
+
+    if (indice.m_tables.size() >= MAX_TABLES) {
+      // Une todas las tablas en una sola
+      std::vector<std::pair<uint64_t, uint64_t>> todas = indice.entries();
+      todas.insert(todas.end(), nuevas.begin(), nuevas.end());
+      SipHash::Key claveIndice = indice.m_key;
+      SipHash::Key sal = indice.m_salt;
+      indice.m_file.close();
+      if (!writeEntries(path, claveIndice, sal, todas)) {
+        error = "no se pudo escribir en " + path;
+        return false;
+      }
+      return true;
+    }
+
+    uint64_t fin = indice.m_end;
+    uint64_t registros = indice.m_records + nuevas.size();
+    std::vector<uint8_t> tabla(TABLE_HEADER_SIZE, 0);
+    uint64_t slots = buildTable(nuevas, tabla);
+    SipHash::store64(slots, &tabla[0]);
+    SipHash::store64(indice.m_records, &tabla[8]);
+    indice.m_file.close();
+
+    // Descarta lo que haya dejado un agregado interrumpido despues de la ultima tabla valida
+    std::error_code codigo;
+    std::filesystem::resize_file(path, fin, codigo);
+    std::fstream archivo(path, std::ios::binary | std::ios::in | std::ios::out);
+    if (codigo || !archivo.is_open()) {
+      error = "no se pudo escribir en " + path;
+      return false;
+    }
+    archivo.seekp(static_cast<std::streamoff>(fin));
+    archivo.write(reinterpret_cast<const char*>(tabla.data()), tabla.size());
+    archivo.flush();
+
+    // La cabecera al final: hasta aqui el indice sigue valido con sus registros anteriores
+    uint8_t cuenta[8];
+    SipHash::store64(registros, cuenta);
+    char version = static_cast<char>(VERSION);
+    archivo.seekp(4);
+    archivo.write(&version, 1);
+    archivo.seekp(16);
+    archivo.write(reinterpret_cast<const char*>(cuenta), sizeof(cuenta));
+    if (!archivo.flush()) {
+      error = "no se pudo escribir en " + path;
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Maps an index file and checks the key against it.
+   * @param path Path of the index file.
+   * @param key The cipher key.
+   * @return True if the index is valid and belongs to this key; otherwise see error().
+   */
+  bool
+  open(const std::string& path, const std::string& key) {
+    m_tables.clear();
+    if (!m_file.open(path)) {
+      m_error = "no se pudo abrir " + path;
+      return false;
+    }
+    const uint8_t* in = bytes();
+    if (m_file.size() < HEADER_SIZE || std::memcmp(in, "VGBI", 4) != 0 ||
+        (in[4] != VERSION && in[4] != VERSION_SINGLE_TABLE)) {
+      m_error = "no es un indice ciego valido";
+      return false;
+    }
+    uint64_t slots = SipHash::load64(in + 8);
+    m_records = SipHash::load64(in + 16);
+    std::memcpy(m_salt.data(), in + 24, m_salt.size());
+    if (!validSlots(slots, m_file.size() - HEADER_SIZE)) {
+      m_error = "indice ciego danado";
+      return false;
+    }
+    m_tables.push_back({ HEADER_SIZE, slots });
+    m_end = HEADER_SIZE + slots * SLOT_SIZE;
+
+    // Tablas agregadas; la que no indexa registros nuevos es un resto de un agregado interrumpido
+    while (in[4] == VERSION && m_file.size() - m_end >= TABLE_HEADER_SIZE) {
+      slots = SipHash::load64(in + m_end);
+      uint64_t anteriores = SipHash::load64(in + m_end + 8);
+      if (anteriores >= m_records ||
+          !validSlots(slots, m_file.size() - m_end - TABLE_HEADER_SIZE)) {
+        break;
+      }
+      m_tables.push_back({ m_end + TABLE_HEADER_SIZE, slots });
+      m_end += TABLE_HEADER_SIZE + slots * SLOT_SIZE;
+    }
+
+    m_key = deriveKey(key, m_salt);
+    if (SipHash::hash(m_key, KEY_CHECK_LABEL) != SipHash::load64(in + 40)) {
+      m_error = "la clave no corresponde a este indice";
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Returns the records whose user has the same tag as the given one.
+   * @param user The user to look for.
+   * @return Candidate record numbers, usually zero or one.
+   */
+  std::vector<uint64_t>
+  find(std::string_view user) const {
+    std::vector<uint64_t> result;
+    uint64_t tag = SipHash::hash(m_key, user);
+    for (const Table& t : m_tables) {
+      const uint8_t* tabla = bytes() + t.offset;
+      uint64_t slot = tag & (t.slots - 1);
+      for (uint64_t probes = 0; probes < t.slots; ++probes) {
+        uint64_t record = SipHash::load64(tabla + slot * SLOT_SIZE + 8);
+        if (record == 0) {
+          break;
+        }
+        if (SipHash::load64(tabla + slot * SLOT_SIZE) == tag) {
+          result.push_back(record - 1);
+        }
+        slot = (slot + 1) & (t.slots - 1);
+      }
+    }
+    return result;
+  }
+
+  /**
+   * @brief Returns every (tag, record) pair stored in the index.
+   */
+  std::vector<std::pair<uint64_t, uint64_t>>
+  entries() const {
+    std::vector<std::pair<uint64_t, uint64_t>> result;
+    result.reserve(m_records);
+    for (const Table& t : m_tables) {
+      const uint8_t* tabla = bytes() + t.offset;
+      for (uint64_t slot = 0; slot < t.slots; ++slot) {
+        uint64_t record = SipHash::load64(tabla + slot * SLOT_SIZE + 8);
+        if (record != 0) {
+          result.push_back({ SipHash::load64(tabla + slot * SLOT_SIZE), record - 1 });
+        }
+      }
+    }
+    return result;
+  }
+
+  /**
+   * @brief Key used for the tags of this index.
+   */
+  const SipHash::Key&
+  key() const {
+    return m_key;
+  }
+
+  /**
+   * @brief Salt stored in this index.
+   */
+  const SipHash::Key&
+  salt() const {
+    return m_salt;
+  }
+
+  /**
+   * @brief Reason of the last failure of open().
+   */
+  const std::string&
+  error() const {
+    return m_error;
+  }
+
+private:
+  static constexpr const char* KEY_CHECK_LABEL = "VGBI-key-check";
+
+  /**
+   * @brief One open addressing table of the file.
+   */
+  struct
+  Table {
+    uint64_t offset = 0;  // Offset of its first slot
+    uint64_t slots = 0;   // Number of slots, a power of two
+  };
+
+  /**
+   * @brief Checks that a slot count is a power of two that fits in the bytes left.
+   */
+  static bool
+  validSlots(uint64_t slots, uint64_t bytesLeft) {
+    return slots != 0 && (slots & (slots - 1)) == 0 && slots <= bytesLeft / SLOT_SIZE;
+  }
+
+  /**
+   * @brief Appends to out an open addressing table holding the entries.
+   * @return The slot count of the table.
+   */
+  static uint64_t
+  buildTable(const std::vector<std::pair<uint64_t, uint64_t>>& entries, std::vector<uint8_t>& out) {
+    // Load factor of at most one half keeps the probe sequences short
+    uint64_t slots = 16;
+    while (slots < entries.size() * 2) {
+      slots <<= 1;
+    }
+    size_t inicio = out.size();
+    out.resize(inicio + slots * SLOT_SIZE, 0);
+    uint8_t* tabla = out.data() + inicio;
+    for (const auto& entry : entries) {
+      uint64_t slot = entry.first & (slots - 1);
+      while (SipHash::load64(tabla + slot * SLOT_SIZE + 8) != 0) {
+        slot = (slot + 1) & (slots - 1);
+      }
+      SipHash::store64(entry.first, tabla + slot * SLOT_SIZE);
+      SipHash::store64(entry.second + 1, tabla + slot * SLOT_SIZE + 8);
+    }
+    return slots;
+  }
+
+  const uint8_t*
+  bytes() const {
+    return reinterpret_cast<const uint8_t*>(m_file.data());
+  }
+
+  MappedFile m_file;            // Mapped index file
+  std::vector<Table> m_tables;  // Tables in file order
+  uint64_t m_end = 0;           // End of the last valid table
+  uint64_t m_records = 0;       // Number of indexed records
+  SipHash::Key m_salt{};        // Salt stored in the header
+  SipHash::Key m_key{};         // Key derived from the cipher key and the salt
+  std::string m_error;          // Last error of open()
+};
@@ -0,0 +1,111 @@
+#pragma once
+#include "Prerequisites.h"
+
+/**
+ * @brief Fixed-capacity lock-free queue for several producers and consumers.
+ * @details Ring of cells, each tagged with a sequence number that tells producers and
+ *          consumers whether the cell is free or full for the current lap (D. Vyukov's
+ *          bounded MPMC queue). Push and pop claim a cell with a single compare-exchange
+ *          and never block; callers decide how to wait when the queue is full or empty.
+ */
+template<typename T>
+class
+BoundedQueue {
+public:
+  /**
+   * @brief Allocates the ring.
+   * @param capacity Minimum number of elements, rounded up to a power of two.
+   */
+  explicit BoundedQueue(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    m_mask = size - 1;
+    m_cells.reset(new Cell[size]);
+    for (size_t i = 0; i < size; ++i) {
+      m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  ~BoundedQueue() = default;
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  /**
+   * @brief Moves a value into the queue if there is room.
+   * @param value The value; it is left untouched when the queue is full.
+   * @return False if the queue is full.
+   */
+  bool
+  tryPush(T&& value) {
+    size_t pos = m_enqueue.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& cell = m_cells[pos & m_mask];
+      size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          cell.data = std::move(value);
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (diff < 0) {
+        return false;
+      }
+      else {
+        pos = m_enqueue.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @brief Moves the oldest value out of the queue if there is one.
+   * @param value Receives the value.
+   * @return False if the queue is empty.
+   */
+  bool
+  tryPop(T& value) {
+    size_t pos = m_dequeue.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& cell = m_cells[pos & m_mask];
+      size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (m_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          value = std::move(cell.data);
+          cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (diff < 0) {
+        return false;
+      }
+      else {
+        pos = m_dequeue.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @brief Returns the number of cells of the ring.
+   */
+  size_t
+  capacity() const {
+    return m_mask + 1;
+  }
+
+private:
+  struct
+  Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  std::unique_ptr<Cell[]> m_cells;               // Ring of cells
+  size_t m_mask = 0;                             // Capacity - 1
+  alignas(64) std::atomic<size_t> m_enqueue{ 0 }; // Next cell to fill
+  alignas(64) std::atomic<size_t> m_dequeue{ 0 }; // Next cell to empty
+};
@@ -0,0 +1,304 @@
+#pragma once
+#include "Prerequisites.h"
+#include "FrequencyAnalysis.h"
+#include "CaesarKernel.h"
+#include "MappedFile.h"
+#include "RecordParser.h"
+#include "ThreadPool.h"
+
+/**
+ * @brief Recovers Caesar shifts by chi-squared against letter frequencies.
+ * @details The letters of the ciphertext are counted once. Shifting the text by k only
+ *          rotates that histogram, so the 26 keys are scored by comparing the rotated
+ *          histogram with the reference frequencies of Spanish and English, with no
+ *          decryption at all. Because sum((c - e)^2 / e) = sum(c^2 / e) - total, each key
+ *          costs 26 multiply-adds of the squared counts against the inverse frequencies.
+ *          Files written by FileProtector::CifrarCaesar are cracked line by line in
+ *          parallel, and the counts of every line are also added up to find the shift of
+ *          the whole file.
+ */
+class
+CaesarCracker {
+public:
+  /**
+   * @brief A shift and how well its plaintext matches a language.
+   */
+  struct
+  Candidate {
+    int key = 0;                 // Shift used to encrypt, 0-25; -1 for a line without letters
+    double chiSquared = 0;       // Distance to the language; lower is better
+    FrequencyAnalysis::Language language = FrequencyAnalysis::Language::Spanish;
+  };
+
+  /**
+   * @brief Outcome of cracking a whole file.
+   */
+  struct
+  FileResult {
+    Candidate best;                 // Shift of the letters of all lines together
+    std::vector<Candidate> lines;   // Best shift of each non-empty line, in file order
+    double agreement = 0;           // Fraction of the lines whose own best shift is best.key
+  };
+
+  /**
+   * @brief Ranks the 26 shifts of a text.
+   * @param text The ciphertext.
+   * @param languages Reference languages; each key keeps its best language.
+   * @return The 26 shifts, most likely first. Empty if the text has no letters.
+   */
+  static std::vector<Candidate>
+  rankKeys(std::string_view text, const std::vector<FrequencyAnalysis::Language>& languages = defaultLanguages()) {
+    std::array<size_t, 26> conteo;
+    size_t total = FrequencyAnalysis::countLetters(text, conteo);
+    return rankKeys(conteo, total, languages);
+  }
+
+  /**
+   * @brief Ranks the 26 shifts of a letter histogram.
+   * @param counts Count of each letter A-Z of the ciphertext.
+   * @param total Sum of the counts.
+   * @param languages Reference languages; each key keeps its best language.
+   */
+  static std::vector<Candidate>
+  rankKeys(const std::array<size_t, 26>& counts, size_t total,
+           const std::vector<FrequencyAnalysis::Language>& languages = defaultLanguages()) {
+    std::vector<Candidate> result;
+    if (total == 0 || languages.empty()) {
+      return result;
+    }
+    result.resize(26);
+    for (int k = 0; k < 26; ++k) {
+      result[k].key = k;
+      result[k].chiSquared = std::numeric_limits<double>::infinity();
+    }
+    std::array<double, 26> chi;
+    for (FrequencyAnalysis::Language idioma : languages) {
+      scoreShifts(counts, total, idioma, chi);
+      for (int k = 0; k < 26; ++k) {
+        if (chi[k] < result[k].chiSquared) {
+          result[k].chiSquared = chi[k];
+          result[k].language = idioma;
+        }
+      }
+    }
+    std::stable_sort(result.begin(), result.end(), [](const Candidate& a, const Candidate& b) {
+      return a.chiSquared < b.chiSquared;
+    });
+    return result;
+  }
+
+  /**
+   * @brief Most likely shift of a text.
+   * @return Shift 0-25, or 0 if the text has no letters.
+   */
+  static int
+  bestKey(std::string_view text, const std::vector<FrequencyAnalysis::Language>& languages = defaultLanguages()) {
+    std::array<size_t, 26> conteo;
+    size_t total = FrequencyAnalysis::countLetters(text, conteo);
+    return total == 0 ? 0 : bestOf(conteo, total, languages).key;
+  }
+
+  /**
+   * @brief Chi-squared of every shift against one language.
+   * @param counts Count of each letter A-Z of the ciphertext.
+   * @param total Sum of the counts.
+   * @param language Reference language.
+   * @param chi Receives the same values as FrequencyAnalysis::chiSquared with each shift.
+   */
+  static void
+  scoreShifts(const std::array<size_t, 26>& counts, size_t total,
+              FrequencyAnalysis::Language language, std::array<double, 26>& chi) {
+    if (total == 0) {
+      chi.fill(std::numeric_limits<double>::infinity());
+      return;
+    }
+    const std::array<double, 26>& inversas = inverseFrequencies(language);
+    // Los cuadrados se calculan una vez y cada clave solo rota la tabla de frecuencias
+    double cuadrados[26];
+    for (int i = 0; i < 26; ++i) {
+      cuadrados[i] = static_cast<double>(counts[i]) * counts[i];
+    }
+    double n = static_cast<double>(total);
+    for (int k = 0; k < 26; ++k) {
+      double suma = 0;
+      for (int i = 0; i < 26; ++i) {
+        int j = i - k;
+        suma += cuadrados[i] * inversas[j < 0 ? j + 26 : j];
+      }
+      chi[k] = suma / n - n;
+    }
+  }
+
+  /**
+   * @brief Cracks every line of a file written by FileProtector::CifrarCaesar.
+   * @param path Path of the encrypted file.
+   * @param result Receives the shift of the file and of each line.
+   * @param threads Worker threads, 0 for one per core.
+   * @param languages Reference languages.
+   * @return False if the file could not be read or has no letters.
+   */
+  static bool
+  crackFile(const std::string& path, FileResult& result, unsigned int threads = 0,
+            const std::vector<FrequencyAnalysis::Language>& languages = defaultLanguages()) {
+    result = FileResult();
+    MappedFile archivo;
+    if (!archivo.open(path)) {
+      return false;
+    }
+    std::vector<std::string_view> lineas;
+    RecordParser::forEachLine(archivo.data(), archivo.size(), [&lineas](const char* linea, size_t longitud) {
+      if (longitud > 0) {
+        lineas.emplace_back(linea, longitud);
+      }
+    }, RecordParser::LineEnding::Encrypted);
+    return crackLines(lineas, result, threads, languages);
+  }
+
+  /**
+   * @brief Cracks a batch of lines that may each have their own shift.
+   * @param lines The encrypted lines.
+   * @param result Receives the shift of all lines together and of each line.
+   * @param threads Worker threads, 0 for one per core.
+   * @param languages Reference languages.
+   * @return False if the lines have no letters.
+   */
+  static bool
+  crackLines(const std::vector<std::string_view>& lines, FileResult& result, unsigned int threads = 0,
+             const std::vector<FrequencyAnalysis::Language>& languages = defaultLanguages()) {
+    result = FileResult();
+    result.lines.resize(lines.size());
+    if (lines.empty()) {
+      return false;
+    }
+    if (threads == 0) {
+      threads = ThreadPool::defaultThreads();
+    }
+
+    // Cada trozo devuelve la suma de sus histogramas para la clave del archivo completo
+    struct Parcial {
+      std::array<size_t, 26> conteo{};
+      size_t total = 0;
+    };
+    auto resolver = [&lines, &result, &languages](size_t desde, size_t hasta) {
+      Parcial parcial;
+      std::array<size_t, 26> conteo;
+      for (size_t i = desde; i < hasta; ++i) {
+        size_t total = FrequencyAnalysis::countLetters(lines[i], conteo);
+        result.lines[i] = bestOf(conteo, total, languages);
+        for (int c = 0; c < 26; ++c) {
+          parcial.conteo[c] += conteo[c];
+        }
+        parcial.total += total;
+      }
+      return parcial;
+    };
+
+    Parcial suma;
+    size_t partes = std::min<size_t>(threads, std::max<size_t>(1, lines.size() / MIN_LINES_PER_TASK));
+    if (partes <= 1) {
+      suma = resolver(0, lines.size());
+    }
+    else {
+      ThreadPool pool(static_cast<unsigned int>(partes));
+      std::vector<std::future<Parcial>> futuros;
+      size_t tamParte = (lines.size() + partes - 1) / partes;
+      for (size_t desde = 0; desde < lines.size(); desde += tamParte) {
+        size_t hasta = std::min(lines.size(), desde + tamParte);
+        futuros.push_back(pool.submit([&resolver, desde, hasta]() { return resolver(desde, hasta); }));
+      }
+      for (auto& futuro : futuros) {
+        Parcial parcial = futuro.get();
+        for (int c = 0; c < 26; ++c) {
+          suma.conteo[c] += parcial.conteo[c];
+        }
+        suma.total += parcial.total;
+      }
+    }
+
+    std::vector<Candidate> ranking = rankKeys(suma.conteo, suma.total, languages);
+    if (ranking.empty()) {
+      return false;
+    }
+    result.best = ranking.front();
+    size_t coinciden = 0;
+    size_t conLetras = 0;
+    for (const Candidate& linea : result.lines) {
+      if (linea.key >= 0) {
+        conLetras++;
+        coinciden += linea.key == result.best.key;
+      }
+    }
+    result.agreement = conLetras > 0 ? static_cast<double>(coinciden) / conLetras : 0;
+    return true;
+  }
+
+  /**
+   * @brief Decrypts a text with a recovered shift.
+   */
+  static std::string
+  decrypt(std::string_view text, int key) {
+    std::string result(text);
+    CaesarKernel(26 - (key % 26)).apply(result);
+    return result;
+  }
+
+  /**
+   * @brief Spanish and English, the languages of the project's data.
+   */
+  static const std::vector<FrequencyAnalysis::Language>&
+  defaultLanguages() {
+    static const std::vector<FrequencyAnalysis::Language> idiomas = {
+      FrequencyAnalysis::Language::Spanish, FrequencyAnalysis::Language::English
+    };
+    return idiomas;
+  }
+
+private:
+  // Lineas minimas por tarea para que repartir compense
+  static constexpr size_t MIN_LINES_PER_TASK = 4096;
+
+  /**
+   * @brief Best shift of a histogram without ranking the others.
+   * @return Key -1 and infinite distance if there are no letters.
+   */
+  static Candidate
+  bestOf(const std::array<size_t, 26>& counts, size_t total,
+         const std::vector<FrequencyAnalysis::Language>& languages) {
+    Candidate mejor;
+    mejor.key = -1;
+    mejor.chiSquared = std::numeric_limits<double>::infinity();
+    if (total == 0) {
+      return mejor;
+    }
+    std::array<double, 26> chi;
+    for (FrequencyAnalysis::Language idioma : languages) {
+      scoreShifts(counts, total, idioma, chi);
+      for (int k = 0; k < 26; ++k) {
+        if (chi[k] < mejor.chiSquared) {
+          mejor.key = k;
+          mejor.chiSquared = chi[k];
+          mejor.language = idioma;
+        }
+      }
+    }
+    return mejor;
+  }
+
+  /**
+   * @brief 1 / frequency of each letter of a language.
+   */
+  static const std::array<double, 26>&
+  inverseFrequencies(FrequencyAnalysis::Language language) {
+    auto invertir = [](FrequencyAnalysis::Language idioma) {
+      std::array<double, 26> t;
+      const std::array<double, 26>& f = FrequencyAnalysis::letterFrequencies(idioma);
+      for (int i = 0; i < 26; ++i) {
+        t[i] = 1.0 / f[i];
+      }
+      return t;
+    };
+    static const std::array<double, 26> ingles = invertir(FrequencyAnalysis::Language::English);
+    static const std::array<double, 26> espanol = invertir(FrequencyAnalysis::Language::Spanish);
+    return language == FrequencyAnalysis::Language::Spanish ? espanol : ingles;
+  }
+};
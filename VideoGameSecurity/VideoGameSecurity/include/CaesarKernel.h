@@ -0,0 +1,246 @@
+#pragma once
+#include "Prerequisites.h"
+#include "CpuFeatures.h"
+
+/**
+ * @brief Caesar shift of letters and digits through a translation table.
+ * @details The 256-entry table is built once per shift with the same per-character
+ *          formula CesarEncryption has always used, so the output is identical for every
+ *          shift value, including negative ones. Short inputs are translated byte by byte
+ *          through the table. Long inputs go through a vector kernel: the letter and
+ *          digit entries of the table are loaded into registers and looked up 16 or 32
+ *          characters at a time with byte shuffles (pshufb), and every other character
+ *          passes through unchanged.
+ */
+class
+CaesarKernel {
+public:
+  /**
+   * @brief Instruction set of a kernel.
+   */
+  enum class Isa {
+    Scalar,
+    SSSE3,
+    AVX2
+  };
+
+  CaesarKernel() {
+    setShift(0);
+  }
+
+  /**
+   * @brief Builds the table of a shift.
+   * @param shift Positions each letter and digit moves.
+   * @param isa Widest kernel allowed; lowered to what the CPU supports.
+   */
+  explicit CaesarKernel(int shift, Isa isa = Isa::AVX2) {
+    setShift(shift, isa);
+  }
+
+  /**
+   * @brief Replaces the shift and rebuilds the table.
+   */
+  void
+  setShift(int shift, Isa isa = Isa::AVX2) {
+    m_shift = shift;
+    m_isa = supported(isa);
+    for (int c = 0; c < 256; ++c) {
+      m_table[c] = static_cast<char>(translate(static_cast<char>(c), shift));
+    }
+    // Tablas de 16 entradas para los shuffles: letras 0-15, letras 16-25 y digitos
+    for (int i = 0; i < 16; ++i) {
+      m_lettersLow[i] = m_table['A' + i];
+      m_lettersHigh[i] = i < 10 ? m_table['A' + 16 + i] : 0;
+      m_digits[i] = i < 10 ? m_table['0' + i] : 0;
+    }
+  }
+
+  /**
+   * @brief Shift the table was built for.
+   */
+  int
+  shift() const {
+    return m_shift;
+  }
+
+  /**
+   * @brief Kernel in use.
+   */
+  Isa
+  isa() const {
+    return m_isa;
+  }
+
+  /**
+   * @brief Output byte of every input byte.
+   */
+  const std::array<char, 256>&
+  table() const {
+    return m_table;
+  }
+
+  /**
+   * @brief Translates a buffer.
+   * @param in Source characters.
+   * @param out Destination; may be the same as in.
+   * @param size Number of characters.
+   */
+  void
+  apply(const char* in, char* out, size_t size) const {
+    size_t i = 0;
+    if (size >= VECTOR_THRESHOLD) {
+      switch (m_isa) {
+#ifdef VGS_X86
+      case Isa::AVX2:
+        i = applyAvx2(in, out, size);
+        break;
+      case Isa::SSSE3:
+        i = applySsse3(in, out, size);
+        break;
+#endif
+      default:
+        break;
+      }
+    }
+    for (; i < size; ++i) {
+      out[i] = m_table[static_cast<unsigned char>(in[i])];
+    }
+  }
+
+  /**
+   * @brief Translates a string in place.
+   */
+  void
+  apply(std::string& text) const {
+    if (!text.empty()) {
+      apply(text.data(), &text[0], text.size());
+    }
+  }
+
+  /**
+   * @brief The original per-character rule: letters move within A-Z or a-z and digits
+   *        within 0-9; everything else is kept.
+   */
+  static char
+  translate(char c, int shift) {
+    // En 64 bits para que desplazamientos enormes no desborden
+    long long d = shift;
+    if (c >= 'A' && c <= 'Z') {
+      return static_cast<char>(((c - 'A' + d) % 26) + 'A');
+    }
+    if (c >= 'a' && c <= 'z') {
+      return static_cast<char>(((c - 'a' + d) % 26) + 'a');
+    }
+    if (c >= '0' && c <= '9') {
+      return static_cast<char>(((c - '0' + d) % 10) + '0');
+    }
+    return c;
+  }
+
+  /**
+   * @brief Returns the widest kernel not above the requested one that the CPU runs.
+   */
+  static Isa
+  supported(Isa requested) {
+    const CpuFeatures& cpu = CpuFeatures::get();
+    if (requested >= Isa::AVX2 && cpu.avx2) {
+      return Isa::AVX2;
+    }
+    if (requested >= Isa::SSSE3 && cpu.ssse3) {
+      return Isa::SSSE3;
+    }
+    return Isa::Scalar;
+  }
+
+  /**
+   * @brief Name of a kernel, for reports.
+   */
+  static const char*
+  name(Isa isa) {
+    switch (isa) {
+    case Isa::AVX2:  return "AVX2";
+    case Isa::SSSE3: return "SSSE3";
+    default:         return "escalar";
+    }
+  }
+
+private:
+  // Por debajo de este tamano la tabla es mas rapida que preparar los vectores
+  static constexpr size_t VECTOR_THRESHOLD = 64;
+
+#ifdef VGS_X86
+  /*
+   * Una letra de cualquier caja se busca por su indice (c | 0x20) - 'a' en las tablas de
+   * mayusculas y se le devuelve su bit de caja: la regla da siempre el mismo resultado
+   * mas 32 para la minuscula. pshufb solo mira los 4 bits bajos del indice, asi que los
+   * indices 16-25 caen solos en la segunda tabla.
+   */
+  VGS_TARGET("ssse3")
+  size_t
+  applySsse3(const char* in, char* out, size_t size) const {
+    const __m128i bajas = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_lettersLow));
+    const __m128i altas = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_lettersHigh));
+    const __m128i digitos = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_digits));
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+      __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+      __m128i caja = _mm_and_si128(c, _mm_set1_epi8(0x20));
+      __m128i letra = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+      __m128i esLetra = _mm_cmpeq_epi8(_mm_min_epu8(letra, _mm_set1_epi8(25)), letra);
+      __m128i primera = _mm_cmpeq_epi8(_mm_min_epu8(letra, _mm_set1_epi8(15)), letra);
+      __m128i nueva = _mm_or_si128(_mm_and_si128(primera, _mm_shuffle_epi8(bajas, letra)),
+                                   _mm_andnot_si128(primera, _mm_shuffle_epi8(altas, letra)));
+      nueva = _mm_add_epi8(nueva, caja);
+
+      __m128i digito = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+      __m128i esDigito = _mm_cmpeq_epi8(_mm_min_epu8(digito, _mm_set1_epi8(9)), digito);
+      __m128i nuevoDigito = _mm_shuffle_epi8(digitos, digito);
+
+      __m128i r = _mm_or_si128(_mm_and_si128(esLetra, nueva), _mm_andnot_si128(esLetra, c));
+      r = _mm_or_si128(_mm_and_si128(esDigito, nuevoDigito), _mm_andnot_si128(esDigito, r));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), r);
+    }
+    return i;
+  }
+
+  VGS_TARGET("avx2")
+  size_t
+  applyAvx2(const char* in, char* out, size_t size) const {
+    // vpshufb busca dentro de cada mitad de 128 bits: las tablas van repetidas
+    const __m256i bajas = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_lettersLow)));
+    const __m256i altas = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_lettersHigh)));
+    const __m256i digitos = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_digits)));
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+      __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+      __m256i caja = _mm256_and_si256(c, _mm256_set1_epi8(0x20));
+      __m256i letra = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+      __m256i esLetra = _mm256_cmpeq_epi8(_mm256_min_epu8(letra, _mm256_set1_epi8(25)), letra);
+      __m256i primera = _mm256_cmpeq_epi8(_mm256_min_epu8(letra, _mm256_set1_epi8(15)), letra);
+      __m256i nueva = _mm256_blendv_epi8(_mm256_shuffle_epi8(altas, letra),
+                                         _mm256_shuffle_epi8(bajas, letra), primera);
+      nueva = _mm256_add_epi8(nueva, caja);
+
+      __m256i digito = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+      __m256i esDigito = _mm256_cmpeq_epi8(_mm256_min_epu8(digito, _mm256_set1_epi8(9)), digito);
+      __m256i nuevoDigito = _mm256_shuffle_epi8(digitos, digito);
+
+      __m256i r = _mm256_blendv_epi8(c, nueva, esLetra);
+      r = _mm256_blendv_epi8(r, nuevoDigito, esDigito);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), r);
+    }
+    i += applySsse3(in + i, out + i, size - i);
+    return i;
+  }
+#endif
+
+  std::array<char, 256> m_table{};   // Output of every byte
+  char m_lettersLow[16] = {};        // Output of A-P
+  char m_lettersHigh[16] = {};       // Output of Q-Z
+  char m_digits[16] = {};            // Output of 0-9
+  int m_shift = 0;                   // Shift the table was built for
+  Isa m_isa = Isa::Scalar;           // Kernel in use
+};
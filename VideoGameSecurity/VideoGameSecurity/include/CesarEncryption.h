@@ -1,5 +1,7 @@
 #pragma once 
 #include "Prerequisites.h"
+#include "CaesarKernel.h"
+#include "CaesarCracker.h"
 /**
  * @brief Implements Caesar cipher encryption and decryption.
  * @details This class provides methods to encode and decode text using the Caesar cipher,
@@ -32,26 +34,33 @@ public:
      */
     std::string 
     encode(const std::string& texto, int desplazamiento) {
-        std::string result = "";
-
-        for (char c : texto) {
-            if (c >= 'A' && c <= 'Z') {
-                result += (char)(((c - 'A' + desplazamiento) % 26) + 'A');
-            }
-            else if (c >= 'a' && c <= 'z') {
-                result += (char)(((c - 'a' + desplazamiento) % 26) + 'a');
-            }
-            else if (c >= '0' && c <= '9') {
-                result += (char)(((c - '0' + desplazamiento) % 10) + '0');
-            }
-            else {
-                result += c;
-            }
+        std::string result(texto.size(), '\0');
+        if (!texto.empty()) {
+            kernel(desplazamiento).apply(texto.data(), &result[0], texto.size());
         }
-
         return result;
     }
 
+    /**
+     * @brief Encodes a buffer in place.
+     * @summary Same result as encode without allocating; meant for large buffers.
+     * @param datos The characters to encode; overwritten with the result.
+     * @param tamano The number of characters.
+     * @param desplazamiento The number of positions to shift each character.
+     */
+    void 
+    encodeInPlace(char* datos, size_t tamano, int desplazamiento) {
+        kernel(desplazamiento).apply(datos, datos, tamano);
+    }
+
+    /**
+     * @brief Encodes a string in place.
+     */
+    void 
+    encodeInPlace(std::string& texto, int desplazamiento) {
+        kernel(desplazamiento).apply(texto);
+    }
+
     /**
      * @brief Decodes a string encoded with the Caesar cipher.
      * @summary Reverses the Caesar cipher encoding by shifting characters in the opposite direction.
@@ -64,75 +73,72 @@ public:
         return encode(texto, 26 - (desplazamiento % 26));
     }
 
+    /**
+     * @brief Decodes a buffer in place.
+     * @param datos The encoded characters; overwritten with the result.
+     * @param tamano The number of characters.
+     * @param desplazamiento The number of positions originally used to shift each character.
+     */
+    void 
+    decodeInPlace(char* datos, size_t tamano, int desplazamiento) {
+        encodeInPlace(datos, tamano, 26 - (desplazamiento % 26));
+    }
+
+    /**
+     * @brief Decodes a string in place.
+     */
+    void 
+    decodeInPlace(std::string& texto, int desplazamiento) {
+        encodeInPlace(texto, 26 - (desplazamiento % 26));
+    }
+
     /**
      * @brief Attempts to decode a string using all possible Caesar cipher keys.
-     * @summary Performs a brute-force attack by trying all 26 possible shifts and outputs each result.
+     * @summary Scores the 26 shifts with CaesarCracker and prints each decryption,
+     *          most likely key first, with its chi-squared distance and language.
      * @param texto The encoded string to attempt to decode.
      * @return void
      */
     void 
     bruteForceAttack(const std::string& texto) {
-        std::cout << "\nIntentos de descifrado por fuerza bruta:\n";
-        for (int clave = 0; clave < 26; clave++) {
-            std::string intento = encode(texto, 26 - clave);
-            std::cout << "Clave " << clave << ": " << intento << std::endl;
+        std::vector<CaesarCracker::Candidate> ranking = CaesarCracker::rankKeys(texto);
+        std::ostringstream salida;
+        salida << "\nIntentos de descifrado por fuerza bruta (mas probable primero):\n";
+        if (ranking.empty()) {
+            salida << "El texto no contiene letras\n";
         }
+        salida << std::fixed << std::setprecision(1);
+        for (const CaesarCracker::Candidate& candidato : ranking) {
+            salida << "Clave " << candidato.key << " (chi2 " << candidato.chiSquared << ", "
+                   << FrequencyAnalysis::name(candidato.language) << "): "
+                   << decode(texto, candidato.key) << '\n';
+        }
+        std::cout << salida.str() << std::flush;
     }
 
     /**
      * @brief Evaluates the most probable key for decoding a Caesar ciphered string.
-     * @summary Uses frequency analysis and common Spanish words to estimate the most likely key.
+     * @summary Builds the letter histogram once and picks the shift whose rotated histogram
+     *          is closest to Spanish or English letter frequencies.
      * @param texto The encoded string to analyze.
-     * @return The most probable key for decoding the string.
+     * @return The most probable key for decoding the string, 0 if it has no letters.
      */
     int 
     evaluatePossibleKey(const std::string& texto) {
-        int frecuencias[26] = { 0 };
-
-        for (char c : texto) {
-            if (c >= 'a' && c <= 'z') {
-                frecuencias[c - 'a']++;
-            }
-            else if (c >= 'A' && c <= 'Z') {
-                frecuencias[c - 'A']++;
-            }
-        }
-
-        const char letrasEsp[] = { 'e', 'a', 'o', 's', 'r', 'n', 'i', 'd', 'l', 'c' };
-
-        int indiceMax = 0;
-        for (int i = 1; i < 26; ++i) {
-            if (frecuencias[i] > frecuencias[indiceMax]) {
-                indiceMax = i;
-            }
-        }
-
-        int mejorClave = 0;
-        int mejorPuntaje = -1;
-
-        for (char letraRef : letrasEsp) {
-            int clave = (indiceMax - (letraRef - 'a') + 26) % 26;
-            int puntaje = 0;
-
-            std::string descifrado = encode(texto, 26 - clave);
-
-            std::string comunes[] = { "el", "de", "la", "que", "en", "y", "los", "se" };
-
-            for (std::string palabra : comunes) {
-                if (descifrado.find(palabra) != std::string::npos) {
-                    puntaje++;
-                }
-            }
-
-            if (puntaje > mejorPuntaje) {
-                mejorPuntaje = puntaje;
-                mejorClave = clave;
-            }
-        }
-
-        return mejorClave;
+        return CaesarCracker::bestKey(texto);
     }
 
 private:
+    /**
+     * @brief Translation table of a shift, rebuilt only when the shift changes.
+     */
+    const CaesarKernel& 
+    kernel(int desplazamiento) {
+        if (m_kernel.shift() != desplazamiento) {
+            m_kernel.setShift(desplazamiento);
+        }
+        return m_kernel;
+    }
 
+    CaesarKernel m_kernel; // Table of the last shift used
 };
\ No newline at end of file
@@ -0,0 +1,312 @@
+#pragma once
+#include "Prerequisites.h"
+#include "CesarEncryption.h"
+#include "Vigenere.h"
+#include "DES.h"
+#include "XorKernel.h"
+#include "AsciiBinary.h"
+
+/*
+ * Pipeline stages. Each stage reproduces byte for byte the transformation of one of the
+ * cipher classes on a single record line. Stages that keep the length of the data work in
+ * place (inPlace == true) and expose encode(std::string&) / decode(std::string&); stages
+ * that change it write into a second buffer through encode(const std::string&, std::string&).
+ */
+
+/**
+ * @brief XOREncoder as a pipeline stage.
+ */
+struct
+XorStage {
+  static constexpr bool inPlace = true;
+
+  /**
+   * @param key The XOR key.
+   * @throws std::invalid_argument If the key is empty.
+   */
+  explicit XorStage(const std::string& key) : m_kernel(key) {
+    if (key.empty()) {
+      throw std::invalid_argument("The XOR key cannot be empty.");
+    }
+  }
+
+  static const char*
+  name() {
+    return "XOR";
+  }
+
+  void
+  encode(std::string& data) const {
+    m_kernel.apply(data);
+  }
+
+  void
+  decode(std::string& data) const {
+    encode(data);
+  }
+
+  XorKernel m_kernel;
+};
+
+/**
+ * @brief CesarEncryption as a pipeline stage.
+ * @details Both directions are CaesarKernel tables with the shifts CesarEncryption uses,
+ *          so records go through the same vector path as the cipher itself.
+ */
+struct
+CaesarStage {
+  static constexpr bool inPlace = true;
+
+  /**
+   * @param desplazamiento The Caesar shift.
+   */
+  explicit CaesarStage(int desplazamiento)
+    : m_encode(desplazamiento), m_decode(26 - (desplazamiento % 26)) {}
+
+  static const char*
+  name() {
+    return "Caesar";
+  }
+
+  void
+  encode(std::string& data) const {
+    m_encode.apply(data);
+  }
+
+  void
+  decode(std::string& data) const {
+    m_decode.apply(data);
+  }
+
+  CaesarKernel m_encode;
+  CaesarKernel m_decode;
+};
+
+/**
+ * @brief Vigenere as a pipeline stage.
+ * @details The key position restarts on every record, as Vigenere::encode does per call.
+ */
+struct
+VigenereStage {
+  static constexpr bool inPlace = true;
+
+  /**
+   * @param key The Vigenere key; non-letters are ignored.
+   * @throws std::invalid_argument If the key has no letters.
+   */
+  explicit VigenereStage(const std::string& key) {
+    std::string normalized = Vigenere::normalizeKey(key);
+    if (normalized.empty()) {
+      throw std::invalid_argument("The Vigenere key must contain at least one letter.");
+    }
+    for (char k : normalized) {
+      m_shifts.push_back(k - 'A');
+    }
+  }
+
+  static const char*
+  name() {
+    return "Vigenere";
+  }
+
+  void
+  encode(std::string& data) const {
+    size_t i = 0;
+    for (char& c : data) {
+      if (std::isalpha(static_cast<unsigned char>(c))) {
+        char base = std::islower(static_cast<unsigned char>(c)) ? 'a' : 'A';
+        c = static_cast<char>((c - base + m_shifts[i]) % 26 + base);
+        if (++i == m_shifts.size()) {
+          i = 0;
+        }
+      }
+    }
+  }
+
+  void
+  decode(std::string& data) const {
+    size_t i = 0;
+    for (char& c : data) {
+      if (std::isalpha(static_cast<unsigned char>(c))) {
+        char base = std::islower(static_cast<unsigned char>(c)) ? 'a' : 'A';
+        c = static_cast<char>(((c - base) - m_shifts[i] + 26) % 26 + base);
+        if (++i == m_shifts.size()) {
+          i = 0;
+        }
+      }
+    }
+  }
+
+  std::vector<int> m_shifts;
+};
+
+/**
+ * @brief AsciiBinary as a pipeline stage.
+ */
+struct
+AsciiBinaryStage {
+  static constexpr bool inPlace = false;
+
+  static const char*
+  name() {
+    return "ASCII-Binary";
+  }
+
+  void
+  encode(const std::string& in, std::string& out) const {
+    AsciiBinary::encode(in, out);
+  }
+
+  void
+  decode(const std::string& in, std::string& out) const {
+    // Same bytes as AsciiBinary::binaryToString, malformed tokens included
+    AsciiBinary::decodeLenient(in, out);
+  }
+};
+
+/**
+ * @brief DES as a pipeline stage.
+ * @details Encodes blocks of 8 characters padded with spaces and removes the trailing
+ *          spaces on decode, as FileProtector::CifrarDES and DescifrarDES do.
+ */
+struct
+DesStage {
+  static constexpr bool inPlace = false;
+
+  /**
+   * @param clave The DES key.
+   * @throws std::invalid_argument If the key is not 8 characters long.
+   */
+  explicit DesStage(const std::string& clave)
+    : m_des(DES::keyFromString(clave)) {
+    if (clave.length() != 8) {
+      throw std::invalid_argument("The DES key must be exactly 8 characters long.");
+    }
+  }
+
+  static const char*
+  name() {
+    return "DES";
+  }
+
+  void
+  encode(const std::string& in, std::string& out) const {
+    out.resize((in.size() + 7) / 8 * 8);
+    for (size_t j = 0; j < in.size(); j += 8) {
+      char bloque[8];
+      std::memset(bloque, ' ', 8);
+      std::memcpy(bloque, in.data() + j, std::min<size_t>(8, in.size() - j));
+      DesCore::store(m_des.encodeBlock(DesCore::load(bloque, 8)), &out[j]);
+    }
+  }
+
+  void
+  decode(const std::string& in, std::string& out) const {
+    out.resize((in.size() + 7) / 8 * 8);
+    for (size_t j = 0; j < in.size(); j += 8) {
+      DesCore::store(m_des.decodeBlock(DesCore::load(in.data() + j, in.size() - j)), &out[j]);
+    }
+    size_t endpos = out.find_last_not_of(" ");
+    if (endpos != std::string::npos) {
+      out.resize(endpos + 1);
+    }
+  }
+
+  DES m_des;
+};
+
+/**
+ * @brief Chain of cipher stages fused into a single pass over each record.
+ * @details The chain is fixed at compile time: encrypt() runs every stage in order and
+ *          decrypt() runs their inverses in reverse order, all inlined with no virtual
+ *          calls. Data moves between two reusable buffers, so no temporary strings are
+ *          created between stages. It has the same encrypt/decrypt interface as
+ *          RecordCipher and can be used with FileProtector::CifrarConPipeline.
+ *
+ * @code
+ *   CipherPipeline pipeline(VigenereStage("SECRETKEY"), XorStage("Fmuril123"));
+ *   protector.CifrarConPipeline(entrada, salida, pipeline);
+ * @endcode
+ */
+template<typename... Stages>
+class
+CipherPipeline {
+public:
+  static_assert(sizeof...(Stages) > 0, "A pipeline needs at least one stage.");
+
+  explicit CipherPipeline(Stages... stages) : m_stages(std::move(stages)...) {}
+
+  /**
+   * @brief Runs every stage on a record line.
+   * @param line The plain line.
+   * @param out Receives the encrypted line.
+   */
+  void
+  encrypt(const std::string& line, std::string& out) {
+    out.assign(line);
+    encodeFrom<0>(out);
+  }
+
+  /**
+   * @brief Undoes every stage on a record line, last stage first.
+   * @param line The encrypted line.
+   * @param out Receives the plain line.
+   */
+  void
+  decrypt(const std::string& line, std::string& out) {
+    out.assign(line);
+    decodeFrom<sizeof...(Stages)>(out);
+  }
+
+  /**
+   * @brief Returns the stage names joined with '+', for example "Vigenere+XOR".
+   */
+  std::string
+  name() const {
+    std::string result;
+    const char* names[] = { Stages::name()... };
+    for (const char* stageName : names) {
+      if (!result.empty()) {
+        result += '+';
+      }
+      result += stageName;
+    }
+    return result;
+  }
+
+private:
+  template<size_t I>
+  void
+  encodeFrom(std::string& data) {
+    if constexpr (I < sizeof...(Stages)) {
+      auto& stage = std::get<I>(m_stages);
+      if constexpr (std::decay_t<decltype(stage)>::inPlace) {
+        stage.encode(data);
+      }
+      else {
+        stage.encode(data, m_scratch);
+        data.swap(m_scratch);
+      }
+      encodeFrom<I + 1>(data);
+    }
+  }
+
+  template<size_t I>
+  void
+  decodeFrom(std::string& data) {
+    if constexpr (I > 0) {
+      auto& stage = std::get<I - 1>(m_stages);
+      if constexpr (std::decay_t<decltype(stage)>::inPlace) {
+        stage.decode(data);
+      }
+      else {
+        stage.decode(data, m_scratch);
+        data.swap(m_scratch);
+      }
+      decodeFrom<I - 1>(data);
+    }
+  }
+
+  std::tuple<Stages...> m_stages; // Stages in encryption order
+  std::string m_scratch;          // Second buffer for stages that change the length
+};
@@ -0,0 +1,90 @@
+#pragma once
+#include "Prerequisites.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define VGS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+/*
+ * VGS_TARGET marks a function that uses instructions beyond the baseline of the build.
+ * GCC and Clang need the attribute to accept the intrinsics; MSVC accepts them anywhere.
+ * Such functions must only be called after checking CpuFeatures.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define VGS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define VGS_TARGET(isa)
+#endif
+
+/*
+ * VGS_FLATTEN inlines every call made by a function. A VGS_TARGET function that runs
+ * generic templates on vector wrappers needs it: the templates themselves are compiled
+ * for the baseline, and only once inlined can the wrapper operators become single
+ * instructions. MSVC inlines them without being told.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define VGS_FLATTEN __attribute__((flatten))
+#else
+#define VGS_FLATTEN
+#endif
+
+/**
+ * @brief SIMD instruction sets usable on this machine.
+ * @details Detected once with CPUID. AVX2 and AVX-512 are only reported when the operating
+ *          system also saves the wider registers, so a kernel chosen from these flags
+ *          can always run.
+ */
+struct
+CpuFeatures {
+  bool sse2 = false;     // 16-byte vectors
+  bool ssse3 = false;    // Byte shuffles (pshufb) on 16-byte vectors
+  bool avx2 = false;     // 32-byte vectors
+  bool avx512 = false;   // 64-byte vectors (AVX-512 F and BW)
+
+  /**
+   * @brief Returns the features of the current CPU, detected on first use.
+   */
+  static const CpuFeatures&
+  get() {
+    static const CpuFeatures features = detect();
+    return features;
+  }
+
+private:
+  static CpuFeatures
+  detect() {
+    CpuFeatures f;
+#if defined(VGS_X86) && defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 0);
+    int maximo = info[0];
+    if (maximo < 1) {
+      return f;
+    }
+    __cpuid(info, 1);
+    f.sse2 = (info[3] & (1 << 26)) != 0;
+    f.ssse3 = (info[2] & (1 << 9)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || maximo < 7) {
+      return f;
+    }
+    unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    f.avx2 = (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+    f.avx512 = (xcr0 & 0xE6) == 0xE6 && (info[1] & (1 << 16)) != 0 &&
+               (info[1] & (1 << 30)) != 0;
+#elif defined(VGS_X86) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    f.sse2 = __builtin_cpu_supports("sse2");
+    f.ssse3 = __builtin_cpu_supports("ssse3");
+    f.avx2 = __builtin_cpu_supports("avx2");
+    f.avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+    return f;
+  }
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include "Prerequisites.h"
+#include "HexCodec.h"
 
 /**
  * @brief Provides cryptographic utility functions for password and key generation, encoding, and validation.
@@ -107,11 +108,7 @@ public:
    */
   std::string 
   toHex(const std::vector<uint8_t>& data) {
-    std::ostringstream oss;
-    for (const auto& byte : data) {
-      oss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(byte);
-    }
-    return oss.str();
+    return HexCodec::encode(data.data(), data.size());
   }
 
   /**
@@ -120,10 +117,11 @@ public:
    * @param hex The input hexadecimal string.
    * @return std::vector<uint8_t> The decoded byte vector.
    *
-   * @throws std::runtime_error If the hex string has an odd length.
+   * @throws std::runtime_error If the hex string has an odd length or a character that is
+   *         not a hex digit.
    *
    * @details
-   * Parses each pair of hex characters into a byte.
+   * Parses each pair of hex characters into a byte (see HexCodec::decodePacked).
    */
   std::vector<uint8_t> 
   fromHex(const std::string& hex) {
@@ -131,11 +129,9 @@ public:
       throw std::runtime_error("Invalid hex (odd length).");
 
     std::vector<uint8_t> data(hex.size() / 2);
-    for (size_t i = 0; i < data.size(); ++i) {
-      unsigned int byte;
-      std::istringstream(hex.substr(2 * i, 2)) >> std::hex >> byte;
-      data[i] = static_cast<uint8_t>(byte);
-    }
+    std::string error;
+    if (!HexCodec::decodePacked(hex.data(), hex.size(), data.data(), &error))
+      throw std::runtime_error(error + ".");
     return data;
   }
 
@@ -1,8 +1,12 @@
 #pragma once
 #include "Prerequisites.h"
+#include "DesCore.h"
 
 /**
  * @brief Class implementing the DES (Data Encryption Standard) algorithm.
+ * @details encode and decode run on DesCore, which works on 64-bit words with precomputed
+ *          tables. The std::bitset steps (expand, substitute, permuteP, feistel) are kept as
+ *          the bit-by-bit reference of the same cipher.
  */
 class 
 DES {
@@ -19,11 +23,30 @@ public:
 
   ~DES() = default; // Default destructor
 
+    /**
+     * @brief Converts an 8-character key string to the 64-bit key used by the constructor.
+     * @param clave The key string (must be 8 characters).
+     * @return The 64-bit key, first character in the lowest bit positions.
+     */
+    static std::bitset<64>
+    keyFromString(const std::string& clave) {
+      std::bitset<64> desClave;
+      for (int i = 0; i < 8 && i < static_cast<int>(clave.size()); i++) {
+        unsigned char c = clave[i];
+        for (int j = 0; j < 8; j++) {
+          desClave[i * 8 + j] = (c >> (7 - j)) & 1;
+        }
+      }
+      return desClave;
+    }
+
     /**
      * @brief Generates 16 subkeys from the main key for DES rounds.
      */
     void 
     generateSubkeys() {
+    subkeys.clear();
+    m_core.setKey(key.to_ullong());
     for (int i = 0; i < 16; ++i) {
       // Generate a 48-bit subkey by shifting the main key
       std::bitset<48> subkey((key.to_ullong() >> i) & 0xFFFFFFFFFFFF);
@@ -54,7 +77,7 @@ public:
     expand(const std::bitset<32>& halfBlock) {
       std::bitset<48> output;
       for (int i = 0; i < 48; i++) {
-        output[i] = halfBlock[32 - EXPANSION_TABLE[i]]; // Map bits using the expansion table
+        output[i] = halfBlock[32 - DesCore::EXPANSION_TABLE[i]]; // Map bits using the expansion table
       }
       return output;
     }
@@ -72,7 +95,7 @@ public:
           int row = (input[i * 6] << 1) | input[i * 6 + 5];
           int col = (input[i * 6 + 1] << 3) | (input[i * 6 + 2] << 2) |
                     (input[i * 6 + 3] << 1) | input[i * 6 + 4];
-          int sboxValue = SBOX[row % 4][col % 16]; // Get value from S-Box
+          int sboxValue = DesCore::SBOX[row % 4][col % 16]; // Get value from S-Box
 
           // Extract bits from the S-Box value
           for (int j = 0; j < 4; j++) {
@@ -91,7 +114,7 @@ public:
     permuteP(const std::bitset<32>& input) {
       std::bitset<32> output;
       for (int i = 0; i < 32; i++) {
-        output[i] = input[32 - P_TABLE[i]]; // Map bits using the P-Table
+        output[i] = input[32 - DesCore::P_TABLE[i]]; // Map bits using the P-Table
       }
       return output;
     }
@@ -132,20 +155,7 @@ public:
      */
     std::bitset<64> 
     encode(const std::bitset<64>& plaintext) {
-      auto data = iPermutation(plaintext); // Initial permutation
-      std::bitset<32> left(data.to_ullong() >> 32); // Split into left and right halves
-      std::bitset<32> right(data.to_ullong());
-
-      // Perform 16 rounds of DES
-      for (int round = 0; round < 16; round++) {
-          auto newRight = left ^ feistel(right, subkeys[round]); // Feistel function
-          left = right; // Swap halves
-          right = newRight;
-      }
-
-      // Combine left and right halves and apply final permutation
-      uint64_t combined = (static_cast<uint64_t>(right.to_ullong()) << 32) | left.to_ullong();
-      return fPermutation(std::bitset<64>(combined));
+      return std::bitset<64>(m_core.encrypt(plaintext.to_ullong()));
     }
 
     /**
@@ -155,20 +165,23 @@ public:
      */
     std::bitset<64> 
     decode(const std::bitset<64>& plaintext) {
-      auto data = iPermutation(plaintext); // Initial permutation
-      std::bitset<32> left(data.to_ullong() >> 32); // Split into left and right halves
-      std::bitset<32> right(data.to_ullong());
-
-      // Perform 16 rounds of DES in reverse order
-      for (int round = 15; round >= 0; --round) {
-          auto newRight = left ^ feistel(right, subkeys[round]); // Feistel function
-          left = right; // Swap halves
-          right = newRight;
-      }
+      return std::bitset<64>(m_core.decrypt(plaintext.to_ullong()));
+    }
+
+    /**
+     * @brief Encrypts a block held in a 64-bit word, first character in the highest byte.
+     */
+    uint64_t
+    encodeBlock(uint64_t plaintext) const {
+      return m_core.encrypt(plaintext);
+    }
 
-      // Combine left and right halves and apply final permutation
-      uint64_t combined = (static_cast<uint64_t>(right.to_ullong()) << 32) | left.to_ullong();
-      return fPermutation(std::bitset<64>(combined));
+    /**
+     * @brief Decrypts a block held in a 64-bit word.
+     */
+    uint64_t
+    decodeBlock(uint64_t ciphertext) const {
+      return m_core.decrypt(ciphertext);
     }
 
     /**
@@ -205,32 +218,5 @@ public:
 private:
   std::bitset<64> key; // The main 64-bit key
   std::vector<std::bitset<48>> subkeys; // Subkeys for DES rounds
-
-    // Simplified expansion table (E)
-    const int EXPANSION_TABLE[48] = {
-        32, 1, 2, 3, 4, 5,
-        4, 5, 6, 7, 8, 9,
-        8, 9,10,11,12,13,
-        12,13,14,15,16,17,
-        16,17,18,19,20,21,
-        20,21,22,23,24,25,
-        24,25,26,27,28,29,
-        28,29,30,31,32,1
-    };
-
-    // Simplified permutation table (P)
-    const int P_TABLE[32] = {
-        16, 7, 20, 21,29,12,28,17,
-         1,15,23,26, 5,18,31,10,
-         2, 8,24,14,32,27, 3, 9,
-        19,13,30, 6,22,11, 4,25
-    };
-
-    // Example S-Box (simplified)
-    const int SBOX[4][16] = {
-        {14,4,13,1,2,15,11,8,3,10,6,12,5,9,0,7},
-        {0,15,7,4,14,2,13,1,10,6,12,11,9,5,3,8},
-        {4,1,14,8,13,6,2,11,15,12,9,7,3,10,5,0},
-        {15,12,8,2,4,9,1,7,5,11,3,14,10,0,6,13}
-    };
+  DesCore m_core; // Word-level engine with the same subkeys
 };
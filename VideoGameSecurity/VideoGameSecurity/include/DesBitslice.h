@@ -0,0 +1,744 @@
+#pragma once
+#include "Prerequisites.h"
+#include "CpuFeatures.h"
+#include "DesCore.h"
+
+/**
+ * @brief Bitsliced DES: many independent blocks encrypted at once with logic instructions.
+ * @details The blocks of a batch are transposed so that word b holds bit b of every block,
+ *          one block per bit position. The cipher then runs on those 64 words as a circuit:
+ *          the expansion only picks words, the subkey flips the words of its set bits, the
+ *          S-box is a fixed sequence of 113 AND, OR, XOR and NOT operations on six words, and
+ *          P only decides which word receives each S-box output. Every operation processes
+ *          one bit of 64 blocks in a uint64_t, 256 in an AVX2 register or 512 in an AVX-512
+ *          register. Only whole batches go through the circuit, widest first; the last
+ *          blocks that do not fill a batch of 64 go through DesCore. The result is always
+ *          the one of the DES class.
+ */
+class
+DesBitslice {
+public:
+  /**
+   * @brief Engine used for the blocks.
+   */
+  enum class Engine {
+    Scalar,       // DesCore, one block at a time
+    Bitslice64,   // 64 blocks per pass in uint64_t words
+    AVX2,         // 256 blocks per pass
+    AVX512        // 512 blocks per pass
+  };
+
+  /**
+   * @brief Speed of one engine in benchmark().
+   */
+  struct
+  BenchmarkResult {
+    Engine engine = Engine::Scalar;
+    double nanosecondsPerBlock = 0;   // Time per 8-byte block
+    double speedup = 1;               // Scalar time divided by this one
+    bool identical = true;            // Same output as DesCore
+  };
+
+  // Bloques minimos para pasar por el circuito: menos no llenan un lote de 64
+  static constexpr size_t MIN_BLOCKS = 64;
+
+  DesBitslice() {
+    setKey(0);
+  }
+
+  /**
+   * @brief Prepares a key.
+   * @param key The 64-bit key, as DES::keyFromString returns it.
+   * @param engine Widest engine allowed; lowered to what the CPU supports.
+   */
+  explicit DesBitslice(uint64_t key, Engine engine = Engine::AVX512) {
+    setKey(key, engine);
+  }
+
+  /**
+   * @brief Replaces the key.
+   */
+  void
+  setKey(uint64_t key, Engine engine = Engine::AVX512) {
+    m_engine = supported(engine);
+    m_core.setKey(key);
+    // Un bit de subclave a 1 invierte la palabra de ese bit en todos los bloques
+    for (int ronda = 0; ronda < 16; ++ronda) {
+      for (int i = 0; i < 48; ++i) {
+        m_keyMasks[ronda][i] = (m_core.subkey(ronda) >> i) & 1 ? ~0ull : 0;
+      }
+    }
+  }
+
+  /**
+   * @brief Engine in use for inputs of at least MIN_BLOCKS blocks.
+   */
+  Engine
+  engine() const {
+    return m_engine;
+  }
+
+  /**
+   * @brief Encrypts consecutive blocks.
+   * @param in Blocks as DesCore::load builds them.
+   * @param out Receives the ciphertext; may be the same array as in.
+   * @param count Number of blocks.
+   */
+  void
+  encryptBlocks(const uint64_t* in, uint64_t* out, size_t count) const {
+    run(in, out, count, false);
+  }
+
+  /**
+   * @brief Decrypts consecutive blocks.
+   */
+  void
+  decryptBlocks(const uint64_t* in, uint64_t* out, size_t count) const {
+    run(in, out, count, true);
+  }
+
+  /**
+   * @brief Runs one block through the cipher under many keys at once and reports the keys
+   *        whose output passes a test.
+   * @details The keys are transposed like the blocks of encryptBlocks, so each key bit is a
+   *          word of the lanes; bit i of the subkey of round r is key bit i + r, which is
+   *          read and never rebuilt. The block is the same in every lane. The outputs are
+   *          not transposed back: the test runs on the 64 output words and marks the lanes
+   *          to keep, so rejecting a key costs a few logic operations shared by a whole
+   *          batch. Every engine works on words, so Engine::Scalar runs as Bitslice64.
+   * @param block The input block, as DesCore::load builds it.
+   * @param decrypt True to decrypt the block, false to encrypt it.
+   * @param keys The 64-bit keys, as DES::keyFromString returns them.
+   * @param count Number of keys.
+   * @param test Generic callable test(const V* bits, V& keep): bits[b] holds bit b of the
+   *             output of every lane; keep receives ones in the lanes to report.
+   * @param found Called as found(index) for each key kept, index being its position in keys.
+   * @param engine Widest engine allowed.
+   */
+  template<typename Test, typename Found>
+  static void
+  searchKeys(uint64_t block, bool decrypt, const uint64_t* keys, size_t count,
+             Test&& test, Found&& found, Engine engine = Engine::AVX512) {
+    engine = supported(engine);
+    size_t hechos = 0;
+#ifdef VGS_X86
+    if (engine >= Engine::AVX512) {
+      hechos += searchAvx512(block, decrypt, keys, count, test, found);
+    }
+    if (engine >= Engine::AVX2) {
+      hechos += searchAvx2(block, decrypt, keys + hechos, count - hechos, test, found, hechos);
+    }
+#endif
+    hechos += search64(block, decrypt, keys + hechos, count - hechos, test, found, hechos);
+    if (hechos == count) {
+      return;
+    }
+
+    // Las ultimas claves completan un lote con copias de la ultima, que no se reportan
+    uint64_t lote[64];
+    for (size_t i = 0; i < 64; ++i) {
+      lote[i] = keys[std::min(hechos + i, count - 1)];
+    }
+    size_t restantes = count - hechos;
+    search64(block, decrypt, lote, 64, test, [&](size_t indice) {
+      if (indice < restantes) {
+        found(hechos + indice);
+      }
+    }, 0);
+  }
+
+  /**
+   * @brief Widest engine the CPU can run, not wider than requested.
+   */
+  static Engine
+  supported(Engine requested) {
+    const CpuFeatures& cpu = CpuFeatures::get();
+    if (requested >= Engine::AVX512 && cpu.avx512) {
+      return Engine::AVX512;
+    }
+    if (requested >= Engine::AVX2 && cpu.avx2) {
+      return Engine::AVX2;
+    }
+    if (requested >= Engine::Bitslice64) {
+      return Engine::Bitslice64;
+    }
+    return Engine::Scalar;
+  }
+
+  /**
+   * @brief Name of an engine, for reports.
+   */
+  static const char*
+  name(Engine engine) {
+    switch (engine) {
+    case Engine::AVX512:     return "AVX-512";
+    case Engine::AVX2:       return "AVX2";
+    case Engine::Bitslice64: return "Bitslice 64";
+    default:                 return "Escalar";
+    }
+  }
+
+  /**
+   * @brief Times every engine the CPU supports on the same random blocks.
+   * @param blocks Blocks encrypted by each engine.
+   * @return One entry per engine, the scalar one first.
+   */
+  static std::vector<BenchmarkResult>
+  benchmark(size_t blocks = 1 << 16) {
+    std::vector<BenchmarkResult> result;
+    std::mt19937_64 azar(0xDE5);
+    uint64_t clave = azar();
+    std::vector<uint64_t> entrada(std::max<size_t>(blocks, 1));
+    for (uint64_t& bloque : entrada) {
+      bloque = azar();
+    }
+    std::vector<uint64_t> referencia(entrada.size());
+    std::vector<uint64_t> salida(entrada.size());
+
+    double escalar = 0;
+    for (Engine motor : { Engine::Scalar, Engine::Bitslice64, Engine::AVX2, Engine::AVX512 }) {
+      if (supported(motor) != motor) {
+        continue;
+      }
+      DesBitslice des(clave, motor);
+      std::vector<uint64_t>& destino = motor == Engine::Scalar ? referencia : salida;
+      // La mejor de varias pasadas, para no medir la primera con la cache fria
+      double segundos = std::numeric_limits<double>::infinity();
+      for (int pasada = 0; pasada < BENCHMARK_RUNS; ++pasada) {
+        auto inicio = std::chrono::steady_clock::now();
+        des.encryptBlocks(entrada.data(), destino.data(), entrada.size());
+        segundos = std::min(segundos,
+                            std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count());
+      }
+
+      BenchmarkResult medida;
+      medida.engine = motor;
+      medida.nanosecondsPerBlock = segundos * 1e9 / entrada.size();
+      if (motor == Engine::Scalar) {
+        escalar = segundos;
+      }
+      else {
+        medida.speedup = segundos > 0 ? escalar / segundos : 0;
+        medida.identical = salida == referencia;
+      }
+      result.push_back(medida);
+    }
+    return result;
+  }
+
+private:
+  // Pasadas de cada motor en benchmark()
+  static constexpr int BENCHMARK_RUNS = 3;
+
+  /**
+   * @brief 64 lanes in one uint64_t.
+   */
+  struct
+  Lanes64 {
+    static constexpr size_t WORDS = 1;
+    uint64_t v;
+
+    static Lanes64
+    load(const uint64_t* p) {
+      return { *p };
+    }
+
+    void
+    store(uint64_t* p) const {
+      *p = v;
+    }
+
+    static Lanes64
+    broadcast(uint64_t x) {
+      return { x };
+    }
+
+    static Lanes64
+    andNot(Lanes64 a, Lanes64 b) {
+      return { ~a.v & b.v };
+    }
+
+    static Lanes64
+    shiftLeft(Lanes64 a, int n) {
+      return { a.v << n };
+    }
+
+    static Lanes64
+    shiftRight(Lanes64 a, int n) {
+      return { a.v >> n };
+    }
+
+    friend Lanes64 operator^(Lanes64 a, Lanes64 b) { return { a.v ^ b.v }; }
+    friend Lanes64 operator&(Lanes64 a, Lanes64 b) { return { a.v & b.v }; }
+    friend Lanes64 operator|(Lanes64 a, Lanes64 b) { return { a.v | b.v }; }
+    friend Lanes64 operator~(Lanes64 a) { return { ~a.v }; }
+  };
+
+#ifdef VGS_X86
+  /**
+   * @brief 256 lanes in an AVX2 register.
+   */
+  struct
+  Lanes256 {
+    static constexpr size_t WORDS = 4;
+    __m256i v;
+
+    VGS_TARGET("avx2")
+    static Lanes256
+    load(const uint64_t* p) {
+      return { _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)) };
+    }
+
+    VGS_TARGET("avx2")
+    void
+    store(uint64_t* p) const {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+    }
+
+    VGS_TARGET("avx2")
+    static Lanes256
+    broadcast(uint64_t x) {
+      return { _mm256_set1_epi64x(static_cast<long long>(x)) };
+    }
+
+    VGS_TARGET("avx2")
+    static Lanes256
+    andNot(Lanes256 a, Lanes256 b) {
+      return { _mm256_andnot_si256(a.v, b.v) };
+    }
+
+    VGS_TARGET("avx2")
+    static Lanes256
+    shiftLeft(Lanes256 a, int n) {
+      return { _mm256_sll_epi64(a.v, _mm_cvtsi32_si128(n)) };
+    }
+
+    VGS_TARGET("avx2")
+    static Lanes256
+    shiftRight(Lanes256 a, int n) {
+      return { _mm256_srl_epi64(a.v, _mm_cvtsi32_si128(n)) };
+    }
+
+    VGS_TARGET("avx2") friend Lanes256 operator^(Lanes256 a, Lanes256 b) { return { _mm256_xor_si256(a.v, b.v) }; }
+    VGS_TARGET("avx2") friend Lanes256 operator&(Lanes256 a, Lanes256 b) { return { _mm256_and_si256(a.v, b.v) }; }
+    VGS_TARGET("avx2") friend Lanes256 operator|(Lanes256 a, Lanes256 b) { return { _mm256_or_si256(a.v, b.v) }; }
+    VGS_TARGET("avx2") friend Lanes256 operator~(Lanes256 a) { return { _mm256_xor_si256(a.v, _mm256_set1_epi64x(-1)) }; }
+  };
+
+  /**
+   * @brief 512 lanes in an AVX-512 register.
+   */
+  struct
+  Lanes512 {
+    static constexpr size_t WORDS = 8;
+    __m512i v;
+
+    VGS_TARGET("avx512f")
+    static Lanes512
+    load(const uint64_t* p) {
+      return { _mm512_loadu_si512(p) };
+    }
+
+    VGS_TARGET("avx512f")
+    void
+    store(uint64_t* p) const {
+      _mm512_storeu_si512(p, v);
+    }
+
+    VGS_TARGET("avx512f")
+    static Lanes512
+    broadcast(uint64_t x) {
+      return { _mm512_set1_epi64(static_cast<long long>(x)) };
+    }
+
+    // Con mascara completa: la forma sin mascara hace que GCC 12 avise de un valor sin iniciar
+    VGS_TARGET("avx512f")
+    static Lanes512
+    andNot(Lanes512 a, Lanes512 b) {
+      return { _mm512_mask_andnot_epi64(b.v, 0xFF, a.v, b.v) };
+    }
+
+    // Lo mismo en los desplazamientos
+    VGS_TARGET("avx512f")
+    static Lanes512
+    shiftLeft(Lanes512 a, int n) {
+      return { _mm512_mask_sll_epi64(a.v, 0xFF, a.v, _mm_cvtsi32_si128(n)) };
+    }
+
+    VGS_TARGET("avx512f")
+    static Lanes512
+    shiftRight(Lanes512 a, int n) {
+      return { _mm512_mask_srl_epi64(a.v, 0xFF, a.v, _mm_cvtsi32_si128(n)) };
+    }
+
+    VGS_TARGET("avx512f") friend Lanes512 operator^(Lanes512 a, Lanes512 b) { return { _mm512_xor_si512(a.v, b.v) }; }
+    VGS_TARGET("avx512f") friend Lanes512 operator&(Lanes512 a, Lanes512 b) { return { _mm512_and_si512(a.v, b.v) }; }
+    VGS_TARGET("avx512f") friend Lanes512 operator|(Lanes512 a, Lanes512 b) { return { _mm512_or_si512(a.v, b.v) }; }
+    VGS_TARGET("avx512f") friend Lanes512 operator~(Lanes512 a) { return { _mm512_ternarylogic_epi64(a.v, a.v, a.v, 0x55) }; }
+  };
+#endif
+
+  /**
+   * @brief Words the circuit reads and writes.
+   */
+  struct
+  Wiring {
+    int expansion[48];   // Bit of the right half that feeds each expansion bit
+    int target[32];      // Bit of the new half that receives each S-box output bit
+  };
+
+  static constexpr Wiring
+  wiring() {
+    Wiring w{};
+    for (int i = 0; i < 48; ++i) {
+      w.expansion[i] = 32 - DesCore::EXPANSION_TABLE[i];
+    }
+    // P lleva el bit 32 - P[i] de la salida de las cajas al bit i
+    for (int i = 0; i < 32; ++i) {
+      w.target[32 - DesCore::P_TABLE[i]] = i;
+    }
+    return w;
+  }
+
+  /**
+   * @brief Transposes a 64x64 bit matrix in every word of the lanes: bit c of row r goes
+   *        to bit r of row c.
+   */
+  template<typename V>
+  static void
+  transpose(V* m) {
+    uint64_t mascara = 0x00000000FFFFFFFFull;
+    for (int j = 32; j != 0; j >>= 1, mascara ^= mascara << j) {
+      const V bajos = V::broadcast(mascara);
+      for (int k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+        V t = (V::shiftRight(m[k], j) ^ m[k | j]) & bajos;
+        m[k] = m[k] ^ V::shiftLeft(t, j);
+        m[k | j] = m[k | j] ^ t;
+      }
+    }
+  }
+
+  /**
+   * @brief The S-box as a circuit.
+   * @details Each output bit was split on one input at a time (Shannon expansion) into
+   *          functions of fewer inputs, reusing every function already built for another
+   *          output; the variable order is the one that gave the fewest operations.
+   *          benchmark() compares the result with DesCore, which uses SBOX directly.
+   * @param x The six input bits, x[k] being bit k of the 6-bit group.
+   * @param out The four output bits, out[j] being bit 3 - j of the S-box value.
+   */
+  template<typename V>
+  static void
+  sbox(const V* x, V* out) {
+    const V x0 = x[0], x1 = x[1], x2 = x[2], x3 = x[3], x4 = x[4], x5 = x[5];
+    const V t0 = ~x2;
+    const V t1 = x4 | t0;
+    const V t2 = t1 ^ x1;
+    const V t3 = x4 & t0;
+    const V t4 = ~t3;
+    const V t5 = t4 ^ t0;
+    const V t6 = x1 & t5;
+    const V t7 = t4 ^ t6;
+    const V t8 = t2 ^ t7;
+    const V t9 = x0 & t8;
+    const V t10 = t2 ^ t9;
+    const V t11 = x2 ^ x4;
+    const V t12 = x1 & x2;
+    const V t13 = t11 ^ t12;
+    const V t14 = x4 & x2;
+    const V t15 = ~t14;
+    const V t16 = ~t5;
+    const V t17 = x1 & t11;
+    const V t18 = t15 ^ t17;
+    const V t19 = t13 ^ t18;
+    const V t20 = x0 & t19;
+    const V t21 = t13 ^ t20;
+    const V t22 = t10 ^ t21;
+    const V t23 = x5 & t22;
+    const V t24 = t10 ^ t23;
+    const V t25 = x1 & t15;
+    const V t26 = t16 ^ t25;
+    const V t27 = t19 ^ t26;
+    const V t28 = x0 & t27;
+    const V t29 = t19 ^ t28;
+    const V t30 = t18 ^ x0;
+    const V t31 = t29 ^ t30;
+    const V t32 = x5 & t31;
+    const V t33 = t29 ^ t32;
+    const V t34 = t24 ^ t33;
+    const V t35 = x3 & t34;
+    const V t36 = t24 ^ t35;
+    const V t37 = ~t11;
+    const V t38 = x1 & t0;
+    const V t39 = t37 ^ t38;
+    const V t40 = t39 ^ x5;
+    const V t41 = t4 ^ x1;
+    const V t42 = ~t2;
+    const V t43 = x5 & t37;
+    const V t44 = t41 ^ t43;
+    const V t45 = t40 ^ t44;
+    const V t46 = x3 & t45;
+    const V t47 = t40 ^ t46;
+    const V t48 = t1 ^ t27;
+    const V t49 = t42 ^ t48;
+    const V t50 = x5 & t49;
+    const V t51 = t42 ^ t50;
+    const V t52 = x1 & x4;
+    const V t53 = t1 ^ t52;
+    const V t54 = x1 & t1;
+    const V t55 = t16 ^ t54;
+    const V t56 = t53 ^ t55;
+    const V t57 = x5 & t56;
+    const V t58 = t53 ^ t57;
+    const V t59 = t51 ^ t58;
+    const V t60 = x3 & t59;
+    const V t61 = t51 ^ t60;
+    const V t62 = t47 ^ t61;
+    const V t63 = x0 & t62;
+    const V t64 = t47 ^ t63;
+    const V t66 = x3 & t39;
+    const V t67 = t7 ^ t66;
+    const V t68 = t5 ^ t27;
+    const V t69 = t68 ^ t26;
+    const V t70 = x3 & t69;
+    const V t71 = t68 ^ t70;
+    const V t72 = t67 ^ t71;
+    const V t73 = x5 & t72;
+    const V t74 = t67 ^ t73;
+    const V t75 = t14 ^ t4;
+    const V t76 = x1 & t75;
+    const V t77 = t14 ^ t76;
+    const V t78 = t77 ^ t41;
+    const V t79 = x3 & t78;
+    const V t80 = t77 ^ t79;
+    const V t82 = x3 & t53;
+    const V t83 = t26 ^ t82;
+    const V t84 = t80 ^ t83;
+    const V t85 = x5 & t84;
+    const V t86 = t80 ^ t85;
+    const V t87 = t74 ^ t86;
+    const V t88 = x0 & t87;
+    const V t89 = t74 ^ t88;
+    const V t90 = ~t39;
+    const V t91 = t77 ^ t90;
+    const V t92 = x0 & t91;
+    const V t93 = t77 ^ t92;
+    const V t94 = ~t7;
+    const V t95 = t37 ^ t52;
+    const V t96 = t94 ^ t95;
+    const V t97 = x0 & t96;
+    const V t98 = t94 ^ t97;
+    const V t99 = t93 ^ t98;
+    const V t100 = x5 & t99;
+    const V t101 = t93 ^ t100;
+    const V t102 = t15 ^ x1;
+    const V t103 = t102 ^ x0;
+    const V t104 = t4 ^ t54;
+    const V t105 = x2 ^ t76;
+    const V t106 = t104 ^ t105;
+    const V t107 = x0 & t106;
+    const V t108 = t104 ^ t107;
+    const V t109 = t103 ^ t108;
+    const V t110 = x5 & t109;
+    const V t111 = t103 ^ t110;
+    const V t112 = t101 ^ t111;
+    const V t113 = x3 & t112;
+    const V t114 = t101 ^ t113;
+    out[0] = t64;
+    out[1] = t36;
+    out[2] = t89;
+    out[3] = t114;
+  }
+
+  /**
+   * @brief The 16 rounds on a transposed block, halves swapped at the end like DesCore.
+   * @param m The 64 words of the block; bit b of the block is m[b].
+   * @param keyBit Called as keyBit(round, i) for bit i of the subkey of a round.
+   */
+  template<typename V, typename KeyBit>
+  static void
+  rounds(V* m, bool decrypt, KeyBit&& keyBit) {
+    static constexpr Wiring cables = wiring();
+    // Las mitades se alternan en lugar de copiarse: cada ronda escribe sobre la izquierda
+    V* izquierda = m + 32;
+    V* derecha = m;
+    for (int r = 0; r < 16; ++r) {
+      int ronda = decrypt ? 15 - r : r;
+      for (int grupo = 0; grupo < 8; ++grupo) {
+        V x[6];
+        V s[4];
+        for (int k = 0; k < 6; ++k) {
+          x[k] = derecha[cables.expansion[6 * grupo + k]] ^ keyBit(ronda, 6 * grupo + k);
+        }
+        sbox(x, s);
+        for (int j = 0; j < 4; ++j) {
+          V& destino = izquierda[cables.target[4 * grupo + j]];
+          destino = destino ^ s[j];
+        }
+      }
+      std::swap(izquierda, derecha);
+    }
+
+    // La salida lleva arriba la ultima mitad calculada, como DesCore
+    std::swap_ranges(m, m + 32, m + 32);
+  }
+
+  /**
+   * @brief Encrypts or decrypts one batch of 64 * V::WORDS blocks.
+   * @details Block r * V::WORDS + w is row r of the matrix in word w of the lanes, so the
+   *          rows load straight from the input and the lanes are transposed in place.
+   */
+  template<typename V>
+  void
+  cryptBatch(const uint64_t* in, uint64_t* out, bool decrypt) const {
+    V m[64];
+    for (int r = 0; r < 64; ++r) {
+      m[r] = V::load(in + r * V::WORDS);
+    }
+    transpose(m);
+    rounds(m, decrypt, [this](int ronda, int i) { return V::broadcast(m_keyMasks[ronda][i]); });
+    transpose(m);
+    for (int r = 0; r < 64; ++r) {
+      m[r].store(out + r * V::WORDS);
+    }
+  }
+
+  /**
+   * @brief One block under 64 * V::WORDS keys; see searchKeys.
+   * @param first Index reported for keys[0].
+   */
+  template<typename V, typename Test, typename Found>
+  static void
+  keyBatch(uint64_t block, bool decrypt, const uint64_t* keys, Test& test, Found& found, size_t first) {
+    V k[64];
+    for (int r = 0; r < 64; ++r) {
+      k[r] = V::load(keys + r * V::WORDS);
+    }
+    transpose(k);
+    V m[64];
+    for (int b = 0; b < 64; ++b) {
+      m[b] = V::broadcast((block >> b) & 1 ? ~0ull : 0);
+    }
+    rounds(m, decrypt, [&k](int ronda, int i) { return k[ronda + i]; });
+
+    V pasan;
+    test(static_cast<const V*>(m), pasan);
+    uint64_t palabras[V::WORDS];
+    pasan.store(palabras);
+    // El bit r de la palabra w es la clave r * V::WORDS + w
+    for (size_t w = 0; w < V::WORDS; ++w) {
+      for (uint64_t bits = palabras[w]; bits != 0; bits &= bits - 1) {
+        size_t fila = 0;
+        while (((bits >> fila) & 1) == 0) {
+          ++fila;
+        }
+        found(first + fila * V::WORDS + w);
+      }
+    }
+  }
+
+  /**
+   * @brief Runs every whole key batch that fits.
+   * @return Keys processed.
+   */
+  template<typename V, typename Test, typename Found>
+  static size_t
+  keyBatches(uint64_t block, bool decrypt, const uint64_t* keys, size_t count,
+             Test& test, Found& found, size_t first) {
+    constexpr size_t LOTE = 64 * V::WORDS;
+    size_t i = 0;
+    for (; i + LOTE <= count; i += LOTE) {
+      keyBatch<V>(block, decrypt, keys + i, test, found, first + i);
+    }
+    return i;
+  }
+
+  /**
+   * @brief Runs every whole batch that fits.
+   * @return Blocks processed.
+   */
+  template<typename V>
+  size_t
+  cryptBatches(const uint64_t* in, uint64_t* out, size_t count, bool decrypt) const {
+    constexpr size_t LOTE = 64 * V::WORDS;
+    size_t i = 0;
+    for (; i + LOTE <= count; i += LOTE) {
+      cryptBatch<V>(in + i, out + i, decrypt);
+    }
+    return i;
+  }
+
+  VGS_FLATTEN
+  size_t
+  crypt64(const uint64_t* in, uint64_t* out, size_t count, bool decrypt) const {
+    return cryptBatches<Lanes64>(in, out, count, decrypt);
+  }
+
+#ifdef VGS_X86
+  VGS_TARGET("avx2") VGS_FLATTEN
+  size_t
+  cryptAvx2(const uint64_t* in, uint64_t* out, size_t count, bool decrypt) const {
+    return cryptBatches<Lanes256>(in, out, count, decrypt);
+  }
+
+  VGS_TARGET("avx512f") VGS_FLATTEN
+  size_t
+  cryptAvx512(const uint64_t* in, uint64_t* out, size_t count, bool decrypt) const {
+    return cryptBatches<Lanes512>(in, out, count, decrypt);
+  }
+#endif
+
+  template<typename Test, typename Found>
+  VGS_FLATTEN
+  static size_t
+  search64(uint64_t block, bool decrypt, const uint64_t* keys, size_t count,
+           Test& test, Found&& found, size_t first) {
+    return keyBatches<Lanes64>(block, decrypt, keys, count, test, found, first);
+  }
+
+#ifdef VGS_X86
+  template<typename Test, typename Found>
+  VGS_TARGET("avx2") VGS_FLATTEN
+  static size_t
+  searchAvx2(uint64_t block, bool decrypt, const uint64_t* keys, size_t count,
+             Test& test, Found& found, size_t first) {
+    return keyBatches<Lanes256>(block, decrypt, keys, count, test, found, first);
+  }
+
+  template<typename Test, typename Found>
+  VGS_TARGET("avx512f") VGS_FLATTEN
+  static size_t
+  searchAvx512(uint64_t block, bool decrypt, const uint64_t* keys, size_t count,
+               Test& test, Found& found) {
+    return keyBatches<Lanes512>(block, decrypt, keys, count, test, found, 0);
+  }
+#endif
+
+  /**
+   * @brief Widest batches first, then narrower ones for what is left, then DesCore.
+   */
+  void
+  run(const uint64_t* in, uint64_t* out, size_t count, bool decrypt) const {
+    size_t hechos = 0;
+    if (count >= MIN_BLOCKS) {
+#ifdef VGS_X86
+      if (m_engine >= Engine::AVX512) {
+        hechos += cryptAvx512(in, out, count, decrypt);
+      }
+      if (m_engine >= Engine::AVX2) {
+        hechos += cryptAvx2(in + hechos, out + hechos, count - hechos, decrypt);
+      }
+#endif
+      if (m_engine >= Engine::Bitslice64) {
+        hechos += crypt64(in + hechos, out + hechos, count - hechos, decrypt);
+      }
+    }
+    for (; hechos < count; ++hechos) {
+      out[hechos] = decrypt ? m_core.decrypt(in[hechos]) : m_core.encrypt(in[hechos]);
+    }
+  }
+
+  DesCore m_core;                   // Engine for the blocks that do not fill a batch
+  uint64_t m_keyMasks[16][48];      // All ones where the subkey bit is set
+  Engine m_engine = Engine::Scalar; // Widest engine in use
+};
@@ -0,0 +1,224 @@
+#pragma once
+#include "Prerequisites.h"
+
+/**
+ * @brief Word-level engine of the project's DES variant.
+ * @details Computes exactly what the bit-by-bit DES class does: identity initial and final
+ *          permutations, subkey i equal to the low 48 bits of key >> i, the expansion table,
+ *          one S-box shared by the eight groups, and the P permutation. Blocks are uint64_t
+ *          with the first character in the highest byte, as DES::stringToBitset64 builds
+ *          them. Each 6-bit group of the expansion is a window of consecutive bits of the
+ *          half block, so two rotations of the half expose all eight groups one per byte;
+ *          the subkey is rearranged once into the same layout and the S-box followed by P is
+ *          precomputed as eight static tables of 64 words. A round is then two rotations, two
+ *          XORs with the subkey and eight lookups.
+ */
+class
+DesCore {
+public:
+  // Tabla de expansion: el bit i de la salida es el bit 32 - E[i] de la mitad
+  static constexpr int EXPANSION_TABLE[48] = {
+    32, 1, 2, 3, 4, 5,
+    4, 5, 6, 7, 8, 9,
+    8, 9,10,11,12,13,
+    12,13,14,15,16,17,
+    16,17,18,19,20,21,
+    20,21,22,23,24,25,
+    24,25,26,27,28,29,
+    28,29,30,31,32,1
+  };
+
+  // Tabla P: el bit i de la salida es el bit 32 - P[i] de la entrada
+  static constexpr int P_TABLE[32] = {
+    16, 7, 20, 21,29,12,28,17,
+     1,15,23,26, 5,18,31,10,
+     2, 8,24,14,32,27, 3, 9,
+    19,13,30, 6,22,11, 4,25
+  };
+
+  // La misma caja S para los ocho grupos de 6 bits
+  static constexpr int SBOX[4][16] = {
+    {14,4,13,1,2,15,11,8,3,10,6,12,5,9,0,7},
+    {0,15,7,4,14,2,13,1,10,6,12,11,9,5,3,8},
+    {4,1,14,8,13,6,2,11,15,12,9,7,3,10,5,0},
+    {15,12,8,2,4,9,1,7,5,11,3,14,10,0,6,13}
+  };
+
+  DesCore() = default;
+
+  /**
+   * @brief Prepares the subkeys of a key.
+   * @param key The 64-bit key, as DES::keyFromString returns it.
+   */
+  explicit DesCore(uint64_t key) {
+    setKey(key);
+  }
+
+  /**
+   * @brief Replaces the key.
+   */
+  void
+  setKey(uint64_t key) {
+    for (int i = 0; i < 16; ++i) {
+      m_subkeys[i] = (key >> i) & 0xFFFFFFFFFFFFull;
+      // Cada grupo de la subclave va invertido al byte que ocupa su ventana en las rotaciones
+      m_roundKeys[i][0] = 0;
+      m_roundKeys[i][1] = 0;
+      for (int grupo = 0; grupo < 8; ++grupo) {
+        uint32_t bits = reverse6(static_cast<uint32_t>(m_subkeys[i] >> (grupo * 6)) & 63);
+        m_roundKeys[i][WORD[grupo]] |= bits << (BYTE[grupo] * 8);
+      }
+    }
+  }
+
+  /**
+   * @brief Subkey of a round, in its low 48 bits.
+   */
+  uint64_t
+  subkey(int round) const {
+    return m_subkeys[round];
+  }
+
+  /**
+   * @brief Encrypts one block.
+   */
+  uint64_t
+  encrypt(uint64_t block) const {
+    const SpTable& sp = tables();
+    uint32_t izquierda = static_cast<uint32_t>(block >> 32);
+    uint32_t derecha = static_cast<uint32_t>(block);
+    for (int ronda = 0; ronda < 16; ++ronda) {
+      uint32_t nueva = izquierda ^ round(sp, derecha, m_roundKeys[ronda]);
+      izquierda = derecha;
+      derecha = nueva;
+    }
+    return static_cast<uint64_t>(derecha) << 32 | izquierda;
+  }
+
+  /**
+   * @brief Decrypts one block.
+   */
+  uint64_t
+  decrypt(uint64_t block) const {
+    const SpTable& sp = tables();
+    uint32_t izquierda = static_cast<uint32_t>(block >> 32);
+    uint32_t derecha = static_cast<uint32_t>(block);
+    for (int ronda = 15; ronda >= 0; --ronda) {
+      uint32_t nueva = izquierda ^ round(sp, derecha, m_roundKeys[ronda]);
+      izquierda = derecha;
+      derecha = nueva;
+    }
+    return static_cast<uint64_t>(derecha) << 32 | izquierda;
+  }
+
+  /**
+   * @brief Round function: expansion, subkey, S-box and P.
+   * @param half The right half of the block.
+   * @param subkey The 48-bit subkey of the round.
+   */
+  static uint32_t
+  feistel(uint32_t half, uint64_t subkey) {
+    uint32_t claves[2] = { 0, 0 };
+    for (int grupo = 0; grupo < 8; ++grupo) {
+      uint32_t bits = reverse6(static_cast<uint32_t>(subkey >> (grupo * 6)) & 63);
+      claves[WORD[grupo]] |= bits << (BYTE[grupo] * 8);
+    }
+    return round(tables(), half, claves);
+  }
+
+  /**
+   * @brief Block of up to 8 characters, first character in the highest byte; missing
+   *        characters are zero bytes, as in DES::stringToBitset64.
+   */
+  static uint64_t
+  load(const char* data, size_t size) {
+    uint64_t bloque = 0;
+    for (size_t i = 0; i < 8 && i < size; ++i) {
+      bloque |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << ((7 - i) * 8);
+    }
+    return bloque;
+  }
+
+  /**
+   * @brief Writes the 8 characters of a block, highest byte first.
+   */
+  static void
+  store(uint64_t block, char* out) {
+    for (int i = 0; i < 8; ++i) {
+      out[i] = static_cast<char>((block >> ((7 - i) * 8)) & 0xFF);
+    }
+  }
+
+private:
+  // El grupo g de la expansion son los bits 27 - 4g a 32 - 4g de la mitad, en orden inverso:
+  // rotar 3 bits a la derecha deja los grupos 6, 4, 2 y 0 en los bytes 0 a 3, y rotar 7 deja
+  // los grupos 5, 3, 1 y 7
+  static constexpr int WORD[8] = { 0, 1, 0, 1, 0, 1, 0, 1 };
+  static constexpr int BYTE[8] = { 3, 2, 2, 1, 1, 0, 0, 3 };
+
+  /**
+   * @brief S-box followed by P of each group, indexed by its byte of the rotated half.
+   */
+  using SpTable = uint32_t[8][64];
+
+  /**
+   * @brief Reverses the order of the low 6 bits.
+   */
+  static constexpr uint32_t
+  reverse6(uint32_t x) {
+    return (x & 1) << 5 | (x & 2) << 3 | (x & 4) << 1 | (x & 8) >> 1 | (x & 16) >> 3 | (x & 32) >> 5;
+  }
+
+  static uint32_t
+  rotateRight(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+  }
+
+  /**
+   * @brief Round function on the table already fetched and a subkey in rotation layout.
+   */
+  static uint32_t
+  round(const SpTable& sp, uint32_t half, const uint32_t key[2]) {
+    uint32_t u = rotateRight(half, 3) ^ key[0];
+    uint32_t v = rotateRight(half, 7) ^ key[1];
+    return sp[6][u & 63] ^ sp[4][(u >> 8) & 63] ^ sp[2][(u >> 16) & 63] ^ sp[0][(u >> 24) & 63] ^
+           sp[5][v & 63] ^ sp[3][(v >> 8) & 63] ^ sp[1][(v >> 16) & 63] ^ sp[7][(v >> 24) & 63];
+  }
+
+  static const SpTable&
+  tables() {
+    struct Tablas {
+      SpTable sp;
+    };
+    static const Tablas tablas = []() {
+      Tablas t{};
+      // Cada grupo de 6 bits da 4 bits de la caja S, que P reparte en la palabra de 32
+      for (int grupo = 0; grupo < 8; ++grupo) {
+        for (int x = 0; x < 64; ++x) {
+          int fila = ((x & 1) << 1) | ((x >> 5) & 1);
+          int columna = ((x >> 1) & 1) << 3 | ((x >> 2) & 1) << 2 | ((x >> 3) & 1) << 1 | ((x >> 4) & 1);
+          int valor = SBOX[fila][columna];
+          uint32_t sustituido = 0;
+          for (int j = 0; j < 4; ++j) {
+            if ((valor >> (3 - j)) & 1) {
+              sustituido |= 1u << (grupo * 4 + j);
+            }
+          }
+          uint32_t permutado = 0;
+          for (int i = 0; i < 32; ++i) {
+            if ((sustituido >> (32 - P_TABLE[i])) & 1) {
+              permutado |= 1u << i;
+            }
+          }
+          // La ventana rotada trae los bits del grupo al reves
+          t.sp[grupo][reverse6(x)] = permutado;
+        }
+      }
+      return t;
+    }();
+    return tablas.sp;
+  }
+
+  uint64_t m_subkeys[16] = {};       // Low 48 bits of key >> round
+  uint32_t m_roundKeys[16][2] = {};  // Subkeys rearranged like the two rotations of the half
+};
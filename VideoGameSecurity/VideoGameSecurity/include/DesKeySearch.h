@@ -0,0 +1,865 @@
+#pragma once
+#include "Prerequisites.h"
+#include "DesCore.h"
+#include "DesBitslice.h"
+#include "DesModes.h"
+#include "HexCodec.h"
+#include "MappedFile.h"
+#include "RecordParser.h"
+#include "ThreadPool.h"
+
+/**
+ * @brief Exhaustive search of a DES file key inside a keyspace given by a mask.
+ * @details The keys come from a policy (letters and digits only, a fixed prefix...), so
+ *          the keyspace is the set of characters allowed at each of the 8 positions. Every
+ *          key is tested against one block of one record of the file: the block is
+ *          decrypted under 512 keys at once with DesBitslice::searchKeys, which reads the
+ *          subkeys straight from the transposed key bits instead of building them per key,
+ *          and a key survives only if the 8 bytes are printable and start like the known
+ *          beginning of the record, for example "admin:". That check runs on the
+ *          transposed output, so a rejected key costs a fraction of an operation. The few
+ *          survivors decrypt whole records with DesCore and must turn the tested record and
+ *          most of a sample of others into printable user:password:others lines: a key that
+ *          differs from the right one only in bits used by the last rounds gives an almost
+ *          right text, which passes on some records but not on most.
+ *
+ *          The key schedule only reads bits 0 to 62 of the key, so the lowest bit of the
+ *          last character does not change the cipher: keys that differ only there are the
+ *          same key, and only one of each pair is tested.
+ *
+ *          The keyspace is split into chunks taken by the worker threads in order. Every
+ *          chunk below the first unfinished one is done, so that index is all a checkpoint
+ *          needs: it is written to a small text file every few seconds and at the end, and
+ *          a new search with the same file, keyspace and checkpoint resumes from it.
+ */
+class
+DesKeySearch {
+public:
+  // Caracteres de una clave DES, como pide CifrarDES
+  static constexpr size_t KEY_SIZE = 8;
+
+  /**
+   * @brief Characters allowed at each position of the key.
+   * @details A mask has one item per position: a literal character, a class or a set.
+   *          The classes are ?l (a-z), ?u (A-Z), ?d (0-9), ?s (space and symbols) and
+   *          ?a (all of them); ?? is a literal '?'. A set is written between brackets and
+   *          may mix characters, ranges and classes: "[?l?d_]", "[a-f0-9]". Only printable
+   *          ASCII is allowed, since keys are typed on the console.
+   */
+  class
+  Keyspace {
+  public:
+    /**
+     * @brief Builds the keyspace from a mask, for example "Clave?d?d?d" or "[?l?u?d]" eight times.
+     * @return False if the mask is not valid or does not have 8 positions; see error().
+     */
+    bool
+    parseMask(const std::string& mask) {
+      m_error.clear();
+      std::array<std::string, KEY_SIZE> conjuntos;
+      size_t posicion = 0;
+      for (size_t i = 0; i < mask.size(); ++posicion) {
+        std::string conjunto;
+        if (mask[i] == '[') {
+          size_t cierre = mask.find(']', i + 1);
+          if (cierre == std::string::npos) {
+            return fail("Unclosed '[' in the mask");
+          }
+          if (!expand(mask.substr(i + 1, cierre - i - 1), conjunto)) {
+            return false;
+          }
+          i = cierre + 1;
+        }
+        else {
+          size_t largo = mask[i] == '?' ? 2 : 1;
+          if (!expand(mask.substr(i, largo), conjunto)) {
+            return false;
+          }
+          i += largo;
+        }
+        if (posicion < KEY_SIZE) {
+          conjuntos[posicion] = conjunto;
+        }
+      }
+      if (posicion != KEY_SIZE) {
+        return fail("The mask has " + std::to_string(posicion) + " positions, a DES key has 8");
+      }
+      return build(conjuntos, "mask " + mask);
+    }
+
+    /**
+     * @brief Builds the keyspace from one set of characters for every position after a
+     *        fixed prefix.
+     * @param charset Characters, ranges and classes, as inside a mask set: "?l?u?d".
+     * @param prefix Literal characters the key starts with.
+     * @return False if the set is not valid or the prefix is too long; see error().
+     */
+    bool
+    setCharset(const std::string& charset, const std::string& prefix = std::string()) {
+      m_error.clear();
+      if (prefix.size() > KEY_SIZE) {
+        return fail("The prefix is longer than a DES key");
+      }
+      std::string conjunto;
+      if (!expand(charset, conjunto)) {
+        return false;
+      }
+      std::array<std::string, KEY_SIZE> conjuntos;
+      for (size_t i = 0; i < KEY_SIZE; ++i) {
+        if (i < prefix.size()) {
+          if (!printable(prefix[i])) {
+            return fail("The prefix has a character that is not printable ASCII");
+          }
+          conjuntos[i] = std::string(1, prefix[i]);
+        }
+        else {
+          conjuntos[i] = conjunto;
+        }
+      }
+      return build(conjuntos, "charset " + charset + " prefix " + prefix);
+    }
+
+    /**
+     * @brief Number of keys searched: one of each pair of equivalent keys.
+     */
+    uint64_t
+    size() const {
+      return m_size;
+    }
+
+    /**
+     * @brief Key of an index in [0, size()); the last character changes fastest.
+     */
+    std::string
+    key(uint64_t index) const {
+      std::string clave(KEY_SIZE, '\0');
+      for (size_t i = KEY_SIZE; i-- > 0; ) {
+        clave[i] = m_sets[i][index % m_sets[i].size()];
+        index /= m_sets[i].size();
+      }
+      return clave;
+    }
+
+    /**
+     * @brief Writes the 64-bit values of consecutive keys, as DES::keyFromString returns them.
+     * @param first Index of the first key.
+     * @param count Number of keys; first + count must not pass size().
+     * @param out Receives count values.
+     */
+    void
+    values(uint64_t first, size_t count, uint64_t* out) const {
+      if (count == 0) {
+        return;
+      }
+      // Cuenta como un odometro: solo la ultima posicion cambia en casi todas las claves
+      size_t digitos[KEY_SIZE];
+      for (size_t i = KEY_SIZE; i-- > 0; ) {
+        digitos[i] = static_cast<size_t>(first % m_sets[i].size());
+        first /= m_sets[i].size();
+      }
+      uint64_t base = 0;
+      for (size_t i = 0; i + 1 < KEY_SIZE; ++i) {
+        base |= m_values[i][digitos[i]];
+      }
+      const std::vector<uint64_t>& ultimos = m_values[KEY_SIZE - 1];
+      size_t& ultimo = digitos[KEY_SIZE - 1];
+      for (size_t n = 0; n < count; ++n) {
+        out[n] = base | ultimos[ultimo];
+        if (++ultimo < ultimos.size()) {
+          continue;
+        }
+        ultimo = 0;
+        for (size_t i = KEY_SIZE - 1; i-- > 0; ) {
+          base ^= m_values[i][digitos[i]];
+          if (++digitos[i] == m_values[i].size()) {
+            digitos[i] = 0;
+          }
+          base ^= m_values[i][digitos[i]];
+          if (digitos[i] != 0) {
+            break;
+          }
+        }
+      }
+    }
+
+    /**
+     * @brief Keys of the mask that encrypt exactly like a given one, the key included.
+     */
+    std::vector<std::string>
+    equivalents(const std::string& key) const {
+      std::vector<std::string> result;
+      for (char c : m_lastAll) {
+        if (key.size() == KEY_SIZE && (c | 1) == (key.back() | 1)) {
+          result.push_back(key.substr(0, KEY_SIZE - 1) + c);
+        }
+      }
+      return result;
+    }
+
+    /**
+     * @brief How the keyspace was built, for checkpoints.
+     */
+    const std::string&
+    description() const {
+      return m_description;
+    }
+
+    /**
+     * @brief Reason of the last failure.
+     */
+    const std::string&
+    error() const {
+      return m_error;
+    }
+
+  private:
+    static bool
+    printable(char c) {
+      return c >= 0x20 && c <= 0x7E;
+    }
+
+    /**
+     * @brief Characters of a class, without the '?'.
+     */
+    static const char*
+    classCharacters(char name) {
+      switch (name) {
+      case 'l': return "abcdefghijklmnopqrstuvwxyz";
+      case 'u': return "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+      case 'd': return "0123456789";
+      case 's': return " !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+      case 'a': return "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+                       " !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+      case '?': return "?";
+      default:  return nullptr;
+      }
+    }
+
+    /**
+     * @brief Expands characters, ranges and classes into a set without repeats.
+     */
+    bool
+    expand(const std::string& spec, std::string& out) {
+      out.clear();
+      auto agregar = [&out](char c) {
+        if (out.find(c) == std::string::npos) {
+          out += c;
+        }
+      };
+      for (size_t i = 0; i < spec.size(); ++i) {
+        if (spec[i] == '?') {
+          const char* clase = i + 1 < spec.size() ? classCharacters(spec[i + 1]) : nullptr;
+          if (clase == nullptr) {
+            return fail("Unknown class \"" + spec.substr(i, 2) + "\"; use ?l, ?u, ?d, ?s, ?a or ??");
+          }
+          for (; *clase != '\0'; ++clase) {
+            agregar(*clase);
+          }
+          ++i;
+          continue;
+        }
+        if (!printable(spec[i])) {
+          return fail("Keys may only contain printable ASCII");
+        }
+        // Un guion entre dos caracteres es un rango
+        if (i + 2 < spec.size() && spec[i + 1] == '-' && spec[i + 2] != '?') {
+          if (!printable(spec[i + 2]) || spec[i + 2] < spec[i]) {
+            return fail("Invalid range \"" + spec.substr(i, 3) + "\"");
+          }
+          for (char c = spec[i]; c <= spec[i + 2]; ++c) {
+            agregar(c);
+          }
+          i += 2;
+          continue;
+        }
+        agregar(spec[i]);
+      }
+      if (out.empty()) {
+        return fail("Empty set of characters in the mask");
+      }
+      return true;
+    }
+
+    /**
+     * @brief Keeps the sets, drops the equivalent characters of the last position and
+     *        precomputes the bits each character adds to the key.
+     */
+    bool
+    build(const std::array<std::string, KEY_SIZE>& sets, const std::string& description) {
+      m_sets = sets;
+      m_lastAll = sets[KEY_SIZE - 1];
+      std::string& ultimo = m_sets[KEY_SIZE - 1];
+      ultimo.clear();
+      for (char c : m_lastAll) {
+        if (ultimo.find(static_cast<char>(c ^ 1)) == std::string::npos) {
+          ultimo += c;
+        }
+      }
+      m_size = 1;
+      for (size_t i = 0; i < KEY_SIZE; ++i) {
+        m_values[i].clear();
+        for (char c : m_sets[i]) {
+          m_values[i].push_back(keyValue(std::string(KEY_SIZE, '\0').replace(i, 1, 1, c)));
+        }
+        m_size *= m_sets[i].size();
+      }
+      m_description = description;
+      return true;
+    }
+
+    bool
+    fail(const std::string& reason) {
+      m_error = reason;
+      m_size = 0;
+      return false;
+    }
+
+    std::array<std::string, KEY_SIZE> m_sets;                // Characters tried at each position
+    std::array<std::vector<uint64_t>, KEY_SIZE> m_values;    // Key bits of each of those characters
+    std::string m_lastAll;                                   // Last position with the equivalent characters
+    uint64_t m_size = 0;                                     // Keys tried
+    std::string m_description;                               // Mask or charset it was built from
+    std::string m_error;                                     // Reason of the last failure
+  };
+
+  /**
+   * @brief State of a running search.
+   */
+  struct
+  Progress {
+    uint64_t done = 0;                    // Keys below the first unfinished chunk
+    uint64_t total = 0;                   // Keys in the keyspace
+    double keysPerSecond = 0;             // Speed of this run
+    double seconds = 0;                   // Time of this run
+    double remainingSeconds = 0;          // Estimate at the current speed
+  };
+
+  /**
+   * @brief Search settings.
+   */
+  struct
+  Options {
+    std::string crib;                     // Known beginning of the record tested, e.g. "admin:"
+    unsigned int threads = 0;             // Worker threads, 0 for one per core
+    DesBitslice::Engine engine = DesBitslice::Engine::AVX512;  // Widest engine allowed
+    std::string checkpointPath;           // Checkpoint file; empty to neither save nor resume
+    double checkpointSeconds = 10;        // Time between checkpoints
+    double progressSeconds = 1;           // Time between calls to onProgress
+    double timeLimit = 0;                 // Seconds before stopping with a checkpoint, 0 for none
+    std::function<void(const Progress&)> onProgress;        // Called on the calling thread
+  };
+
+  /**
+   * @brief Outcome of a search.
+   */
+  struct
+  Result {
+    bool found = false;                   // A key decrypts the sample records
+    std::string key;                      // The key found
+    std::vector<std::string> equivalents; // Keys of the keyspace with the same subkeys, key included
+    std::string plaintext;                // First sample record decrypted with the key
+    size_t samples = 0;                   // Records the key is checked against
+    size_t validSamples = 0;              // Of those, the ones that decrypt to a valid line
+    DesModes::Mode mode = DesModes::Mode::ECB;                 // Mode of the file
+    DesBitslice::Engine engine = DesBitslice::Engine::Scalar;  // Engine used
+    unsigned int threads = 0;             // Worker threads used
+    bool exhausted = false;               // Every key was tested
+    uint64_t total = 0;                   // Keys in the keyspace
+    uint64_t resumedFrom = 0;             // First key of this run, 0 without a checkpoint
+    uint64_t nextIndex = 0;               // Where a resumed search would start
+    uint64_t tested = 0;                  // Keys tested in this run
+    uint64_t candidates = 0;              // Keys that passed the one-block check
+    double seconds = 0;                   // Time of this run
+    double keysPerSecond = 0;             // Keys tested per second in this run
+  };
+
+  /**
+   * @brief Searches the key of a file written by FileProtector::CifrarDES in any mode.
+   * @param path The encrypted file.
+   * @param keyspace Keys to try.
+   * @param options Search settings.
+   * @param result Receives the key, or how far the search went.
+   * @param error Receives the reason when the search cannot run.
+   * @return False if the file has no usable record, the keyspace is empty or the
+   *         checkpoint belongs to another search; not finding the key is not a failure.
+   */
+  static bool
+  searchFile(const std::string& path, const Keyspace& keyspace, const Options& options,
+             Result& result, std::string* error = nullptr) {
+    result = Result();
+    MappedFile archivo;
+    if (!archivo.open(path)) {
+      return fail(error, "Cannot open " + path);
+    }
+    Target objetivo;
+    if (!loadTarget(std::string_view(archivo.data(), archivo.size()), options.crib, objetivo, error)) {
+      return false;
+    }
+    return search(objetivo, keyspace, options, result, error);
+  }
+
+  /**
+   * @brief 64-bit value of a key, as DES::keyFromString returns it: character i, with its
+   *        bits in reverse order, is byte i.
+   */
+  static uint64_t
+  keyValue(const std::string& key) {
+    uint64_t valor = 0;
+    for (size_t i = 0; i < KEY_SIZE && i < key.size(); ++i) {
+      uint8_t c = static_cast<uint8_t>(key[i]);
+      uint8_t invertido = 0;
+      for (int j = 0; j < 8; ++j) {
+        invertido |= ((c >> j) & 1) << (7 - j);
+      }
+      valor |= static_cast<uint64_t>(invertido) << (8 * i);
+    }
+    return valor;
+  }
+
+private:
+  // Claves por porcion de trabajo: unos milisegundos, para repartir y parar a tiempo
+  static constexpr uint64_t CHUNK_KEYS = 1 << 20;
+
+  // Claves que se preparan y prueban juntas dentro de una porcion
+  static constexpr size_t BATCH_KEYS = 4096;
+
+  // Registros del archivo con los que se confirma una clave
+  static constexpr size_t SAMPLE_RECORDS = 32;
+
+  // Fraccion de registros de muestra que la clave debe descifrar bien: 3/4. Una linea ECB
+  // cortada por un salto de linea dentro del cifrado no se descifra con ninguna clave, y
+  // las claves casi correctas no pasan de un tercio
+  static constexpr size_t MIN_VALID_NUMERATOR = 3;
+  static constexpr size_t MIN_VALID_DENOMINATOR = 4;
+
+  // Primera linea de un archivo de punto de control
+  static constexpr const char* CHECKPOINT_HEADER = "#VGS-DES-SEARCH";
+
+  /**
+   * @brief One encrypted record of the file.
+   */
+  struct
+  Sample {
+    uint64_t iv = 0;         // IV of the record, CBC and CTR only
+    std::string cipher;      // Ciphertext of the record
+  };
+
+  /**
+   * @brief What every key is tested against.
+   */
+  struct
+  Target {
+    DesModes::Mode mode = DesModes::Mode::ECB;
+    std::vector<Sample> samples;   // Records a key must decrypt; the first holds the block tested
+    uint64_t block = 0;            // Block run through the cipher under each key
+    bool decrypt = true;           // Decrypted in ECB and CBC, encrypted as a counter in CTR
+    uint64_t flip[64] = {};        // Per output bit: all ones where the XOR with the IV, the
+                                   // ciphertext or the crib inverts it
+    int cribBytes = 0;             // Leading bytes of the block that must equal the crib
+    std::string crib;              // Known beginning of the record
+    std::string id;                // Mode and block, to match checkpoints with files
+  };
+
+  static bool
+  fail(std::string* error, const std::string& reason) {
+    if (error != nullptr) {
+      *error = reason;
+    }
+    return false;
+  }
+
+  /**
+   * @brief Picks the sample records of a file and the block tested.
+   */
+  static bool
+  loadTarget(std::string_view data, const std::string& crib, Target& target, std::string* error) {
+    std::vector<std::string_view> lineas;
+    RecordParser::forEachLine(data.data(), data.size(), [&lineas](const char* linea, size_t longitud) {
+      if (longitud > 0) {
+        lineas.emplace_back(linea, longitud);
+      }
+    }, RecordParser::LineEnding::Encrypted);
+    if (!lineas.empty() && !DesModes::parseHeader(lineas.front(), target.mode)) {
+      return fail(error, "Unknown DES mode in the header");
+    }
+    if (target.mode != DesModes::Mode::ECB) {
+      lineas.erase(lineas.begin());
+    }
+
+    // El bloque probado tiene que ser texto completo: registros de al menos dos bloques
+    for (std::string_view linea : lineas) {
+      Sample muestra;
+      if (target.mode == DesModes::Mode::ECB) {
+        // Una linea ECB partida por un salto dentro del cifrado no es multiplo de 8
+        if (linea.size() % 8 != 0) {
+          continue;
+        }
+        muestra.cipher = std::string(linea);
+      }
+      else if (!DesModes::splitLine(linea, muestra.iv, muestra.cipher, target.mode, nullptr)) {
+        continue;
+      }
+      if (muestra.cipher.size() >= 16) {
+        target.samples.push_back(std::move(muestra));
+        if (target.samples.size() == SAMPLE_RECORDS) {
+          break;
+        }
+      }
+    }
+    if (target.samples.empty()) {
+      return fail(error, "The file has no record of two DES blocks or more");
+    }
+
+    // En CTR se cifra el contador y la salida se combina con el cifrado; en ECB y CBC se
+    // descifra el bloque y en CBC la salida se combina con el IV
+    const Sample& primera = target.samples.front();
+    uint64_t cifrado = DesCore::load(primera.cipher.data(), 8);
+    uint64_t combinar = 0;
+    target.block = cifrado;
+    if (target.mode == DesModes::Mode::CBC) {
+      combinar = primera.iv;
+    }
+    else if (target.mode == DesModes::Mode::CTR) {
+      target.block = primera.iv;
+      target.decrypt = false;
+      combinar = cifrado;
+    }
+    target.crib = crib;
+    target.cribBytes = static_cast<int>(std::min<size_t>(8, crib.size()));
+    uint64_t esperado = DesCore::load(crib.data(), target.cribBytes);
+    for (int b = 0; b < 64; ++b) {
+      uint64_t bit = (combinar >> b) & 1;
+      // Los bits de los bytes conocidos se comparan con el crib
+      if (63 - b < 8 * target.cribBytes) {
+        bit ^= (esperado >> b) & 1;
+      }
+      target.flip[b] = bit != 0 ? ~0ull : 0;
+    }
+
+    char bloques[16];
+    DesCore::store(target.block, bloques);
+    DesCore::store(combinar, bloques + 8);
+    target.id = std::string(DesModes::name(target.mode)) + " " + HexCodec::encode(std::string_view(bloques, 16));
+    return true;
+  }
+
+  /**
+   * @brief Decrypts a sample record with a key.
+   * @return False if the CBC padding is not valid.
+   */
+  static bool
+  decryptSample(const DesCore& des, DesModes::Mode mode, const Sample& sample, std::string& plain) {
+    plain.resize(sample.cipher.size());
+    size_t bloques = (sample.cipher.size() + 7) / 8;
+    uint64_t anterior = sample.iv;
+    for (size_t b = 0; b < bloques; ++b) {
+      size_t desde = b * 8;
+      size_t n = std::min<size_t>(8, sample.cipher.size() - desde);
+      uint64_t cifrado = DesCore::load(sample.cipher.data() + desde, n);
+      uint64_t claro = 0;
+      if (mode == DesModes::Mode::CTR) {
+        claro = des.encrypt(sample.iv + b) ^ cifrado;
+      }
+      else {
+        claro = des.decrypt(cifrado) ^ (mode == DesModes::Mode::CBC ? anterior : 0);
+        anterior = cifrado;
+      }
+      char bytes[8];
+      DesCore::store(claro, bytes);
+      std::memcpy(&plain[desde], bytes, n);
+    }
+    if (mode == DesModes::Mode::CBC) {
+      return DesModes::removePadding(plain);
+    }
+    if (mode == DesModes::Mode::ECB) {
+      // El relleno ECB son espacios, como quita DescifrarDES
+      size_t fin = plain.find_last_not_of(' ');
+      plain.resize(fin == std::string::npos ? 0 : fin + 1);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Number of sample records a key decrypts to valid lines, 0 unless the first one
+   *        is valid and starts with the crib.
+   * @param plain Scratch space for the records.
+   */
+  static size_t
+  validSamples(const Target& target, const DesCore& des, std::string& plain) {
+    size_t validos = 0;
+    for (size_t s = 0; s < target.samples.size(); ++s) {
+      if (decryptSample(des, target.mode, target.samples[s], plain) &&
+          validRecord(plain, s == 0 ? target.crib : std::string())) {
+        validos++;
+      }
+      else if (s == 0) {
+        return 0;
+      }
+    }
+    return validos;
+  }
+
+  /**
+   * @brief True if a key decrypts enough sample records to valid lines.
+   */
+  static bool
+  confirm(const Target& target, const DesCore& des, std::string& plain) {
+    size_t validos = validSamples(target, des, plain);
+    return validos > 0 && validos * MIN_VALID_DENOMINATOR >= target.samples.size() * MIN_VALID_NUMERATOR;
+  }
+
+  /**
+   * @brief Printable user:password:others line that starts with the crib.
+   */
+  static bool
+  validRecord(const std::string& plain, const std::string& crib) {
+    for (char c : plain) {
+      if (c < 0x20 || c > 0x7E) {
+        return false;
+      }
+    }
+    RecordSpan registro;
+    return plain.compare(0, crib.size(), crib) == 0 &&
+           RecordParser::parseLine(plain.data(), 0, plain.size(), registro);
+  }
+
+  /**
+   * @brief Reads a checkpoint of the same file and keyspace.
+   * @return False if the file exists but belongs to another search.
+   */
+  static bool
+  readCheckpoint(const std::string& path, const Target& target, const Keyspace& keyspace,
+                 uint64_t& next, std::string* error) {
+    next = 0;
+    std::ifstream entrada(path);
+    if (!entrada.is_open()) {
+      return true;
+    }
+    std::string linea;
+    std::map<std::string, std::string> campos;
+    std::getline(entrada, linea);
+    if (linea != CHECKPOINT_HEADER) {
+      return fail(error, path + " is not a DES search checkpoint");
+    }
+    while (std::getline(entrada, linea)) {
+      size_t espacio = linea.find(' ');
+      if (espacio != std::string::npos) {
+        campos[linea.substr(0, espacio)] = linea.substr(espacio + 1);
+      }
+    }
+    if (campos["target"] != target.id || campos["keyspace"] != keyspace.description() ||
+        campos["size"] != std::to_string(keyspace.size())) {
+      return fail(error, path + " belongs to a search of another file or keyspace");
+    }
+    next = std::strtoull(campos["next"].c_str(), nullptr, 10);
+    if (next > keyspace.size()) {
+      return fail(error, path + " points past the end of the keyspace");
+    }
+    return true;
+  }
+
+  /**
+   * @brief Writes a checkpoint through a temporary file, so a crash never leaves half of one.
+   */
+  static void
+  writeCheckpoint(const std::string& path, const Target& target, const Keyspace& keyspace,
+                  uint64_t next, const std::string& found) {
+    std::string temporal = path + ".tmp";
+    {
+      std::ofstream salida(temporal, std::ios::trunc);
+      if (!salida.is_open()) {
+        return;
+      }
+      salida << CHECKPOINT_HEADER << '\n'
+             << "target " << target.id << '\n'
+             << "keyspace " << keyspace.description() << '\n'
+             << "size " << keyspace.size() << '\n'
+             << "next " << next << '\n';
+      if (!found.empty()) {
+        salida << "found " << found << '\n';
+      }
+    }
+    std::remove(path.c_str());
+    std::rename(temporal.c_str(), path.c_str());
+  }
+
+  /**
+   * @brief Runs the workers over the keyspace, with progress and checkpoints.
+   */
+  static bool
+  search(const Target& target, const Keyspace& keyspace, const Options& options,
+         Result& result, std::string* error) {
+    if (keyspace.size() == 0) {
+      return fail(error, keyspace.error().empty() ? "Empty keyspace" : keyspace.error());
+    }
+    uint64_t inicio = 0;
+    if (!options.checkpointPath.empty() &&
+        !readCheckpoint(options.checkpointPath, target, keyspace, inicio, error)) {
+      return false;
+    }
+
+    const uint64_t total = keyspace.size();
+    const uint64_t porciones = (total + CHUNK_KEYS - 1) / CHUNK_KEYS;
+    unsigned int hilos = options.threads != 0 ? options.threads : ThreadPool::defaultThreads();
+    // Un punto de control siempre cae al comienzo de una porcion o al final de las claves
+    const uint64_t primera = (inicio + CHUNK_KEYS - 1) / CHUNK_KEYS;
+    hilos = static_cast<unsigned int>(std::max<uint64_t>(1, std::min<uint64_t>(hilos, porciones - primera)));
+    result.mode = target.mode;
+    result.engine = DesBitslice::supported(options.engine);
+    if (result.engine == DesBitslice::Engine::Scalar) {
+      result.engine = DesBitslice::Engine::Bitslice64;
+    }
+    result.threads = hilos;
+    result.total = total;
+    result.resumedFrom = inicio;
+
+    // Estado compartido; las porciones terminadas fuera de orden esperan en terminadas
+    std::mutex mutex;
+    std::condition_variable aviso;
+    std::atomic<uint64_t> siguiente(primera);
+    std::atomic<bool> parar(false);
+    std::atomic<uint64_t> probadas(0);
+    std::atomic<uint64_t> candidatas(0);
+    uint64_t hecho = primera;
+    std::set<uint64_t> terminadas;
+    unsigned int activos = hilos;
+    uint64_t indiceEncontrado = std::numeric_limits<uint64_t>::max();
+
+    auto trabajar = [&]() {
+      std::vector<uint64_t> claves(BATCH_KEYS);
+      std::string claro;
+      while (!parar.load(std::memory_order_relaxed)) {
+        uint64_t porcion = siguiente.fetch_add(1);
+        if (porcion >= porciones) {
+          break;
+        }
+        uint64_t desde = porcion * CHUNK_KEYS;
+        uint64_t hasta = std::min(total, desde + CHUNK_KEYS);
+        for (uint64_t lote = desde; lote < hasta; lote += BATCH_KEYS) {
+          size_t n = static_cast<size_t>(std::min<uint64_t>(BATCH_KEYS, hasta - lote));
+          keyspace.values(lote, n, claves.data());
+          DesBitslice::searchKeys(target.block, target.decrypt, claves.data(), n,
+                                  [&target](const auto* bits, auto& keep) { oneBlockTest(target, bits, keep); },
+                                  [&](size_t i) {
+            candidatas.fetch_add(1, std::memory_order_relaxed);
+            if (confirm(target, DesCore(claves[i]), claro)) {
+              std::lock_guard<std::mutex> lock(mutex);
+              indiceEncontrado = std::min(indiceEncontrado, lote + i);
+              parar = true;
+            }
+          }, options.engine);
+          probadas.fetch_add(n, std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        terminadas.insert(porcion);
+        while (!terminadas.empty() && *terminadas.begin() == hecho) {
+          terminadas.erase(terminadas.begin());
+          hecho++;
+        }
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      activos--;
+      aviso.notify_all();
+    };
+
+    auto comienzo = std::chrono::steady_clock::now();
+    auto segundosDesde = [&comienzo]() {
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - comienzo).count();
+    };
+    {
+      ThreadPool pool(hilos);
+      for (unsigned int h = 0; h < hilos; ++h) {
+        pool.submit(trabajar);
+      }
+
+      double proximoReporte = options.progressSeconds;
+      double proximoGuardado = options.checkpointSeconds;
+      std::unique_lock<std::mutex> lock(mutex);
+      while (activos > 0) {
+        double espera = std::min(proximoReporte, proximoGuardado);
+        if (options.timeLimit > 0) {
+          espera = std::min(espera, options.timeLimit);
+        }
+        aviso.wait_for(lock, std::chrono::duration<double>(std::max(0.0, espera - segundosDesde())));
+        double ahora = segundosDesde();
+        if (options.timeLimit > 0 && ahora >= options.timeLimit) {
+          parar = true;
+        }
+        if (ahora >= proximoGuardado) {
+          proximoGuardado = ahora + options.checkpointSeconds;
+          if (!options.checkpointPath.empty()) {
+            writeCheckpoint(options.checkpointPath, target, keyspace,
+                            std::min(total, hecho * CHUNK_KEYS), std::string());
+          }
+        }
+        if (ahora >= proximoReporte) {
+          proximoReporte = ahora + options.progressSeconds;
+          if (options.onProgress) {
+            Progress avance;
+            avance.done = std::min(total, hecho * CHUNK_KEYS);
+            avance.total = total;
+            avance.seconds = ahora;
+            avance.keysPerSecond = ahora > 0 ? probadas.load() / ahora : 0;
+            avance.remainingSeconds = avance.keysPerSecond > 0
+                                    ? (total - avance.done) / avance.keysPerSecond : 0;
+            // El aviso se hace sin el candado para no frenar a los hilos
+            lock.unlock();
+            options.onProgress(avance);
+            lock.lock();
+          }
+        }
+      }
+    }
+
+    result.seconds = segundosDesde();
+    result.tested = probadas.load();
+    result.candidates = candidatas.load();
+    result.keysPerSecond = result.seconds > 0 ? result.tested / result.seconds : 0;
+    result.nextIndex = std::min(total, hecho * CHUNK_KEYS);
+    result.exhausted = result.nextIndex == total;
+    if (indiceEncontrado != std::numeric_limits<uint64_t>::max()) {
+      result.found = true;
+      result.key = keyspace.key(indiceEncontrado);
+      result.equivalents = keyspace.equivalents(result.key);
+      // Al retomar se vuelve a la porcion de la clave, que se encuentra enseguida
+      result.nextIndex = indiceEncontrado / CHUNK_KEYS * CHUNK_KEYS;
+      result.exhausted = false;
+      DesCore des(keyValue(result.key));
+      result.samples = target.samples.size();
+      result.validSamples = validSamples(target, des, result.plaintext);
+      decryptSample(des, target.mode, target.samples.front(), result.plaintext);
+    }
+    if (!options.checkpointPath.empty()) {
+      writeCheckpoint(options.checkpointPath, target, keyspace, result.nextIndex, result.key);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Keeps the lanes whose output block is printable and starts with the crib.
+   * @details Byte i of the block, the character i of the record, is bits 63 - 8i down to
+   *          56 - 8i. A printable character has bit 7 clear, bit 6 or bit 5 set and is
+   *          not 0x7F.
+   */
+  template<typename V>
+  static void
+  oneBlockTest(const Target& target, const V* bits, V& keep) {
+    V pasan = V::broadcast(~0ull);
+    for (int i = 0; i < 8; ++i) {
+      const int base = 56 - 8 * i;
+      V p[8];
+      for (int j = 0; j < 8; ++j) {
+        p[j] = bits[base + j] ^ V::broadcast(target.flip[base + j]);
+      }
+      if (i < target.cribBytes) {
+        // Con el crib ya aplicado, un byte conocido tiene que quedar en cero
+        pasan = V::andNot(p[0] | p[1] | p[2] | p[3] | p[4] | p[5] | p[6] | p[7], pasan);
+      }
+      else {
+        pasan = V::andNot(p[7], pasan) & (p[6] | p[5]);
+        pasan = V::andNot(p[0] & p[1] & p[2] & p[3] & p[4] & p[5] & p[6], pasan);
+      }
+    }
+    keep = pasan;
+  }
+};
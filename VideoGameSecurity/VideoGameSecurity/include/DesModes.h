@@ -0,0 +1,416 @@
+#pragma once
+#include "Prerequisites.h"
+#include "DES.h"
+#include "DesCore.h"
+#include "DesBitslice.h"
+#include "HexCodec.h"
+#include "ThreadPool.h"
+
+/**
+ * @brief CBC and CTR block modes of DES for record files.
+ * @details Every record gets its own random 8-byte IV and is written as one line of hex:
+ *          the IV followed by the ciphertext, so lines stay independent and the ciphertext
+ *          can never contain a line break.
+ *
+ *          CTR encrypts the counters IV, IV + 1, ... and XORs them with the record, so
+ *          the ciphertext has the length of the plaintext and needs no padding. Block b of
+ *          a record depends only on IV + b: ctr() starts at any byte offset, and the
+ *          counters of every record of a file are encrypted together as independent blocks.
+ *          CBC XORs each plaintext block with the previous ciphertext block (the IV for the
+ *          first) before encrypting it, with PKCS#7 padding: the record is completed with
+ *          n bytes of value n, 1 to 8, so the padding is always removed exactly. Encrypting
+ *          is sequential within a record, but decrypting is not, since every block is
+ *          decrypted on its own and then XORed with the ciphertext block before it.
+ *
+ *          The independent blocks, counters in CTR and ciphertext in CBC decryption, are
+ *          split across the ThreadPool and encrypted by DesBitslice in each task.
+ */
+class
+DesModes {
+public:
+  /**
+   * @brief Chaining of the blocks.
+   */
+  enum class Mode {
+    ECB,   // Each block on its own, padded with spaces; the original CifrarDES format
+    CBC,   // Cipher block chaining with PKCS#7 padding
+    CTR    // Counter mode, no padding
+  };
+
+  // Primera palabra de la cabecera de los archivos CBC y CTR; los ECB no tienen cabecera
+  static constexpr const char* HEADER = "#VGS-DES";
+
+  /**
+   * @brief Prepares a key.
+   * @param key The 8-character DES key.
+   * @param threads Worker threads for the independent blocks, 0 for one per core.
+   */
+  explicit DesModes(const std::string& key, unsigned int threads = 0)
+    : m_core(DES::keyFromString(key).to_ullong()),
+      m_bulk(DES::keyFromString(key).to_ullong()),
+      m_threads(threads != 0 ? threads : ThreadPool::defaultThreads()) {
+  }
+
+  /**
+   * @brief Name of a mode, as written in the file header.
+   */
+  static const char*
+  name(Mode mode) {
+    switch (mode) {
+    case Mode::CBC: return "CBC";
+    case Mode::CTR: return "CTR";
+    default:        return "ECB";
+    }
+  }
+
+  /**
+   * @brief Header line of a CBC or CTR file, without the line break.
+   */
+  static std::string
+  header(Mode mode) {
+    return std::string(HEADER) + " " + name(mode);
+  }
+
+  /**
+   * @brief Reads the mode from the first line of a file.
+   * @param firstLine The first line.
+   * @param mode Receives the mode; ECB when the line is not a header.
+   * @return False if the line is a header with an unknown mode.
+   */
+  static bool
+  parseHeader(std::string_view firstLine, Mode& mode) {
+    mode = Mode::ECB;
+    std::string_view prefijo(HEADER);
+    if (firstLine.substr(0, prefijo.size()) != prefijo) {
+      return true;
+    }
+    std::string_view resto = firstLine.substr(prefijo.size());
+    if (resto == " CBC") {
+      mode = Mode::CBC;
+      return true;
+    }
+    if (resto == " CTR") {
+      mode = Mode::CTR;
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * @brief Encrypts or decrypts bytes of a CTR stream from any position.
+   * @details Only the counters of the blocks touched are encrypted; nothing before offset
+   *          is processed.
+   * @param iv The IV of the record.
+   * @param offset Position of in[0] in the record, in bytes.
+   * @param in Source bytes.
+   * @param out Destination; may be the same as in.
+   * @param size Number of bytes.
+   */
+  void
+  ctr(uint64_t iv, uint64_t offset, const uint8_t* in, uint8_t* out, size_t size) const {
+    uint64_t bloque = offset / 8;
+    size_t desplazamiento = static_cast<size_t>(offset % 8);
+    char flujo[8];
+    for (size_t i = 0; i < size; ) {
+      DesCore::store(m_core.encrypt(iv + bloque), flujo);
+      for (size_t j = desplazamiento; j < 8 && i < size; ++j, ++i) {
+        out[i] = static_cast<uint8_t>(in[i] ^ static_cast<uint8_t>(flujo[j]));
+      }
+      desplazamiento = 0;
+      bloque++;
+    }
+  }
+
+  /**
+   * @brief Encrypts one record in CBC mode.
+   * @param iv The IV of the record.
+   * @param plain The record.
+   * @param out Receives the ciphertext, the record length rounded up to the next multiple
+   *            of 8 (a whole block more when it already was one).
+   */
+  void
+  cbcEncrypt(uint64_t iv, std::string_view plain, std::vector<uint8_t>& out) const {
+    size_t numBloques = plain.size() / 8 + 1;
+    out.resize(numBloques * 8);
+    uint64_t anterior = iv;
+    for (size_t b = 0; b < numBloques; ++b) {
+      char bloque[8];
+      size_t desde = b * 8;
+      size_t copiar = desde < plain.size() ? std::min<size_t>(8, plain.size() - desde) : 0;
+      std::memcpy(bloque, plain.data() + desde, copiar);
+      // PKCS#7: n bytes de valor n al final
+      std::memset(bloque + copiar, static_cast<int>(numBloques * 8 - plain.size()), 8 - copiar);
+      anterior = m_core.encrypt(DesCore::load(bloque, 8) ^ anterior);
+      DesCore::store(anterior, reinterpret_cast<char*>(out.data() + desde));
+    }
+  }
+
+  /**
+   * @brief Encrypts records into lines of hex, IV first.
+   * @param mode CBC or CTR.
+   * @param records The plain records.
+   * @param ivs One IV per record.
+   * @param lines Receives one line per record, without line breaks.
+   */
+  void
+  encryptRecords(Mode mode, const std::vector<std::string_view>& records,
+                 const std::vector<uint64_t>& ivs, std::vector<std::string>& lines) const {
+    lines.assign(records.size(), std::string());
+    if (mode == Mode::CBC) {
+      // Cada registro es una cadena propia: se reparten registros, no bloques
+      runParallel(records.size(), MIN_RECORDS_PER_TASK, [&](size_t desde, size_t hasta) {
+        std::vector<uint8_t> cifrado;
+        for (size_t r = desde; r < hasta; ++r) {
+          cbcEncrypt(ivs[r], records[r], cifrado);
+          lines[r] = hexLine(ivs[r], cifrado.data(), cifrado.size());
+        }
+      });
+      return;
+    }
+
+    std::vector<size_t> primerBloque;
+    std::vector<uint64_t> flujo;
+    keystream(records, ivs, primerBloque, flujo);
+    runParallel(records.size(), MIN_RECORDS_PER_TASK, [&](size_t desde, size_t hasta) {
+      std::vector<uint8_t> cifrado;
+      for (size_t r = desde; r < hasta; ++r) {
+        cifrado.resize(records[r].size());
+        applyKeystream(reinterpret_cast<const uint8_t*>(records[r].data()), cifrado.data(),
+                       records[r].size(), flujo.data() + primerBloque[r]);
+        lines[r] = hexLine(ivs[r], cifrado.data(), cifrado.size());
+      }
+    });
+  }
+
+  /**
+   * @brief Decrypts lines written by encryptRecords.
+   * @param mode CBC or CTR.
+   * @param lines The lines of hex, without the header.
+   * @param records Receives one plain record per line.
+   * @param error Receives the reason when a line is not valid.
+   * @return False if a line is not hex, is too short or has bad CBC padding.
+   */
+  bool
+  decryptRecords(Mode mode, const std::vector<std::string_view>& lines,
+                 std::vector<std::string>& records, std::string* error = nullptr) const {
+    records.assign(lines.size(), std::string());
+    std::vector<uint64_t> ivs(lines.size());
+    std::vector<std::string_view> cifrados(lines.size());
+    for (size_t r = 0; r < lines.size(); ++r) {
+      if (!splitLine(lines[r], ivs[r], records[r], mode, error)) {
+        if (error != nullptr) {
+          *error = "Line " + std::to_string(r + 1) + ": " + *error;
+        }
+        return false;
+      }
+      cifrados[r] = records[r];
+    }
+
+    if (mode == Mode::CTR) {
+      std::vector<size_t> primerBloque;
+      std::vector<uint64_t> flujo;
+      keystream(cifrados, ivs, primerBloque, flujo);
+      runParallel(records.size(), MIN_RECORDS_PER_TASK, [&](size_t desde, size_t hasta) {
+        for (size_t r = desde; r < hasta; ++r) {
+          uint8_t* datos = reinterpret_cast<uint8_t*>(&records[r][0]);
+          applyKeystream(datos, datos, records[r].size(), flujo.data() + primerBloque[r]);
+        }
+      });
+      return true;
+    }
+
+    // CBC: todos los bloques cifrados de todos los registros se descifran juntos
+    std::vector<size_t> primerBloque(records.size() + 1, 0);
+    for (size_t r = 0; r < records.size(); ++r) {
+      primerBloque[r + 1] = primerBloque[r] + records[r].size() / 8;
+    }
+    std::vector<uint64_t> bloques(primerBloque.back());
+    for (size_t r = 0; r < records.size(); ++r) {
+      for (size_t b = 0; b < records[r].size() / 8; ++b) {
+        bloques[primerBloque[r] + b] = DesCore::load(records[r].data() + b * 8, 8);
+      }
+    }
+    std::vector<uint64_t> descifrados(bloques.size());
+    cryptParallel(bloques.data(), descifrados.data(), bloques.size(), true);
+
+    std::vector<char> malRelleno(records.size(), 0);
+    runParallel(records.size(), MIN_RECORDS_PER_TASK, [&](size_t desde, size_t hasta) {
+      for (size_t r = desde; r < hasta; ++r) {
+        size_t n = records[r].size() / 8;
+        for (size_t b = 0; b < n; ++b) {
+          uint64_t anterior = b == 0 ? ivs[r] : bloques[primerBloque[r] + b - 1];
+          DesCore::store(descifrados[primerBloque[r] + b] ^ anterior, &records[r][b * 8]);
+        }
+        malRelleno[r] = !removePadding(records[r]);
+      }
+    });
+    for (size_t r = 0; r < records.size(); ++r) {
+      if (malRelleno[r]) {
+        if (error != nullptr) {
+          *error = "Line " + std::to_string(r + 1) + ": invalid CBC padding (wrong key?)";
+        }
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Decodes the IV and the ciphertext of a line written by encryptRecords.
+   * @param line The line of hex.
+   * @param iv Receives the IV.
+   * @param data Receives the ciphertext.
+   * @param mode CBC or CTR; CBC requires whole blocks.
+   * @param error Receives the reason when the line is not valid.
+   */
+  static bool
+  splitLine(std::string_view line, uint64_t& iv, std::string& data, Mode mode, std::string* error) {
+    if (line.size() < 16) {
+      if (error != nullptr) {
+        *error = "shorter than an IV";
+      }
+      return false;
+    }
+    uint8_t vector[8];
+    if (!HexCodec::decodePacked(line.data(), 16, vector, error)) {
+      return false;
+    }
+    iv = DesCore::load(reinterpret_cast<const char*>(vector), 8);
+    data.resize((line.size() - 16) / 2);
+    if (!HexCodec::decodePacked(line.data() + 16, line.size() - 16,
+                                reinterpret_cast<uint8_t*>(&data[0]), error)) {
+      return false;
+    }
+    if (mode == Mode::CBC && (data.empty() || data.size() % 8 != 0)) {
+      if (error != nullptr) {
+        *error = "CBC ciphertext is not a whole number of blocks";
+      }
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Removes PKCS#7 padding.
+   * @return False if the last bytes are not valid padding.
+   */
+  static bool
+  removePadding(std::string& record) {
+    if (record.empty()) {
+      return false;
+    }
+    size_t n = static_cast<unsigned char>(record.back());
+    if (n == 0 || n > 8 || n > record.size()) {
+      return false;
+    }
+    for (size_t i = record.size() - n; i < record.size(); ++i) {
+      if (static_cast<unsigned char>(record[i]) != n) {
+        return false;
+      }
+    }
+    record.resize(record.size() - n);
+    return true;
+  }
+
+private:
+  // Bloques minimos por tarea para que repartir compense
+  static constexpr size_t MIN_BLOCKS_PER_TASK = 8192;
+
+  // Registros minimos por tarea en los pasos que recorren registros
+  static constexpr size_t MIN_RECORDS_PER_TASK = 2048;
+
+  /**
+   * @brief Splits [0, count) into up to m_threads ranges and runs them on a ThreadPool.
+   */
+  template<typename Task>
+  void
+  runParallel(size_t count, size_t minPerTask, Task&& task) const {
+    size_t partes = std::min<size_t>(m_threads, std::max<size_t>(1, count / minPerTask));
+    if (partes <= 1) {
+      task(size_t(0), count);
+      return;
+    }
+    ThreadPool pool(static_cast<unsigned int>(partes));
+    std::vector<std::future<void>> futuros;
+    size_t tamParte = (count + partes - 1) / partes;
+    for (size_t desde = 0; desde < count; desde += tamParte) {
+      size_t hasta = std::min(count, desde + tamParte);
+      futuros.push_back(pool.submit([&task, desde, hasta]() { task(desde, hasta); }));
+    }
+    for (auto& futuro : futuros) {
+      futuro.get();
+    }
+  }
+
+  /**
+   * @brief Encrypts or decrypts independent blocks on every thread.
+   */
+  void
+  cryptParallel(const uint64_t* in, uint64_t* out, size_t count, bool decrypt) const {
+    runParallel(count, MIN_BLOCKS_PER_TASK, [&](size_t desde, size_t hasta) {
+      if (decrypt) {
+        m_bulk.decryptBlocks(in + desde, out + desde, hasta - desde);
+      }
+      else {
+        m_bulk.encryptBlocks(in + desde, out + desde, hasta - desde);
+      }
+    });
+  }
+
+  /**
+   * @brief Encrypted counters of every block of every record.
+   * @param records The records, plain or encrypted; only their lengths matter.
+   * @param ivs One IV per record.
+   * @param firstBlock Receives the index of the first block of each record in stream.
+   * @param stream Receives the keystream blocks.
+   */
+  void
+  keystream(const std::vector<std::string_view>& records, const std::vector<uint64_t>& ivs,
+            std::vector<size_t>& firstBlock, std::vector<uint64_t>& stream) const {
+    firstBlock.resize(records.size());
+    size_t total = 0;
+    for (size_t r = 0; r < records.size(); ++r) {
+      firstBlock[r] = total;
+      total += (records[r].size() + 7) / 8;
+    }
+    stream.resize(total);
+    for (size_t r = 0; r < records.size(); ++r) {
+      size_t n = (records[r].size() + 7) / 8;
+      for (size_t b = 0; b < n; ++b) {
+        stream[firstBlock[r] + b] = ivs[r] + b;
+      }
+    }
+    cryptParallel(stream.data(), stream.data(), stream.size(), false);
+  }
+
+  /**
+   * @brief XORs bytes with keystream blocks, first byte of each block first.
+   */
+  static void
+  applyKeystream(const uint8_t* in, uint8_t* out, size_t size, const uint64_t* stream) {
+    for (size_t i = 0; i < size; i += 8) {
+      char flujo[8];
+      DesCore::store(stream[i / 8], flujo);
+      for (size_t j = 0; j < 8 && i + j < size; ++j) {
+        out[i + j] = static_cast<uint8_t>(in[i + j] ^ static_cast<uint8_t>(flujo[j]));
+      }
+    }
+  }
+
+  /**
+   * @brief Line of hex: the IV, then the ciphertext.
+   */
+  static std::string
+  hexLine(uint64_t iv, const uint8_t* data, size_t size) {
+    std::string linea(16 + 2 * size, '\0');
+    uint8_t vector[8];
+    DesCore::store(iv, reinterpret_cast<char*>(vector));
+    HexCodec::encodeInto(vector, 8, &linea[0]);
+    HexCodec::encodeInto(data, size, &linea[16]);
+    return linea;
+  }
+
+  DesCore m_core;          // Sequential CBC encryption and random access CTR
+  DesBitslice m_bulk;      // Independent blocks in bulk
+  unsigned int m_threads;  // Worker threads for the independent blocks
+};
@@ -0,0 +1,164 @@
+#pragma once
+#include "Prerequisites.h"
+#include "RecordCipher.h"
+#include "SipHash.h"
+#include "ThreadPool.h"
+#include "FolderWatcher.h"
+
+/**
+ * @brief Watches a folder and encrypts every new or rewritten file into another folder.
+ * @details The files already present at start-up are processed first; after that the
+ *          FolderWatcher reports each file as soon as it is written. Files are encrypted
+ *          concurrently on a ThreadPool, one file per task. Each file is read in blocks,
+ *          so a worker holds one block and one line of it whatever the size of the file,
+ *          and gets the same record filter and output as FileProtector::CifrarStream.
+ *
+ *          A keyed SipHash of the content of every encrypted file is kept in a state file
+ *          inside the target folder. A file whose content still has the same hash and whose
+ *          encrypted copy exists is skipped, also across restarts. The hash key is derived
+ *          from the cipher and its key, so changing either re-encrypts everything.
+ */
+class
+EncryptionDaemon {
+public:
+  /**
+   * @brief Daemon settings.
+   */
+  struct
+  Config {
+    std::string sourceFolder;                // Folder with the plain files
+    std::string targetFolder;                // Folder for the encrypted files
+    CipherType cipher = CipherType::XOR;     // Cipher applied to every file
+    std::string key;                         // Key of the cipher (shift for Caesar)
+    std::string extension = ".txt";          // Only files with this extension are processed
+    unsigned int workers = 0;                // Files encrypted at once, 0 = one per core
+    int waitMs = 500;                        // Maximum wait between checks of the folder
+    bool once = false;                       // Process the current files and return
+  };
+
+  /**
+   * @brief Files handled since run() started.
+   */
+  struct
+  Stats {
+    uint64_t encrypted = 0;   // Files encrypted
+    uint64_t skipped = 0;     // Files skipped because their content did not change
+    uint64_t failed = 0;      // Files that could not be read or written
+    uint64_t retried = 0;     // Reads repeated because the file changed while being read
+  };
+
+  /**
+   * @param config Settings of the daemon.
+   * @throws std::invalid_argument If the key is not valid for the cipher.
+   */
+  explicit EncryptionDaemon(const Config& config);
+
+  ~EncryptionDaemon() = default;
+
+  /**
+   * @brief Watches the source folder until requestStop() is called.
+   * @return False if the folders could not be opened.
+   */
+  bool
+  run();
+
+  /**
+   * @brief Asks every running daemon to stop after the files in progress.
+   * @details Safe to call from a signal handler.
+   */
+  static void
+  requestStop();
+
+  /**
+   * @brief Files handled so far.
+   */
+  const Stats&
+  stats() const {
+    return m_stats;
+  }
+
+  /**
+   * @brief Name of the state file kept in the target folder.
+   */
+  static constexpr const char* STATE_FILE = ".estado_daemon";
+
+  /**
+   * @brief Times a file that keeps changing is read again in once mode before it fails.
+   */
+  static constexpr int MAX_RETRIES = 5;
+
+private:
+  /**
+   * @brief Outcome of one file.
+   */
+  enum class Outcome {
+    Encrypted,
+    Skipped,
+    Failed,
+    Retry       // Changed while being read; queued again by its next change event or,
+                // in once mode, after a pause
+  };
+
+  /**
+   * @brief What a worker reports back for one file.
+   */
+  struct
+  Result {
+    std::string name;                 // File name inside the source folder
+    Outcome outcome = Outcome::Failed;
+    uint64_t hash = 0;                // Hash of the content that was read
+    uint64_t records = 0;             // Records written
+    std::string error;                // Reason of a failure
+  };
+
+  /**
+   * @brief Hashes a file and encrypts it if its content changed. Runs on a worker.
+   * @details The file is read twice in blocks with a stream rather than mapped, since a
+   *          producer may still be writing or truncating it and a mapping of a file that
+   *          shrinks faults on access. The first pass only hashes it; the second encrypts
+   *          it and hashes it again, and a different hash means the file changed between
+   *          the two.
+   * @param name File name inside the source folder.
+   * @param previousHash Hash stored for the file, 0 if none.
+   */
+  Result
+  processFile(const std::string& name, uint64_t previousHash) const;
+
+  /**
+   * @brief Queues a file unless it is already being processed.
+   */
+  void
+  launch(const std::string& name);
+
+  /**
+   * @brief Collects the finished files, reports them and queues repeated events.
+   * @param wait True to wait until every queued file is done.
+   * @return True if the state changed.
+   */
+  bool
+  collect(bool wait);
+
+  /**
+   * @brief Reads the hashes of the previous runs.
+   */
+  void
+  loadState();
+
+  /**
+   * @brief Writes the hashes to the state file through a temporary file.
+   */
+  void
+  saveState() const;
+
+  Config m_config;                                        // Settings
+  RecordCipher m_cipher;                                  // Validated cipher, copied per file
+  SipHash::Key m_hashKey;                                 // Key of the content hashes
+  std::unique_ptr<ThreadPool> m_pool;                     // Encryption workers
+  std::unordered_map<std::string, uint64_t> m_hashes;     // Last encrypted content per file
+  std::unordered_map<std::string, std::future<Result>> m_running; // Files being processed
+  std::unordered_set<std::string> m_repeat;               // Changed again while processing
+  std::unordered_map<std::string, int> m_retries;         // Reads repeated per file in once mode
+  Stats m_stats;                                          // Files handled
+
+  static std::atomic<bool> s_stop;                        // Set by requestStop()
+};
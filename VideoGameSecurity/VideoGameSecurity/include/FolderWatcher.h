@@ -0,0 +1,252 @@
+#pragma once
+#include "Prerequisites.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Reports the files of a folder that are created or rewritten.
+ * @details On Linux the folder is watched with inotify and a file is reported when the
+ *          writer closes it or when it is moved into the folder, so half-written files
+ *          are never returned. Elsewhere the folder is rescanned when the system signals
+ *          a change (FindFirstChangeNotification on Windows) or on every timeout, and a
+ *          file is reported when its size or modification time differs from the last
+ *          scan. Only regular files with the configured extension are reported.
+ */
+class
+FolderWatcher {
+public:
+  FolderWatcher() = default;
+
+  /**
+   * @brief Stops watching.
+   */
+  ~FolderWatcher() {
+    close();
+  }
+
+  FolderWatcher(const FolderWatcher&) = delete;
+  FolderWatcher& operator=(const FolderWatcher&) = delete;
+
+  /**
+   * @brief Starts watching a folder.
+   * @param folder Folder to watch.
+   * @param extension Extension of the files to report, for example ".txt"; empty for all.
+   * @return True if the folder exists and could be watched.
+   */
+  bool
+  open(const std::string& folder, const std::string& extension) {
+    close();
+    std::error_code ec;
+    if (!std::filesystem::is_directory(folder, ec)) {
+      return false;
+    }
+    m_folder = folder;
+    m_extension = extension;
+
+#if defined(_WIN32)
+    m_handle = FindFirstChangeNotificationA(folder.c_str(), FALSE,
+                                            FILE_NOTIFY_CHANGE_FILE_NAME |
+                                            FILE_NOTIFY_CHANGE_SIZE |
+                                            FILE_NOTIFY_CHANGE_LAST_WRITE);
+#elif defined(__linux__)
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd >= 0 &&
+        inotify_add_watch(m_fd, folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+      ::close(m_fd);
+      m_fd = -1;
+    }
+#endif
+    // Sin notificaciones del sistema se compara el contenido de la carpeta en cada espera
+    scan(nullptr);
+    return true;
+  }
+
+  /**
+   * @brief Stops watching the folder.
+   */
+  void
+  close() {
+#if defined(_WIN32)
+    if (m_handle != INVALID_HANDLE_VALUE) {
+      FindCloseChangeNotification(m_handle);
+      m_handle = INVALID_HANDLE_VALUE;
+    }
+#elif defined(__linux__)
+    if (m_fd >= 0) {
+      ::close(m_fd);
+      m_fd = -1;
+    }
+#endif
+    m_snapshot.clear();
+  }
+
+  /**
+   * @brief Returns the files currently in the folder.
+   * @details Used once at start-up for the files dropped while nobody was watching.
+   */
+  std::vector<std::string>
+  existing() const {
+    std::vector<std::string> names;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(m_folder, ec)) {
+      if (accepts(entry)) {
+        names.push_back(entry.path().filename().string());
+      }
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+  }
+
+  /**
+   * @brief Waits until files change or the timeout expires.
+   * @param changed Receives the names of the new or rewritten files, without duplicates.
+   * @param timeoutMs Maximum wait in milliseconds.
+   * @return True if at least one file changed.
+   */
+  bool
+  wait(std::vector<std::string>& changed, int timeoutMs) {
+    changed.clear();
+
+#if defined(__linux__)
+    if (m_fd >= 0) {
+      pollfd pfd{ m_fd, POLLIN, 0 };
+      if (poll(&pfd, 1, timeoutMs) > 0) {
+        readEvents(changed);
+      }
+      return !changed.empty();
+    }
+#elif defined(_WIN32)
+    if (m_handle != INVALID_HANDLE_VALUE) {
+      if (WaitForSingleObject(m_handle, static_cast<DWORD>(timeoutMs)) != WAIT_OBJECT_0) {
+        return false;
+      }
+      FindNextChangeNotification(m_handle);
+      scan(&changed);
+      return !changed.empty();
+    }
+#endif
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+    scan(&changed);
+    return !changed.empty();
+  }
+
+  /**
+   * @brief Returns true if the system notifies the changes instead of rescanning.
+   */
+  bool
+  usesNotifications() const {
+#if defined(_WIN32)
+    return m_handle != INVALID_HANDLE_VALUE;
+#elif defined(__linux__)
+    return m_fd >= 0;
+#else
+    return false;
+#endif
+  }
+
+private:
+  /**
+   * @brief Size and modification time seen for a file in the last scan.
+   */
+  struct
+  FileState {
+    uintmax_t size = 0;
+    std::filesystem::file_time_type time;
+  };
+
+  bool
+  accepts(const std::filesystem::directory_entry& entry) const {
+    std::error_code ec;
+    if (!entry.is_regular_file(ec)) {
+      return false;
+    }
+    return accepts(entry.path().filename().string());
+  }
+
+  bool
+  accepts(const std::string& name) const {
+    if (name.empty() || name[0] == '.') {
+      return false;
+    }
+    return m_extension.empty() ||
+           (name.size() >= m_extension.size() &&
+            name.compare(name.size() - m_extension.size(), m_extension.size(), m_extension) == 0);
+  }
+
+  /**
+   * @brief Compares the folder with the last scan.
+   * @param changed Receives the new or modified files; nullptr only updates the snapshot.
+   */
+  void
+  scan(std::vector<std::string>* changed) {
+    std::unordered_map<std::string, FileState> actual;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(m_folder, ec)) {
+      if (!accepts(entry)) {
+        continue;
+      }
+      FileState estado;
+      estado.size = entry.file_size(ec);
+      estado.time = entry.last_write_time(ec);
+      std::string nombre = entry.path().filename().string();
+
+      auto previo = m_snapshot.find(nombre);
+      if (changed != nullptr &&
+          (previo == m_snapshot.end() || previo->second.size != estado.size ||
+           previo->second.time != estado.time)) {
+        changed->push_back(nombre);
+      }
+      actual.emplace(std::move(nombre), estado);
+    }
+    m_snapshot.swap(actual);
+  }
+
+#if defined(__linux__)
+  /**
+   * @brief Drains the pending inotify events.
+   */
+  void
+  readEvents(std::vector<std::string>& changed) {
+    std::unordered_set<std::string> vistos;
+    alignas(inotify_event) char buffer[16384];
+    while (true) {
+      ssize_t leidos = read(m_fd, buffer, sizeof(buffer));
+      if (leidos <= 0) {
+        break;
+      }
+      for (char* p = buffer; p < buffer + leidos; ) {
+        const inotify_event* evento = reinterpret_cast<const inotify_event*>(p);
+        if (evento->len > 0 && (evento->mask & IN_ISDIR) == 0) {
+          std::string nombre(evento->name);
+          if (accepts(nombre) && vistos.insert(nombre).second) {
+            changed.push_back(nombre);
+          }
+        }
+        p += sizeof(inotify_event) + evento->len;
+      }
+    }
+  }
+#endif
+
+  std::string m_folder;                                   // Watched folder
+  std::string m_extension;                                // Reported extension
+  std::unordered_map<std::string, FileState> m_snapshot;  // Last scan, when rescanning
+#if defined(_WIN32)
+  HANDLE m_handle = INVALID_HANDLE_VALUE;                 // Change notification handle
+#elif defined(__linux__)
+  int m_fd = -1;                                          // inotify descriptor
+#endif
+};
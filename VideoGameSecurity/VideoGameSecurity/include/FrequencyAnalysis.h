@@ -0,0 +1,218 @@
+#pragma once
+#include "Prerequisites.h"
+
+/**
+ * @brief Letter statistics shared by the cipher-breaking tools.
+ * @details Holds the letter frequencies of English and Spanish and derives from them the
+ *          tables the crackers need: a per-byte log-likelihood for scoring candidate
+ *          plaintexts, a chi-squared distance for letter counts and a printable-byte table
+ *          for rejecting keys as soon as they produce a byte that is not text.
+ */
+class
+FrequencyAnalysis {
+public:
+  /**
+   * @brief Language of the expected plaintext.
+   */
+  enum class Language {
+    English,
+    Spanish
+  };
+
+  /**
+   * @brief Relative frequency of the letters A-Z, summing to 1.
+   */
+  static const std::array<double, 26>&
+  letterFrequencies(Language language) {
+    // Porcentajes de uso de cada letra en textos generales
+    static const std::array<double, 26> ingles = normalize({
+      8.167, 1.492, 2.782, 4.253, 12.702, 2.228, 2.015, 6.094, 6.966, 0.153, 0.772, 4.025, 2.406,
+      6.749, 7.507, 1.929, 0.095, 5.987, 6.327, 9.056, 2.758, 0.978, 2.360, 0.150, 1.974, 0.074 });
+    static const std::array<double, 26> espanol = normalize({
+      11.525, 2.215, 4.019, 5.010, 12.181, 0.692, 1.768, 0.703, 6.247, 0.493, 0.026, 4.967, 3.157,
+      7.023, 8.683, 2.510, 0.877, 6.871, 7.977, 4.632, 2.927, 1.138, 0.017, 0.215, 1.008, 0.467 });
+    return language == Language::Spanish ? espanol : ingles;
+  }
+
+  /**
+   * @brief Returns true for the bytes XOREncoder::isValidText accepts: printable ASCII and
+   *        the whitespace characters.
+   */
+  static bool
+  isPrintable(unsigned char c) {
+    return printableTable()[c];
+  }
+
+  /**
+   * @brief Table form of isPrintable, for tight loops.
+   */
+  static const std::array<bool, 256>&
+  printableTable() {
+    static const std::array<bool, 256> tabla = []() {
+      std::array<bool, 256> t{};
+      for (int c = 0; c < 256; ++c) {
+        t[c] = (c >= 0x20 && c <= 0x7E) || (c >= '\t' && c <= '\r');
+      }
+      return t;
+    }();
+    return tabla;
+  }
+
+  /**
+   * @brief Natural log of the probability of each byte in a text of the language.
+   * @details Letters share most of the mass according to their frequency, without case
+   *          distinction; spaces, digits and the punctuation found in credential records
+   *          get fixed shares, other printable bytes a small one, and bytes that are not
+   *          text a large penalty. Being additive, the score of a text is the sum of the
+   *          scores of its bytes, which lets the crackers score key columns independently.
+   */
+  static const std::array<double, 256>&
+  logTable(Language language) {
+    static const std::array<double, 256> ingles = buildLogTable(Language::English);
+    static const std::array<double, 256> espanol = buildLogTable(Language::Spanish);
+    return language == Language::Spanish ? espanol : ingles;
+  }
+
+  /**
+   * @brief Sum of the log-likelihood of every byte.
+   */
+  static double
+  score(const unsigned char* data, size_t size, Language language) {
+    const std::array<double, 256>& tabla = logTable(language);
+    double total = 0;
+    for (size_t i = 0; i < size; ++i) {
+      total += tabla[data[i]];
+    }
+    return total;
+  }
+
+  /**
+   * @brief Counts the letters of a text, without case distinction.
+   * @param text The text.
+   * @param counts Receives the count of each letter A-Z.
+   * @return Number of letters counted.
+   */
+  static size_t
+  countLetters(std::string_view text, std::array<size_t, 26>& counts) {
+    counts.fill(0);
+    size_t total = 0;
+    for (char c : text) {
+      unsigned char u = static_cast<unsigned char>(c);
+      if (u >= 'a' && u <= 'z') {
+        counts[u - 'a']++;
+        total++;
+      }
+      else if (u >= 'A' && u <= 'Z') {
+        counts[u - 'A']++;
+        total++;
+      }
+    }
+    return total;
+  }
+
+  /**
+   * @brief Chi-squared distance between letter counts and the language frequencies.
+   * @param counts Count of each letter A-Z.
+   * @param total Sum of the counts.
+   * @param language Expected language.
+   * @param shift Letter i of counts is compared with letter (i - shift) of the language,
+   *              so the counts of a Caesar-shifted text can be tested without undoing it.
+   * @return The distance; lower means closer to the language.
+   */
+  static double
+  chiSquared(const std::array<size_t, 26>& counts, size_t total, Language language,
+             int shift = 0) {
+    if (total == 0) {
+      return std::numeric_limits<double>::infinity();
+    }
+    const std::array<double, 26>& esperadas = letterFrequencies(language);
+    double chi = 0;
+    for (int i = 0; i < 26; ++i) {
+      double esperado = esperadas[((i - shift) % 26 + 26) % 26] * total;
+      double diferencia = counts[i] - esperado;
+      chi += diferencia * diferencia / esperado;
+    }
+    return chi;
+  }
+
+  /**
+   * @brief Index of coincidence of letter counts: the chance that two letters taken at
+   *        random are equal. About 0.066 for English, 0.077 for Spanish, 0.038 for random.
+   */
+  static double
+  indexOfCoincidence(const std::array<size_t, 26>& counts, size_t total) {
+    if (total < 2) {
+      return 0;
+    }
+    double suma = 0;
+    for (size_t n : counts) {
+      suma += static_cast<double>(n) * (n - 1);
+    }
+    return suma / (static_cast<double>(total) * (total - 1));
+  }
+
+  /**
+   * @brief Name of a language, for reports.
+   */
+  static const char*
+  name(Language language) {
+    return language == Language::Spanish ? "espanol" : "ingles";
+  }
+
+private:
+  static std::array<double, 26>
+  normalize(std::array<double, 26> values) {
+    double total = 0;
+    for (double v : values) {
+      total += v;
+    }
+    for (double& v : values) {
+      v /= total;
+    }
+    return values;
+  }
+
+  static std::array<double, 256>
+  buildLogTable(Language language) {
+    const std::array<double, 26>& letras = letterFrequencies(language);
+    const std::string puntuacion = ":@._-!,'";
+
+    std::array<double, 256> probabilidad{};
+    int otros = 0;
+    for (int c = 0x20; c <= 0x7E; ++c) {
+      if (!std::isalnum(c) && c != ' ' && puntuacion.find(static_cast<char>(c)) == std::string::npos) {
+        otros++;
+      }
+    }
+
+    for (int c = 0; c < 256; ++c) {
+      double p;
+      if (c >= 'a' && c <= 'z') {
+        p = 0.62 * letras[c - 'a'] * 0.85;
+      }
+      else if (c >= 'A' && c <= 'Z') {
+        p = 0.62 * letras[c - 'A'] * 0.15;
+      }
+      else if (c == ' ') {
+        p = 0.12;
+      }
+      else if (c >= '0' && c <= '9') {
+        p = 0.12 / 10;
+      }
+      else if (c < 0x80 && puntuacion.find(static_cast<char>(c)) != std::string::npos) {
+        p = 0.10 / puntuacion.size();
+      }
+      else if (c >= 0x21 && c <= 0x7E) {
+        p = 0.03 / otros;
+      }
+      else if (c == '\n' || c == '\t' || c == '\r') {
+        p = 0.01 / 3;
+      }
+      else {
+        p = 1e-9;
+      }
+      probabilidad[c] = std::log(p);
+    }
+    return probabilidad;
+  }
+};
@@ -0,0 +1,302 @@
+#pragma once
+#include "Prerequisites.h"
+#include "CpuFeatures.h"
+
+/**
+ * @brief Hexadecimal encoding and decoding shared by the whole project.
+ * @details Encoding copies two characters per byte from a 512-byte table; decoding looks
+ *          every character up in a 256-entry table that also marks invalid characters.
+ *          With SSSE3, 16 bytes at a time are converted in vector registers: encoding maps
+ *          the nibbles to digits with a byte shuffle, decoding validates and converts 32
+ *          characters and packs them with a multiply-add. Nothing is allocated per byte.
+ *          The decoder accepts packed text ("4a6f"), tokens separated by whitespace
+ *          ("4a 6f", or single digits as "a"), an optional 0x prefix on each token, and
+ *          either case. Errors report the position of the offending character.
+ */
+class
+HexCodec {
+public:
+  /**
+   * @brief Writes the packed lowercase hex of a buffer.
+   * @param data Bytes to encode.
+   * @param size Number of bytes.
+   * @param out Destination with room for 2 * size characters.
+   * @param simd False to force the table path.
+   */
+  static void
+  encodeInto(const uint8_t* data, size_t size, char* out, bool simd = true) {
+    size_t i = 0;
+#ifdef VGS_X86
+    if (simd && CpuFeatures::get().ssse3) {
+      i = encodeSsse3(data, size, out);
+    }
+#endif
+    const char* tabla = encodeTable().data();
+    for (; i < size; ++i) {
+      std::memcpy(out + 2 * i, tabla + 2 * data[i], 2);
+    }
+  }
+
+  /**
+   * @brief Hex of a buffer as a string.
+   * @param data Bytes to encode.
+   * @param size Number of bytes.
+   * @param separator Text placed between bytes, for example " " or " 0x".
+   */
+  static std::string
+  encode(const uint8_t* data, size_t size, std::string_view separator = std::string_view()) {
+    std::string result;
+    if (size == 0) {
+      return result;
+    }
+    if (separator.empty()) {
+      result.resize(2 * size);
+      encodeInto(data, size, &result[0]);
+      return result;
+    }
+    const char* tabla = encodeTable().data();
+    result.resize(2 * size + separator.size() * (size - 1));
+    char* out = &result[0];
+    for (size_t i = 0; i < size; ++i) {
+      if (i > 0) {
+        std::memcpy(out, separator.data(), separator.size());
+        out += separator.size();
+      }
+      std::memcpy(out, tabla + 2 * data[i], 2);
+      out += 2;
+    }
+    return result;
+  }
+
+  /**
+   * @brief Hex of the bytes of a string.
+   */
+  static std::string
+  encode(std::string_view data, std::string_view separator = std::string_view()) {
+    return encode(reinterpret_cast<const uint8_t*>(data.data()), data.size(), separator);
+  }
+
+  /**
+   * @brief Decodes packed hex with no separators.
+   * @param text Hex characters.
+   * @param size Number of characters; must be even.
+   * @param out Destination with room for size / 2 bytes.
+   * @param error Receives the reason when the text is not valid hex.
+   * @param simd False to force the table path.
+   * @return False on an odd length or a character that is not a hex digit.
+   */
+  static bool
+  decodePacked(const char* text, size_t size, uint8_t* out, std::string* error = nullptr,
+               bool simd = true) {
+    if (size % 2 != 0) {
+      return fail(error, "Odd number of hex digits", size);
+    }
+    size_t i = 0;
+#ifdef VGS_X86
+    if (simd && CpuFeatures::get().ssse3) {
+      i = decodeSsse3(text, size, out);
+    }
+#endif
+    const std::array<int8_t, 256>& tabla = decodeTable();
+    for (; i < size; i += 2) {
+      int alto = tabla[static_cast<unsigned char>(text[i])];
+      int bajo = tabla[static_cast<unsigned char>(text[i + 1])];
+      if ((alto | bajo) < 0) {
+        return fail(error, "Invalid hex digit", alto < 0 ? i : i + 1, text);
+      }
+      out[i / 2] = static_cast<uint8_t>(alto << 4 | bajo);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Decodes hex in any of the accepted layouts.
+   * @details Whitespace splits the text into tokens. A token of one digit is one byte,
+   *          a token of an even number of digits is packed bytes, and a 0x prefix is
+   *          skipped.
+   * @param text Hex text.
+   * @param out Receives the bytes; cleared first.
+   * @param error Receives the reason when the text is not valid hex.
+   * @return False on a malformed token; out then holds the bytes before it.
+   */
+  static bool
+  decode(std::string_view text, std::vector<uint8_t>& out, std::string* error = nullptr) {
+    out.clear();
+    out.reserve(text.size() / 2);
+    const std::array<int8_t, 256>& tabla = decodeTable();
+    size_t i = 0;
+    while (i < text.size()) {
+      if (isSpace(text[i])) {
+        ++i;
+        continue;
+      }
+      size_t inicio = i;
+      while (i < text.size() && !isSpace(text[i])) {
+        ++i;
+      }
+      size_t desde = inicio;
+      if (i - desde > 2 && text[desde] == '0' && (text[desde + 1] == 'x' || text[desde + 1] == 'X')) {
+        desde += 2;
+      }
+      size_t largo = i - desde;
+      if (largo == 1) {
+        int valor = tabla[static_cast<unsigned char>(text[desde])];
+        if (valor < 0) {
+          return fail(error, "Invalid hex digit", desde, text.data());
+        }
+        out.push_back(static_cast<uint8_t>(valor));
+        continue;
+      }
+      if (largo % 2 != 0) {
+        return fail(error, "Odd number of hex digits in token", inicio);
+      }
+      size_t antes = out.size();
+      out.resize(antes + largo / 2);
+      if (!decodePacked(text.data() + desde, largo, out.data() + antes)) {
+        out.resize(antes);
+        // La posicion del error se da respecto al texto completo
+        size_t posicion = desde;
+        for (size_t j = desde; j < i; ++j) {
+          if (tabla[static_cast<unsigned char>(text[j])] < 0) {
+            posicion = j;
+            break;
+          }
+        }
+        return fail(error, "Invalid hex digit", posicion, text.data());
+      }
+    }
+    return true;
+  }
+
+private:
+  static bool
+  isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+  }
+
+  /**
+   * @brief Fills the error message and returns false.
+   * @param text When given, the offending character is quoted.
+   */
+  static bool
+  fail(std::string* error, const char* reason, size_t position, const char* text = nullptr) {
+    if (error != nullptr) {
+      *error = reason;
+      if (text != nullptr) {
+        *error += " '";
+        *error += text[position];
+        *error += "'";
+      }
+      *error += " at position " + std::to_string(position);
+    }
+    return false;
+  }
+
+  /**
+   * @brief Two lowercase hex digits for every byte value.
+   */
+  static const std::array<char, 512>&
+  encodeTable() {
+    static const std::array<char, 512> tabla = []() {
+      const char* digitos = "0123456789abcdef";
+      std::array<char, 512> t{};
+      for (int b = 0; b < 256; ++b) {
+        t[2 * b] = digitos[b >> 4];
+        t[2 * b + 1] = digitos[b & 0xF];
+      }
+      return t;
+    }();
+    return tabla;
+  }
+
+  /**
+   * @brief Value of every character as a hex digit, -1 if it is not one.
+   */
+  static const std::array<int8_t, 256>&
+  decodeTable() {
+    static const std::array<int8_t, 256> tabla = []() {
+      std::array<int8_t, 256> t;
+      t.fill(-1);
+      for (int c = '0'; c <= '9'; ++c) {
+        t[c] = static_cast<int8_t>(c - '0');
+      }
+      for (int c = 'a'; c <= 'f'; ++c) {
+        t[c] = static_cast<int8_t>(c - 'a' + 10);
+        t[c - 'a' + 'A'] = static_cast<int8_t>(c - 'a' + 10);
+      }
+      return t;
+    }();
+    return tabla;
+  }
+
+#ifdef VGS_X86
+  /**
+   * @brief Encodes whole blocks of 16 bytes.
+   * @return Number of bytes encoded.
+   */
+  VGS_TARGET("ssse3")
+  static size_t
+  encodeSsse3(const uint8_t* data, size_t size, char* out) {
+    const __m128i digitos = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+                                          '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+      __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+      __m128i alto = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble);
+      __m128i bajo = _mm_and_si128(bytes, nibble);
+      alto = _mm_shuffle_epi8(digitos, alto);
+      bajo = _mm_shuffle_epi8(digitos, bajo);
+      // Cada byte da su digito alto y luego el bajo
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_unpacklo_epi8(alto, bajo));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16), _mm_unpackhi_epi8(alto, bajo));
+    }
+    return i;
+  }
+
+  /**
+   * @brief Decodes whole blocks of 32 characters, stopping before the first block with
+   *        an invalid character so the table path can report it.
+   * @return Number of characters decoded.
+   */
+  VGS_TARGET("ssse3")
+  static size_t
+  decodeSsse3(const char* text, size_t size, uint8_t* out) {
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+      __m128i a;
+      __m128i b;
+      if (!nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i)), a) ||
+          !nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + 16)), b)) {
+        break;
+      }
+      // Alto * 16 + bajo en cada par de bytes, y los 16 resultados a un solo vector
+      const __m128i pesos = _mm_set1_epi16(0x0110);
+      a = _mm_maddubs_epi16(a, pesos);
+      b = _mm_maddubs_epi16(b, pesos);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i / 2), _mm_packus_epi16(a, b));
+    }
+    return i;
+  }
+
+  /**
+   * @brief Converts 16 hex characters to their values.
+   * @return False if any of them is not a hex digit.
+   */
+  VGS_TARGET("ssse3")
+  static bool
+  nibbles(__m128i chars, __m128i& values) {
+    // Resta sin signo y minimo: c - '0' <= 9 solo para los digitos
+    __m128i digito = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    __m128i esDigito = _mm_cmpeq_epi8(_mm_min_epu8(digito, _mm_set1_epi8(9)), digito);
+    __m128i letra = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i esLetra = _mm_cmpeq_epi8(_mm_min_epu8(letra, _mm_set1_epi8(5)), letra);
+    if (_mm_movemask_epi8(_mm_or_si128(esDigito, esLetra)) != 0xFFFF) {
+      return false;
+    }
+    values = _mm_or_si128(_mm_and_si128(esDigito, digito),
+                          _mm_and_si128(esLetra, _mm_add_epi8(letra, _mm_set1_epi8(10))));
+    return true;
+  }
+#endif
+};
@@ -0,0 +1,178 @@
+#pragma once
+#include "Prerequisites.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ * @details Maps the file with MapViewOfFile on Windows and mmap elsewhere, so its bytes
+ *          can be parsed in place without copying them into std::string objects.
+ *          An empty file opens successfully with data() == nullptr and size() == 0.
+ */
+class
+MappedFile {
+public:
+  MappedFile() = default;
+
+  /**
+   * @brief Unmaps the file if it is still open.
+   */
+  ~MappedFile() {
+    close();
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+  }
+
+  MappedFile&
+  operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+      close();
+      std::swap(m_data, other.m_data);
+      std::swap(m_size, other.m_size);
+      std::swap(m_open, other.m_open);
+#ifdef _WIN32
+      std::swap(m_file, other.m_file);
+      std::swap(m_mapping, other.m_mapping);
+#endif
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Maps a file into memory, closing any previous mapping.
+   * @param path Path of the file to map.
+   * @return True if the file could be opened and mapped.
+   */
+  bool
+  open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                         OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) {
+      return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(m_file, &fileSize)) {
+      close();
+      return false;
+    }
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+    if (m_size > 0) {
+      m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (m_mapping == nullptr) {
+        close();
+        return false;
+      }
+      m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+      if (m_data == nullptr) {
+        close();
+        return false;
+      }
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+      ::close(fd);
+      return false;
+    }
+    m_size = static_cast<size_t>(info.st_size);
+    if (m_size > 0) {
+      void* address = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (address == MAP_FAILED) {
+        ::close(fd);
+        m_size = 0;
+        return false;
+      }
+      madvise(address, m_size, MADV_SEQUENTIAL);
+      m_data = static_cast<const char*>(address);
+    }
+    // The mapping stays valid after closing the descriptor
+    ::close(fd);
+#endif
+    m_open = true;
+    return true;
+  }
+
+  /**
+   * @brief Releases the mapping. Views into the old data become invalid.
+   */
+  void
+  close() {
+#ifdef _WIN32
+    if (m_data != nullptr) {
+      UnmapViewOfFile(m_data);
+    }
+    if (m_mapping != nullptr) {
+      CloseHandle(m_mapping);
+    }
+    if (m_file != INVALID_HANDLE_VALUE) {
+      CloseHandle(m_file);
+    }
+    m_mapping = nullptr;
+    m_file = INVALID_HANDLE_VALUE;
+#else
+    if (m_data != nullptr) {
+      munmap(const_cast<char*>(m_data), m_size);
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+  }
+
+  /**
+   * @brief Returns the first byte of the mapping, or nullptr for an empty file.
+   */
+  const char*
+  data() const {
+    return m_data;
+  }
+
+  /**
+   * @brief Returns the size of the mapped file in bytes.
+   */
+  size_t
+  size() const {
+    return m_size;
+  }
+
+  /**
+   * @brief Returns true if a file is currently mapped.
+   */
+  bool
+  isOpen() const {
+    return m_open;
+  }
+
+private:
+  const char* m_data = nullptr; // Start of the mapped bytes
+  size_t m_size = 0;            // Size of the mapping
+  bool m_open = false;          // True after a successful open
+#ifdef _WIN32
+  HANDLE m_file = INVALID_HANDLE_VALUE;
+  HANDLE m_mapping = nullptr;
+#endif
+};
@@ -12,13 +12,71 @@
 #include <stdexcept>
 #include <random>
 #include <fstream> 
+#include <cstring>
+#include <cstdint>
+#include <string_view>
 
 #include <mutex>
 #include <array>
+#include <thread>
+#include <future>
+#include <condition_variable>
+#include <queue>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+#include <cmath>
+#include <limits>
+#include <set>
+#include <map>
 
 struct 
 ImportantInfo {
   std::string user;
   std::string password;
   std::string others;
+};
+
+/*
+* Registro guardado como desplazamientos dentro de un buffer de texto.
+* La linea completa user:password:others empieza en offset dentro del
+* bloque indicado y los campos se obtienen con sus longitudes, sin copiar
+* ninguna cadena.
+*/
+struct
+RecordSpan {
+  uint64_t offset = 0;
+  uint32_t userLen = 0;
+  uint32_t passwordLen = 0;
+  uint32_t othersLen = 0;
+  uint32_t block = 0;
+
+  size_t
+  length() const {
+    return static_cast<size_t>(userLen) + passwordLen + othersLen + 2;
+  }
+
+  std::string_view
+  line(const char* base) const {
+    return std::string_view(base + offset, length());
+  }
+
+  std::string_view
+  user(const char* base) const {
+    return std::string_view(base + offset, userLen);
+  }
+
+  std::string_view
+  password(const char* base) const {
+    return std::string_view(base + offset + userLen + 1, passwordLen);
+  }
+
+  std::string_view
+  others(const char* base) const {
+    return std::string_view(base + offset + userLen + passwordLen + 2, othersLen);
+  }
 };
\ No newline at end of file
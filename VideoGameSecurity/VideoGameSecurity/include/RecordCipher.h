@@ -0,0 +1,203 @@
+#pragma once
+#include "Prerequisites.h"
+#include "XOREncoder.h"
+#include "CesarEncryption.h"
+#include "AsciiBinary.h"
+#include "Vigenere.h"
+#include "DES.h"
+
+/**
+ * @brief Identifies one of the ciphers supported by FileProtector.
+ * @details The numeric values match the options shown in the main menu.
+ */
+enum class
+CipherType {
+  XOR = 1,
+  Caesar = 2,
+  AsciiBinary = 3,
+  Vigenere = 4,
+  DES = 5
+};
+
+/**
+ * @brief Applies one of the supported ciphers to a single record line.
+ * @details Wraps XOREncoder, CesarEncryption, AsciiBinary, Vigenere and DES behind one
+ *          line-level interface. The transformation is exactly the one performed by the
+ *          FileProtector::Cifrar and FileProtector::Descifrar methods, so files produced
+ *          through this class are interchangeable with theirs.
+ */
+class
+RecordCipher {
+public:
+  /**
+   * @brief Builds the cipher for the given type and key.
+   * @param type The cipher to apply.
+   * @param key The key. For Caesar it holds the shift as a decimal number and for
+   *            ASCII-Binary it is ignored.
+   * @throws std::invalid_argument If the key is not valid for the selected cipher.
+   */
+  RecordCipher(CipherType type, const std::string& key)
+    : m_type(type),
+      m_des(type == CipherType::DES ? DES(DES::keyFromString(key)) : DES()) {
+    switch (m_type) {
+    case CipherType::XOR:
+      if (key.empty()) {
+        throw std::invalid_argument("The XOR key cannot be empty.");
+      }
+      m_key = key;
+      break;
+    case CipherType::Caesar:
+      m_shift = parseShift(key);
+      break;
+    case CipherType::AsciiBinary:
+      break;
+    case CipherType::Vigenere:
+      if (Vigenere::normalizeKey(key).empty()) {
+        throw std::invalid_argument("The Vigenere key must contain at least one letter.");
+      }
+      m_vigenere = Vigenere(key);
+      break;
+    case CipherType::DES:
+      if (key.length() != 8) {
+        throw std::invalid_argument("The DES key must be exactly 8 characters long.");
+      }
+      break;
+    default:
+      throw std::invalid_argument("Unknown cipher type.");
+    }
+  }
+
+  ~RecordCipher() = default;
+
+  /**
+   * @brief Encrypts one record line.
+   * @param line The plain line (user:password:others).
+   * @param out Receives the encrypted line.
+   */
+  void
+  encrypt(const std::string& line, std::string& out) {
+    switch (m_type) {
+    case CipherType::XOR:
+      m_xor.encode(line, m_key, out);
+      break;
+    case CipherType::Caesar:
+      out = m_cesar.encode(line, m_shift);
+      break;
+    case CipherType::AsciiBinary:
+      AsciiBinary::encode(line, out);
+      break;
+    case CipherType::Vigenere:
+      out = m_vigenere.encode(line);
+      break;
+    case CipherType::DES:
+      // Blocks of 8 characters, the last one padded with spaces
+      out.resize((line.length() + 7) / 8 * 8);
+      for (size_t j = 0; j < line.length(); j += 8) {
+        char bloque[8];
+        std::memset(bloque, ' ', 8);
+        std::memcpy(bloque, line.data() + j, std::min<size_t>(8, line.length() - j));
+        DesCore::store(m_des.encodeBlock(DesCore::load(bloque, 8)), &out[j]);
+      }
+      break;
+    }
+  }
+
+  /**
+   * @brief Decrypts one record line.
+   * @param line The encrypted line.
+   * @param out Receives the plain line. For DES the padding spaces are removed.
+   */
+  void
+  decrypt(const std::string& line, std::string& out) {
+    switch (m_type) {
+    case CipherType::XOR:
+      m_xor.encode(line, m_key, out);
+      break;
+    case CipherType::Caesar:
+      out = m_cesar.decode(line, m_shift);
+      break;
+    case CipherType::AsciiBinary:
+      AsciiBinary::decodeLenient(line, out);
+      break;
+    case CipherType::Vigenere:
+      out = m_vigenere.decode(line);
+      break;
+    case CipherType::DES: {
+      out.resize((line.length() + 7) / 8 * 8);
+      for (size_t j = 0; j < line.length(); j += 8) {
+        DesCore::store(m_des.decodeBlock(DesCore::load(line.data() + j, line.length() - j)), &out[j]);
+      }
+      size_t endpos = out.find_last_not_of(" ");
+      if (endpos != std::string::npos) {
+        out.resize(endpos + 1);
+      }
+      break;
+    }
+    }
+  }
+
+  /**
+   * @brief Returns the cipher handled by this instance.
+   */
+  CipherType
+  type() const {
+    return m_type;
+  }
+
+  /**
+   * @brief Returns a printable name for a cipher type.
+   * @param type The cipher type.
+   * @return The name used in the console messages.
+   */
+  static const char*
+  name(CipherType type) {
+    switch (type) {
+    case CipherType::XOR:         return "XOR";
+    case CipherType::Caesar:      return "Caesar";
+    case CipherType::AsciiBinary: return "ASCII-Binary";
+    case CipherType::Vigenere:    return "Vigenere";
+    case CipherType::DES:         return "DES";
+    }
+    return "Desconocido";
+  }
+
+  /**
+   * @brief Checks that a plain line has the user:password:others layout.
+   * @param line The line to check.
+   * @return True if the line contains at least two ':' separators.
+   */
+  static bool
+  isRecord(const std::string& line) {
+    size_t pos1 = line.find(':');
+    return pos1 != std::string::npos && line.find(':', pos1 + 1) != std::string::npos;
+  }
+
+private:
+  /**
+   * @brief Parses a Caesar shift written as a decimal number.
+   * @throws std::invalid_argument If the text is not a number.
+   */
+  static int
+  parseShift(const std::string& text) {
+    size_t used = 0;
+    int shift = 0;
+    try {
+      shift = std::stoi(text, &used);
+    }
+    catch (const std::exception&) {
+      throw std::invalid_argument("The Caesar shift must be an integer.");
+    }
+    if (used != text.size()) {
+      throw std::invalid_argument("The Caesar shift must be an integer.");
+    }
+    return shift;
+  }
+
+  CipherType m_type;       // Selected cipher
+  std::string m_key;       // XOR key
+  int m_shift = 0;         // Caesar shift
+  XOREncoder m_xor;
+  CesarEncryption m_cesar;
+  Vigenere m_vigenere;
+  DES m_des;
+};
@@ -0,0 +1,103 @@
+#pragma once
+#include "Prerequisites.h"
+
+/**
+ * @brief Zero-copy parser for user:password:others record buffers.
+ * @details Works on any contiguous text buffer (a MappedFile or a decrypted std::string)
+ *          and describes each record with a RecordSpan of offsets into that buffer.
+ *          '\n' ends a line and the last line may lack a terminator. What happens to a
+ *          '\r' right before '\n' depends on the LineEnding of the buffer.
+ */
+class
+RecordParser {
+public:
+  /**
+   * @brief How the '\r' before a '\n' is treated.
+   */
+  enum class LineEnding {
+    Plain,     // Record files, which may use CRLF: the '\r' is always dropped
+    Encrypted  // Encrypted lines, whose last byte may be '\r': it is dropped only where
+               // text-mode streams add it on write (Windows), as std::getline would
+  };
+
+  /**
+   * @brief Calls a function for every line of a buffer.
+   * @param data Start of the buffer.
+   * @param size Size of the buffer in bytes.
+   * @param callback Invoked as callback(const char* line, size_t length) for each line,
+   *                 including empty ones.
+   * @param ending Plain for record files, Encrypted for files written by a cipher.
+   */
+  template<typename Callback>
+  static void
+  forEachLine(const char* data, size_t size, Callback&& callback,
+              LineEnding ending = LineEnding::Plain) {
+#ifdef _WIN32
+    (void)ending;
+    const bool quitarRetorno = true;
+#else
+    const bool quitarRetorno = ending == LineEnding::Plain;
+#endif
+    const char* inicio = data;
+    const char* fin = data + size;
+    while (inicio < fin) {
+      const char* salto = static_cast<const char*>(std::memchr(inicio, '\n', fin - inicio));
+      const char* finLinea = (salto != nullptr) ? salto : fin;
+      size_t longitud = finLinea - inicio;
+      if (quitarRetorno && salto != nullptr && longitud > 0 && finLinea[-1] == '\r') {
+        --longitud;
+      }
+      callback(inicio, longitud);
+      if (salto == nullptr) {
+        break;
+      }
+      inicio = salto + 1;
+    }
+  }
+
+  /**
+   * @brief Splits a single line into a record.
+   * @param base Start of the buffer the offsets refer to.
+   * @param offset Position of the line inside the buffer.
+   * @param length Length of the line without terminator.
+   * @param span Receives the record when the line is valid.
+   * @return True if the line has at least two ':' separators.
+   */
+  static bool
+  parseLine(const char* base, size_t offset, size_t length, RecordSpan& span) {
+    const char* linea = base + offset;
+    const char* pos1 = static_cast<const char*>(std::memchr(linea, ':', length));
+    if (pos1 == nullptr) {
+      return false;
+    }
+    size_t restante = length - (pos1 - linea) - 1;
+    const char* pos2 = static_cast<const char*>(std::memchr(pos1 + 1, ':', restante));
+    if (pos2 == nullptr) {
+      return false;
+    }
+    span.offset = offset;
+    span.userLen = static_cast<uint32_t>(pos1 - linea);
+    span.passwordLen = static_cast<uint32_t>(pos2 - pos1 - 1);
+    span.othersLen = static_cast<uint32_t>(length - (pos2 - linea) - 1);
+    return true;
+  }
+
+  /**
+   * @brief Parses every valid record of a buffer.
+   * @param data Start of the buffer.
+   * @param size Size of the buffer in bytes.
+   * @param out Receives the records; empty and malformed lines are skipped.
+   * @return Number of records appended to out.
+   */
+  static size_t
+  parse(const char* data, size_t size, std::vector<RecordSpan>& out) {
+    size_t antes = out.size();
+    forEachLine(data, size, [&](const char* linea, size_t longitud) {
+      RecordSpan span;
+      if (longitud > 0 && parseLine(data, linea - data, longitud, span)) {
+        out.push_back(span);
+      }
+    });
+    return out.size() - antes;
+  }
+};
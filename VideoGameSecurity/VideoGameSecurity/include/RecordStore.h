@@ -0,0 +1,216 @@
+#pragma once
+#include "Prerequisites.h"
+#include "MappedFile.h"
+#include "RecordParser.h"
+
+/**
+ * @brief Contiguous storage for user:password:others records.
+ * @details Field bytes live either in a memory-mapped source file or in a few large arena
+ *          blocks owned by the store; each record is a 24-byte RecordSpan holding the block,
+ *          the offset of its line and the three field lengths. A million records therefore
+ *          cost one index vector and a handful of blocks instead of three million strings,
+ *          and clear() releases everything at once.
+ */
+class
+RecordStore {
+public:
+  /**
+   * @brief Memory used by the store.
+   */
+  struct
+  Stats {
+    size_t records = 0;        // Number of records
+    size_t blocks = 0;         // Arena blocks allocated
+    size_t arenaBytes = 0;     // Bytes reserved by the arena blocks
+    size_t arenaUsed = 0;      // Bytes of the arena holding record data
+    size_t mappedBytes = 0;    // Size of the mapped source file
+    size_t indexBytes = 0;     // Bytes reserved by the record index
+  };
+
+  /**
+   * @brief Creates an empty store.
+   * @param blockSize Size of each arena block; records larger than this get their own block.
+   */
+  explicit RecordStore(size_t blockSize = DEFAULT_BLOCK_SIZE)
+    : m_blockSize(blockSize) {
+  }
+
+  ~RecordStore() = default;
+
+  RecordStore(const RecordStore&) = delete;
+  RecordStore& operator=(const RecordStore&) = delete;
+
+  /**
+   * @brief Replaces the content with the records of a text file, without copying them.
+   * @param path Path of the file to map.
+   * @return True if the file could be mapped.
+   */
+  bool
+  load(const std::string& path) {
+    clear();
+    if (!m_mapped.open(path)) {
+      return false;
+    }
+    m_bases.push_back(m_mapped.data());
+    RecordParser::parse(m_mapped.data(), m_mapped.size(), m_records);
+    return true;
+  }
+
+  /**
+   * @brief Copies a line into the arena if it is a valid record.
+   * @param line The user:password:others line, without terminator.
+   * @return True if the line had two ':' separators and was stored.
+   */
+  bool
+  append(std::string_view line) {
+    RecordSpan span;
+    if (!RecordParser::parseLine(line.data(), 0, line.size(), span)) {
+      return false;
+    }
+    char* destino = allocate(line.size(), span);
+    std::memcpy(destino, line.data(), line.size());
+    m_records.push_back(span);
+    return true;
+  }
+
+  /**
+   * @brief Reserves room in the index for a number of records.
+   */
+  void
+  reserve(size_t records) {
+    m_records.reserve(records);
+  }
+
+  /**
+   * @brief Releases every record, arena block and mapping in one step.
+   */
+  void
+  clear() {
+    std::vector<RecordSpan>().swap(m_records);
+    std::vector<std::unique_ptr<char[]>>().swap(m_blocks);
+    m_bases.clear();
+    m_mapped.close();
+    m_blockUsed = 0;
+    m_blockCapacity = 0;
+    m_arenaBytes = 0;
+    m_arenaUsed = 0;
+  }
+
+  /**
+   * @brief Returns the number of records.
+   */
+  size_t
+  size() const {
+    return m_records.size();
+  }
+
+  /**
+   * @brief Returns true if the store has no records.
+   */
+  bool
+  empty() const {
+    return m_records.empty();
+  }
+
+  /**
+   * @brief Returns the complete user:password:others line of a record.
+   */
+  std::string_view
+  line(size_t index) const {
+    const RecordSpan& span = m_records[index];
+    return span.line(m_bases[span.block]);
+  }
+
+  /**
+   * @brief Returns the user field of a record.
+   */
+  std::string_view
+  user(size_t index) const {
+    const RecordSpan& span = m_records[index];
+    return span.user(m_bases[span.block]);
+  }
+
+  /**
+   * @brief Returns the password field of a record.
+   */
+  std::string_view
+  password(size_t index) const {
+    const RecordSpan& span = m_records[index];
+    return span.password(m_bases[span.block]);
+  }
+
+  /**
+   * @brief Returns the others field of a record.
+   */
+  std::string_view
+  others(size_t index) const {
+    const RecordSpan& span = m_records[index];
+    return span.others(m_bases[span.block]);
+  }
+
+  /**
+   * @brief Copies a record into an ImportantInfo.
+   * @throws std::out_of_range If the index is not valid.
+   */
+  ImportantInfo
+  get(size_t index) const {
+    if (index >= m_records.size()) {
+      throw std::out_of_range("Record index out of range.");
+    }
+    ImportantInfo dato;
+    dato.user = std::string(user(index));
+    dato.password = std::string(password(index));
+    dato.others = std::string(others(index));
+    return dato;
+  }
+
+  /**
+   * @brief Reports the memory held by the store.
+   */
+  Stats
+  stats() const {
+    Stats result;
+    result.records = m_records.size();
+    result.blocks = m_blocks.size();
+    result.arenaBytes = m_arenaBytes;
+    result.arenaUsed = m_arenaUsed;
+    result.mappedBytes = m_mapped.size();
+    result.indexBytes = m_records.capacity() * sizeof(RecordSpan);
+    return result;
+  }
+
+  static constexpr size_t DEFAULT_BLOCK_SIZE = 4 << 20;
+
+private:
+  /**
+   * @brief Returns room for a line in the current block, opening a new one if needed.
+   * @param bytes Size of the line.
+   * @param span Receives the block and offset of the returned memory.
+   */
+  char*
+  allocate(size_t bytes, RecordSpan& span) {
+    if (m_blocks.empty() || m_blockUsed + bytes > m_blockCapacity) {
+      m_blockCapacity = std::max(m_blockSize, bytes);
+      m_blocks.emplace_back(new char[m_blockCapacity]);
+      m_bases.push_back(m_blocks.back().get());
+      m_blockUsed = 0;
+      m_arenaBytes += m_blockCapacity;
+    }
+    span.block = static_cast<uint32_t>(m_bases.size() - 1);
+    span.offset = m_blockUsed;
+    char* destino = m_blocks.back().get() + m_blockUsed;
+    m_blockUsed += bytes;
+    m_arenaUsed += bytes;
+    return destino;
+  }
+
+  size_t m_blockSize;                             // Capacity of a regular arena block
+  std::vector<RecordSpan> m_records;              // Record index
+  std::vector<std::unique_ptr<char[]>> m_blocks;  // Arena blocks owned by the store
+  std::vector<const char*> m_bases;               // Start of every block, mapping included
+  MappedFile m_mapped;                            // Source file opened by load()
+  size_t m_blockUsed = 0;                         // Bytes used in the last block
+  size_t m_blockCapacity = 0;                     // Capacity of the last block
+  size_t m_arenaBytes = 0;                        // Total arena capacity
+  size_t m_arenaUsed = 0;                         // Total arena bytes in use
+};
@@ -0,0 +1,512 @@
+#pragma once
+#include "Prerequisites.h"
+#include "MappedFile.h"
+#include "RecordCipher.h"
+#include "SipHash.h"
+
+/**
+ * @brief Binary container for encrypted records with random access.
+ * @details Layout of a container file, all integers little endian:
+ *
+ *   offset 0   Header (HEADER_SIZE bytes)
+ *                char[4]  magic "VGSC"
+ *                uint16   version
+ *                uint16   cipher id (CipherType)
+ *                uint32   reserved
+ *                uint64   record count
+ *                uint64   offset of the last index segment descriptor
+ *                uint8[16] salt
+ *                uint64   key-check value, SipHash of the key keyed by the salt
+ *   offset 64  Encrypted records, back to back, no separators
+ *   segments   Each write or append adds its records, then its index segment:
+ *                entries   count entries of uint64 offset + uint64 length
+ *                uint64    offset of the entries
+ *                uint64    entry count
+ *                uint64    offset of the previous descriptor, 0 for the first segment
+ *
+ *          An append only adds bytes at the end of the file: the new records, their
+ *          segment, and finally the header, so the file stays readable with its old
+ *          content if the append is interrupted at any point. Opening walks the chain of
+ *          descriptors once; after that any record is located with one index read. Once
+ *          there are MAX_SEGMENTS segments the next append writes a single segment with
+ *          the entries of all of them, which keeps the chain short at an amortized cost
+ *          per append; the old segments are left unused in the file.
+ *          Version 1 files have a single index of record count entries at the header
+ *          offset and no descriptor; they are read as one segment and upgraded on the
+ *          first append, by writing a descriptor for their index.
+ */
+class
+SecureContainer {
+public:
+  static constexpr uint16_t VERSION = 2;
+  static constexpr uint16_t VERSION_SINGLE_INDEX = 1;
+  static constexpr size_t HEADER_SIZE = 64;
+  static constexpr size_t INDEX_ENTRY_SIZE = 16;
+  static constexpr size_t SEGMENT_DESCRIPTOR_SIZE = 24;
+  static constexpr size_t MAX_SEGMENTS = 8;
+
+  /**
+   * @brief Decoded container header.
+   */
+  struct
+  Header {
+    uint16_t version = VERSION;
+    CipherType cipher = CipherType::XOR;
+    uint64_t recordCount = 0;
+    uint64_t indexOffset = HEADER_SIZE;
+    SipHash::Key salt{};
+    uint64_t keyCheck = 0;
+  };
+
+  /**
+   * @brief One index segment: the entries of records first to first + count - 1.
+   */
+  struct
+  Segment {
+    uint64_t first = 0;         // Number of the first record of the segment
+    uint64_t count = 0;         // Number of entries
+    uint64_t entriesOffset = 0; // Where the entries start; the records lie before it
+  };
+
+  /**
+   * @brief Computes the key-check value stored in the header.
+   * @param salt Random salt of the container.
+   * @param key The cipher key.
+   * @return The 64-bit check value.
+   */
+  static uint64_t
+  keyCheck(const SipHash::Key& salt, const std::string& key) {
+    return SipHash::hash(salt, key);
+  }
+
+  /**
+   * @brief Serializes a header.
+   * @param header The header to write.
+   * @param out Buffer of HEADER_SIZE bytes.
+   */
+  static void
+  encodeHeader(const Header& header, uint8_t* out) {
+    std::memset(out, 0, HEADER_SIZE);
+    std::memcpy(out, "VGSC", 4);
+    out[4] = static_cast<uint8_t>(header.version & 0xFF);
+    out[5] = static_cast<uint8_t>(header.version >> 8);
+    uint16_t cipher = static_cast<uint16_t>(header.cipher);
+    out[6] = static_cast<uint8_t>(cipher & 0xFF);
+    out[7] = static_cast<uint8_t>(cipher >> 8);
+    SipHash::store64(header.recordCount, out + 12);
+    SipHash::store64(header.indexOffset, out + 20);
+    std::memcpy(out + 28, header.salt.data(), header.salt.size());
+    SipHash::store64(header.keyCheck, out + 44);
+  }
+
+  /**
+   * @brief Parses and validates a header.
+   * @param in Start of the file.
+   * @param size Size of the file.
+   * @param header Receives the decoded header.
+   * @param error Receives the reason when the header is not valid.
+   * @return True if the header is valid for a file of this size.
+   */
+  static bool
+  decodeHeader(const uint8_t* in, size_t size, Header& header, std::string& error) {
+    if (size < HEADER_SIZE || std::memcmp(in, "VGSC", 4) != 0) {
+      error = "no es un contenedor VGSC";
+      return false;
+    }
+    uint16_t version = static_cast<uint16_t>(in[4] | (in[5] << 8));
+    if (version != VERSION && version != VERSION_SINGLE_INDEX) {
+      error = "version de contenedor no soportada";
+      return false;
+    }
+    uint16_t cipher = static_cast<uint16_t>(in[6] | (in[7] << 8));
+    if (cipher < static_cast<uint16_t>(CipherType::XOR) ||
+        cipher > static_cast<uint16_t>(CipherType::DES)) {
+      error = "cifrado desconocido en el contenedor";
+      return false;
+    }
+    header.version = version;
+    header.cipher = static_cast<CipherType>(cipher);
+    header.recordCount = SipHash::load64(in + 12);
+    header.indexOffset = SipHash::load64(in + 20);
+    std::memcpy(header.salt.data(), in + 28, header.salt.size());
+    header.keyCheck = SipHash::load64(in + 44);
+
+    bool danado = header.indexOffset < HEADER_SIZE || header.indexOffset > size;
+    if (!danado && version == VERSION_SINGLE_INDEX) {
+      danado = header.recordCount > (size - header.indexOffset) / INDEX_ENTRY_SIZE;
+    }
+    else if (!danado) {
+      danado = size - header.indexOffset < SEGMENT_DESCRIPTOR_SIZE;
+    }
+    if (danado) {
+      error = "indice del contenedor danado";
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Collects the index segments of a container, in record order.
+   * @param in Start of the file.
+   * @param size Size of the file.
+   * @param header Header already validated by decodeHeader.
+   * @param segments Receives the segments.
+   * @param error Receives the reason when the chain is damaged.
+   * @return True if the segments cover exactly the records of the header.
+   */
+  static bool
+  readSegments(const uint8_t* in, size_t size, const Header& header,
+               std::vector<Segment>& segments, std::string& error) {
+    segments.clear();
+    if (header.version == VERSION_SINGLE_INDEX) {
+      segments.push_back({ 0, header.recordCount, header.indexOffset });
+      return true;
+    }
+
+    // Cada descriptor apunta a uno anterior, asi la cadena siempre termina
+    uint64_t descriptor = header.indexOffset;
+    uint64_t restantes = header.recordCount;
+    while (descriptor != 0) {
+      if (descriptor < HEADER_SIZE || descriptor > size - SEGMENT_DESCRIPTOR_SIZE) {
+        error = "indice del contenedor danado";
+        return false;
+      }
+      Segment segmento;
+      segmento.entriesOffset = SipHash::load64(in + descriptor);
+      segmento.count = SipHash::load64(in + descriptor + 8);
+      uint64_t anterior = SipHash::load64(in + descriptor + 16);
+      if (segmento.entriesOffset < HEADER_SIZE || segmento.entriesOffset > descriptor ||
+          segmento.count > (descriptor - segmento.entriesOffset) / INDEX_ENTRY_SIZE ||
+          segmento.count > restantes || anterior >= descriptor) {
+        error = "indice del contenedor danado";
+        return false;
+      }
+      restantes -= segmento.count;
+      segmento.first = restantes;
+      if (segmento.count > 0) {
+        segments.push_back(segmento);
+      }
+      descriptor = anterior;
+    }
+    if (restantes != 0) {
+      error = "indice del contenedor danado";
+      return false;
+    }
+    std::reverse(segments.begin(), segments.end());
+    return true;
+  }
+};
+
+/**
+ * @brief Writes a SecureContainer record by record.
+ */
+class
+ContainerWriter {
+public:
+  ContainerWriter() = default;
+  ~ContainerWriter() = default;
+
+  /**
+   * @brief Creates the file and reserves room for the header.
+   * @param path Path of the container.
+   * @param cipher Cipher used for the records.
+   * @param key The key, used only to compute the key-check value.
+   * @param salt Random salt for the key-check value.
+   * @return True if the file could be created.
+   */
+  bool
+  create(const std::string& path, CipherType cipher, const std::string& key,
+         const SipHash::Key& salt) {
+    m_file.open(path, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!m_file.is_open()) {
+      return false;
+    }
+    m_header = SecureContainer::Header();
+    m_header.cipher = cipher;
+    m_header.salt = salt;
+    m_header.keyCheck = SecureContainer::keyCheck(salt, key);
+    m_index.clear();
+    m_offset = SecureContainer::HEADER_SIZE;
+    m_first = 0;
+    m_previous = 0;
+    m_legacyCount = 0;
+
+    uint8_t vacio[SecureContainer::HEADER_SIZE] = {};
+    m_file.write(reinterpret_cast<const char*>(vacio), sizeof(vacio));
+    return static_cast<bool>(m_file);
+  }
+
+  /**
+   * @brief Opens an existing container to add records after the last one.
+   * @details Neither the records nor the index already in the file are read or
+   *          rewritten: the new records go after the end of the file and finish() adds
+   *          their own index segment, chained to the current one, before updating the
+   *          header. Until then the header still describes the old content. With
+   *          MAX_SEGMENTS segments already in the file, their entries are read here and
+   *          finish() writes them with the new ones as a single segment.
+   * @param path Path of the container.
+   * @param key The key, checked against the key-check value of the header.
+   * @param error Receives the reason when the container cannot be opened.
+   * @return True if the container is valid and the key matches.
+   */
+  bool
+  append(const std::string& path, const std::string& key, std::string& error) {
+    std::ifstream entrada(path, std::ios::binary | std::ios::ate);
+    if (!entrada.is_open()) {
+      error = "no se pudo abrir " + path;
+      return false;
+    }
+    uint64_t tamArchivo = static_cast<uint64_t>(entrada.tellg());
+    uint8_t cabecera[SecureContainer::HEADER_SIZE] = {};
+    entrada.seekg(0);
+    entrada.read(reinterpret_cast<char*>(cabecera), sizeof(cabecera));
+    if (!SecureContainer::decodeHeader(cabecera, entrada ? tamArchivo : 0, m_header, error)) {
+      return false;
+    }
+    if (SecureContainer::keyCheck(m_header.salt, key) != m_header.keyCheck) {
+      error = "la clave no corresponde a este contenedor";
+      return false;
+    }
+    entrada.close();
+
+    m_index.clear();
+    m_merged.clear();
+    m_first = m_header.recordCount;
+    m_legacyCount = 0;
+    m_previous = m_header.indexOffset;
+    if (m_header.version == SecureContainer::VERSION_SINGLE_INDEX) {
+      // Su indice sin descriptor se encadena desde finish()
+      m_legacyCount = m_header.recordCount;
+      m_previous = 0;
+    }
+    else if (!loadForMerge(path, error)) {
+      return false;
+    }
+
+    m_file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+    if (!m_file.is_open()) {
+      error = "no se pudo escribir en " + path;
+      return false;
+    }
+    m_offset = tamArchivo;
+    m_file.seekp(m_offset);
+    return true;
+  }
+
+  /**
+   * @brief Cipher stored in the header being written.
+   */
+  CipherType
+  cipher() const {
+    return m_header.cipher;
+  }
+
+  /**
+   * @brief Appends one encrypted record.
+   * @param ciphertext The encrypted record.
+   */
+  bool
+  add(std::string_view ciphertext) {
+    m_file.write(ciphertext.data(), ciphertext.size());
+    m_index.push_back({ m_offset, ciphertext.size() });
+    m_offset += ciphertext.size();
+    return static_cast<bool>(m_file);
+  }
+
+  /**
+   * @brief Writes the index segment of the new records, then the header, and closes
+   *        the file.
+   * @return True if everything was written.
+   */
+  bool
+  finish() {
+    std::vector<uint8_t> segmento;
+    uint64_t anterior = m_previous;
+    uint64_t cantidad = m_index.size();
+    if (m_legacyCount > 0) {
+      // Descriptor para el indice de un contenedor de version 1
+      segmento.resize(SecureContainer::SEGMENT_DESCRIPTOR_SIZE);
+      SipHash::store64(m_header.indexOffset, &segmento[0]);
+      SipHash::store64(m_legacyCount, &segmento[8]);
+      SipHash::store64(0, &segmento[16]);
+      anterior = m_offset;
+    }
+
+    uint64_t entradas = m_offset + segmento.size();
+    if (!m_merged.empty()) {
+      // Las entradas de todos los segmentos anteriores van delante de las nuevas
+      segmento.swap(m_merged);
+      cantidad += m_first;
+      anterior = 0;
+    }
+
+    size_t inicio = segmento.size();
+    segmento.resize(inicio + m_index.size() * SecureContainer::INDEX_ENTRY_SIZE +
+                    SecureContainer::SEGMENT_DESCRIPTOR_SIZE);
+    for (size_t i = 0; i < m_index.size(); ++i) {
+      SipHash::store64(m_index[i].first, &segmento[inicio + i * SecureContainer::INDEX_ENTRY_SIZE]);
+      SipHash::store64(m_index[i].second, &segmento[inicio + i * SecureContainer::INDEX_ENTRY_SIZE + 8]);
+    }
+    size_t descriptor = segmento.size() - SecureContainer::SEGMENT_DESCRIPTOR_SIZE;
+    SipHash::store64(entradas, &segmento[descriptor]);
+    SipHash::store64(cantidad, &segmento[descriptor + 8]);
+    SipHash::store64(anterior, &segmento[descriptor + 16]);
+    m_file.write(reinterpret_cast<const char*>(segmento.data()), segmento.size());
+    m_file.flush();
+
+    // La cabecera va al final: hasta aqui el archivo sigue describiendo su contenido anterior
+    m_header.version = SecureContainer::VERSION;
+    m_header.recordCount = m_first + m_index.size();
+    m_header.indexOffset = m_offset + descriptor;
+    uint8_t cabecera[SecureContainer::HEADER_SIZE];
+    SecureContainer::encodeHeader(m_header, cabecera);
+    if (m_file) {
+      m_file.seekp(0);
+      m_file.write(reinterpret_cast<const char*>(cabecera), sizeof(cabecera));
+    }
+
+    bool ok = static_cast<bool>(m_file);
+    m_file.close();
+    return ok;
+  }
+
+  /**
+   * @brief Number of records of the container, the ones already in the file included.
+   */
+  uint64_t
+  size() const {
+    return m_first + m_index.size();
+  }
+
+private:
+  /**
+   * @brief Reads the entries of every index segment if there are MAX_SEGMENTS of them.
+   * @param path Path of the container, still closed for writing.
+   * @param error Receives the reason when the chain of segments is damaged.
+   * @return True if the segments could be read.
+   */
+  bool
+  loadForMerge(const std::string& path, std::string& error) {
+    MappedFile archivo;
+    if (!archivo.open(path)) {
+      error = "no se pudo abrir " + path;
+      return false;
+    }
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(archivo.data());
+    std::vector<SecureContainer::Segment> segmentos;
+    if (!SecureContainer::readSegments(bytes, archivo.size(), m_header, segmentos, error)) {
+      return false;
+    }
+    if (segmentos.size() < SecureContainer::MAX_SEGMENTS) {
+      return true;
+    }
+    m_merged.reserve(static_cast<size_t>(m_first) * SecureContainer::INDEX_ENTRY_SIZE);
+    for (const SecureContainer::Segment& segmento : segmentos) {
+      const uint8_t* entradas = bytes + segmento.entriesOffset;
+      m_merged.insert(m_merged.end(), entradas,
+                      entradas + segmento.count * SecureContainer::INDEX_ENTRY_SIZE);
+    }
+    return true;
+  }
+
+  std::fstream m_file;                               // Container being written
+  SecureContainer::Header m_header;                  // Header written by finish()
+  std::vector<std::pair<uint64_t, uint64_t>> m_index; // Offset and length of each new record
+  uint64_t m_offset = SecureContainer::HEADER_SIZE;  // Where the next record goes
+  uint64_t m_first = 0;                              // Records already in the file
+  uint64_t m_previous = 0;                           // Descriptor of the last segment in the file
+  uint64_t m_legacyCount = 0;                        // Entries of a version 1 index to chain
+  std::vector<uint8_t> m_merged;                     // Entries of the old segments, to merge
+};
+
+/**
+ * @brief Memory-mapped, random-access view of a SecureContainer.
+ */
+class
+ContainerReader {
+public:
+  ContainerReader() = default;
+  ~ContainerReader() = default;
+
+  /**
+   * @brief Maps a container and validates its header.
+   * @param path Path of the container.
+   * @return True if the file is a valid container; otherwise see error().
+   */
+  bool
+  open(const std::string& path) {
+    if (!m_file.open(path)) {
+      m_error = "no se pudo abrir " + path;
+      return false;
+    }
+    return SecureContainer::decodeHeader(bytes(), m_file.size(), m_header, m_error) &&
+           SecureContainer::readSegments(bytes(), m_file.size(), m_header, m_segments, m_error);
+  }
+
+  /**
+   * @brief Reason of the last failure of open().
+   */
+  const std::string&
+  error() const {
+    return m_error;
+  }
+
+  /**
+   * @brief The decoded header.
+   */
+  const SecureContainer::Header&
+  header() const {
+    return m_header;
+  }
+
+  /**
+   * @brief Checks a key against the key-check value, without decrypting any record.
+   */
+  bool
+  checkKey(const std::string& key) const {
+    return SecureContainer::keyCheck(m_header.salt, key) == m_header.keyCheck;
+  }
+
+  /**
+   * @brief Number of records in the container.
+   */
+  uint64_t
+  size() const {
+    return m_header.recordCount;
+  }
+
+  /**
+   * @brief Returns the encrypted bytes of a record in O(1).
+   * @param index Position of the record.
+   * @throws std::out_of_range If the index or the stored entry is out of bounds.
+   */
+  std::string_view
+  record(uint64_t index) const {
+    if (index >= m_header.recordCount) {
+      throw std::out_of_range("Record index out of range.");
+    }
+    // El ultimo segmento que empieza en o antes del registro
+    auto segmento = std::upper_bound(m_segments.begin(), m_segments.end(), index,
+      [](uint64_t i, const SecureContainer::Segment& s) { return i < s.first; }) - 1;
+    const uint8_t* entrada = bytes() + segmento->entriesOffset +
+                             (index - segmento->first) * SecureContainer::INDEX_ENTRY_SIZE;
+    uint64_t offset = SipHash::load64(entrada);
+    uint64_t length = SipHash::load64(entrada + 8);
+    if (offset < SecureContainer::HEADER_SIZE || offset > segmento->entriesOffset ||
+        length > segmento->entriesOffset - offset) {
+      throw std::out_of_range("Corrupted container index entry.");
+    }
+    return std::string_view(m_file.data() + offset, static_cast<size_t>(length));
+  }
+
+private:
+  const uint8_t*
+  bytes() const {
+    return reinterpret_cast<const uint8_t*>(m_file.data());
+  }
+
+  MappedFile m_file;                                 // Mapped container
+  SecureContainer::Header m_header;                  // Decoded header
+  std::vector<SecureContainer::Segment> m_segments;  // Non-empty index segments in record order
+  std::string m_error;                               // Last error of open()
+};
@@ -0,0 +1,191 @@
+#pragma once
+#include "Prerequisites.h"
+
+/**
+ * @brief SipHash-2-4 keyed hash function.
+ * @details Produces a 64-bit tag from a 128-bit key and a message. Without the key the tag
+ *          cannot be predicted, which makes it suitable for key-check values and for
+ *          indexing sensitive fields without revealing them.
+ */
+class
+SipHash {
+public:
+  /**
+   * @brief 128-bit SipHash key.
+   */
+  using Key = std::array<uint8_t, 16>;
+
+  /**
+   * @brief Computes a tag over a message that arrives in pieces.
+   * @details The tag is the same hash() gives for all the pieces joined, so a file can
+   *          be hashed while it is read block by block.
+   */
+  class
+  Stream {
+  public:
+    /**
+     * @param key The 128-bit key.
+     */
+    explicit Stream(const Key& key) {
+      uint64_t k0 = load64(key.data());
+      uint64_t k1 = load64(key.data() + 8);
+      m_v0 = 0x736f6d6570736575ULL ^ k0;
+      m_v1 = 0x646f72616e646f6dULL ^ k1;
+      m_v2 = 0x6c7967656e657261ULL ^ k0;
+      m_v3 = 0x7465646279746573ULL ^ k1;
+    }
+
+    /**
+     * @brief Adds the next piece of the message.
+     * @param data Start of the piece.
+     * @param size Size of the piece in bytes.
+     */
+    void
+    update(const void* data, size_t size) {
+      const uint8_t* in = static_cast<const uint8_t*>(data);
+      m_size += size;
+
+      // Completa la palabra que quedo a medias en el trozo anterior
+      while (m_pending > 0 && m_pending < 8 && size > 0) {
+        m_tail |= static_cast<uint64_t>(*in++) << (8 * m_pending++);
+        --size;
+      }
+      if (m_pending == 8) {
+        compress(m_tail);
+        m_tail = 0;
+        m_pending = 0;
+      }
+
+      // Full 8-byte words
+      size_t end = size - (size % 8);
+      for (size_t i = 0; i < end; i += 8) {
+        compress(load64(in + i));
+      }
+      for (size_t i = end; i < size; ++i) {
+        m_tail |= static_cast<uint64_t>(in[i]) << (8 * m_pending++);
+      }
+    }
+
+    /**
+     * @brief Returns the tag of everything added so far.
+     */
+    uint64_t
+    finish() const {
+      uint64_t v0 = m_v0;
+      uint64_t v1 = m_v1;
+      uint64_t v2 = m_v2;
+      uint64_t v3 = m_v3;
+
+      // Last word: remaining bytes plus the message length in the top byte
+      uint64_t last = m_tail | (m_size << 56);
+      v3 ^= last;
+      round(v0, v1, v2, v3);
+      round(v0, v1, v2, v3);
+      v0 ^= last;
+
+      v2 ^= 0xff;
+      for (int i = 0; i < 4; ++i) {
+        round(v0, v1, v2, v3);
+      }
+      return v0 ^ v1 ^ v2 ^ v3;
+    }
+
+  private:
+    void
+    compress(uint64_t m) {
+      m_v3 ^= m;
+      round(m_v0, m_v1, m_v2, m_v3);
+      round(m_v0, m_v1, m_v2, m_v3);
+      m_v0 ^= m;
+    }
+
+    uint64_t m_v0 = 0;       // SipHash state
+    uint64_t m_v1 = 0;
+    uint64_t m_v2 = 0;
+    uint64_t m_v3 = 0;
+    uint64_t m_tail = 0;     // Bytes of the incomplete last word
+    size_t m_pending = 0;    // Number of bytes in m_tail
+    uint64_t m_size = 0;     // Bytes added so far
+  };
+
+  /**
+   * @brief Computes the SipHash-2-4 tag of a message.
+   * @param key The 128-bit key.
+   * @param data Start of the message.
+   * @param size Size of the message in bytes.
+   * @return The 64-bit tag.
+   */
+  static uint64_t
+  hash(const Key& key, const void* data, size_t size) {
+    Stream stream(key);
+    stream.update(data, size);
+    return stream.finish();
+  }
+
+  /**
+   * @brief Computes the tag of a string.
+   */
+  static uint64_t
+  hash(const Key& key, std::string_view text) {
+    return hash(key, text.data(), text.size());
+  }
+
+  /**
+   * @brief Derives a SipHash key from a secret and a context label.
+   * @details Used when the secret is a user key of arbitrary length. The label separates
+   *          keys derived for different purposes from the same secret.
+   * @param secret The user key.
+   * @param label Purpose of the derived key, for example "blind-index".
+   * @return The derived 128-bit key.
+   */
+  static Key
+  deriveKey(std::string_view secret, std::string_view label) {
+    Key base{};
+    for (size_t i = 0; i < label.size(); ++i) {
+      base[i % base.size()] ^= static_cast<uint8_t>(label[i]);
+    }
+    Key derived;
+    uint64_t low = hash(base, secret);
+    base[0] ^= 0x01;
+    uint64_t high = hash(base, secret);
+    store64(low, derived.data());
+    store64(high, derived.data() + 8);
+    return derived;
+  }
+
+  /**
+   * @brief Reads a little-endian 64-bit value.
+   */
+  static uint64_t
+  load64(const uint8_t* p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+      value = (value << 8) | p[i];
+    }
+    return value;
+  }
+
+  /**
+   * @brief Writes a little-endian 64-bit value.
+   */
+  static void
+  store64(uint64_t value, uint8_t* p) {
+    for (int i = 0; i < 8; ++i) {
+      p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+  }
+
+private:
+  static uint64_t
+  rotl(uint64_t x, int b) {
+    return (x << b) | (x >> (64 - b));
+  }
+
+  static void
+  round(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3) {
+    v0 += v1; v1 = rotl(v1, 13); v1 ^= v0; v0 = rotl(v0, 32);
+    v2 += v3; v3 = rotl(v3, 16); v3 ^= v2;
+    v0 += v3; v3 = rotl(v3, 21); v3 ^= v0;
+    v2 += v1; v1 = rotl(v1, 17); v1 ^= v2; v2 = rotl(v2, 32);
+  }
+};
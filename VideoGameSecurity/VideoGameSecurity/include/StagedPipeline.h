@@ -0,0 +1,459 @@
+#pragma once
+#include "Prerequisites.h"
+#include "BoundedQueue.h"
+#include "RecordParser.h"
+#include "RecordCipher.h"
+
+/**
+ * @brief Reader / cipher workers / writer pipeline over a record file.
+ * @details A reader thread cuts the input into batches of whole lines, several workers
+ *          cipher the batches with their own copy of the cipher, and the calling thread
+ *          writes the results in their original order with one large write per batch.
+ *          The stages are connected by BoundedQueue instances, so reading, ciphering and
+ *          writing overlap. The reader never gets more than a fixed window of batches
+ *          ahead of the writer, which bounds the memory in use, and the buffers of
+ *          written batches are handed back to the reader and the workers for reuse.
+ *
+ *          Each stage measures the time it spends working; stats() reports it as a
+ *          fraction of the wall time so the slowest stage can be identified.
+ *
+ * @tparam Cifrador RecordCipher, CipherPipeline or any copyable type with
+ *                  encrypt(const std::string&, std::string&) and decrypt(...).
+ */
+template<typename Cifrador>
+class
+StagedPipeline {
+public:
+  /**
+   * @brief Work measured for each stage of one run.
+   */
+  struct
+  Stats {
+    uint64_t records = 0;       // Records written
+    uint64_t batches = 0;       // Batches read
+    uint64_t bytesIn = 0;       // Bytes read
+    uint64_t bytesOut = 0;      // Bytes written
+    unsigned int workers = 0;   // Cipher threads
+    double elapsed = 0;         // Wall time of the run, in seconds
+    double readBusy = 0;        // Seconds spent reading and cutting batches
+    double cipherBusy = 0;      // Seconds spent ciphering, summed over the workers
+    double writeBusy = 0;       // Seconds spent writing
+
+    /**
+     * @brief Fraction of the wall time the reader was working.
+     */
+    double
+    readUtilization() const {
+      return elapsed > 0 ? readBusy / elapsed : 0;
+    }
+
+    /**
+     * @brief Average fraction of the wall time each worker was working.
+     */
+    double
+    cipherUtilization() const {
+      return (elapsed > 0 && workers > 0) ? cipherBusy / (elapsed * workers) : 0;
+    }
+
+    /**
+     * @brief Fraction of the wall time the writer was working.
+     */
+    double
+    writeUtilization() const {
+      return elapsed > 0 ? writeBusy / elapsed : 0;
+    }
+  };
+
+  /**
+   * @param cifrador Cipher copied into every worker.
+   * @param encrypt True to encrypt the input, false to decrypt it.
+   * @param workers Number of cipher threads; 0 uses one per hardware thread.
+   * @param batchSize Bytes read per batch.
+   */
+  StagedPipeline(const Cifrador& cifrador, bool encrypt, unsigned int workers = 0,
+                 size_t batchSize = 1 << 20)
+    : m_cifrador(cifrador), m_encrypt(encrypt), m_workers(workers), m_batchSize(batchSize) {
+    if (m_workers == 0) {
+      m_workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (m_batchSize == 0) {
+      m_batchSize = 1 << 20;
+    }
+  }
+
+  /**
+   * @brief Processes a whole file.
+   * @details Lines are filtered as in FileProtector: on encryption only lines with two ':'
+   *          are kept, on decryption only lines that decrypt to such a record.
+   * @param inPath File to read.
+   * @param outPath File to create.
+   * @param error Receives the reason of a failure.
+   * @return True if every batch was read, ciphered and written.
+   */
+  bool
+  run(const std::string& inPath, const std::string& outPath, std::string& error) {
+    m_stats = Stats();
+    m_stats.workers = m_workers;
+
+    std::ifstream entrada(inPath, std::ios::binary);
+    if (!entrada.is_open()) {
+      error = "No se pudo abrir " + inPath;
+      return false;
+    }
+    std::ofstream salida(outPath);
+    if (!salida.is_open()) {
+      error = "No se pudo crear " + outPath;
+      return false;
+    }
+
+    // Lotes en vuelo entre el lector y el escritor
+    const size_t ventana = std::max<size_t>(4, static_cast<size_t>(m_workers) * 4);
+    Shared shared(ventana);
+    auto inicio = Clock::now();
+
+    std::vector<double> ocupados(m_workers, 0);
+    std::vector<std::thread> hilos;
+    hilos.reserve(m_workers + 1);
+    hilos.emplace_back([&]() { readStage(entrada, shared, ventana); });
+    for (unsigned int w = 0; w < m_workers; ++w) {
+      hilos.emplace_back([&, w]() { cipherStage(shared, ocupados[w]); });
+    }
+    writeStage(salida, shared);
+
+    for (auto& hilo : hilos) {
+      hilo.join();
+    }
+    salida.flush();
+
+    m_stats.elapsed = seconds(inicio, Clock::now());
+    for (double ocupado : ocupados) {
+      m_stats.cipherBusy += ocupado;
+    }
+
+    if (shared.failed.load()) {
+      error = shared.error;
+      return false;
+    }
+    if (!salida) {
+      error = "No se pudo escribir en " + outPath;
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Measurements of the last run.
+   */
+  const Stats&
+  stats() const {
+    return m_stats;
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief A batch of lines tagged with its position in the file.
+   */
+  struct
+  Batch {
+    uint64_t sequence = 0;
+    uint64_t records = 0;
+    std::string data;
+  };
+
+  /**
+   * @brief State shared by the three stages of a run.
+   */
+  struct
+  Shared {
+    explicit Shared(size_t ventana)
+      : input(ventana), output(ventana), buffers(ventana * 2) {
+    }
+
+    BoundedQueue<Batch> input;            // Reader -> workers
+    BoundedQueue<Batch> output;           // Workers -> writer
+    BoundedQueue<std::string> buffers;    // Writer -> reader and workers, for reuse
+    std::atomic<uint64_t> written{ 0 };   // Batches already written
+    std::atomic<uint64_t> total{ 0 };     // Batches read, valid once readDone is set
+    std::atomic<bool> readDone{ false };  // The reader has queued its last batch
+    std::atomic<bool> failed{ false };    // Any stage failed; every stage stops
+    std::mutex errorMutex;                // Protects error
+    std::string error;                    // First failure
+    std::mutex waitMutex;                 // Pairs with progress
+    std::condition_variable progress;     // A queue, written, readDone or failed changed
+  };
+
+  // Intentos con yield antes de dormir en la variable de condicion
+  static constexpr int SPIN_ROUNDS = 64;
+
+  static double
+  seconds(Clock::time_point desde, Clock::time_point hasta) {
+    return std::chrono::duration<double>(hasta - desde).count();
+  }
+
+  static void
+  fail(Shared& shared, const std::string& error) {
+    std::lock_guard<std::mutex> lock(shared.errorMutex);
+    if (!shared.failed.load()) {
+      shared.error = error;
+      shared.failed.store(true);
+    }
+    notify(shared);
+  }
+
+  /**
+   * @brief Wakes the stages sleeping in waitFor after shared state changed.
+   * @details Taking the mutex orders the change before any waiter's last attempt, so a
+   *          stage cannot miss the notification between that attempt and its wait.
+   */
+  static void
+  notify(Shared& shared) {
+    {
+      std::lock_guard<std::mutex> lock(shared.waitMutex);
+    }
+    shared.progress.notify_all();
+  }
+
+  /**
+   * @brief Repeats an attempt until it succeeds or a stage fails.
+   * @details Spins briefly, since a batch is usually ready within microseconds, and then
+   *          sleeps on the condition variable until another stage reports progress.
+   * @param intento Tries once to make progress and returns true if it did.
+   * @return False if a stage failed before the attempt succeeded.
+   */
+  template<typename Intento>
+  static bool
+  waitFor(Shared& shared, Intento&& intento) {
+    for (int i = 0; i < SPIN_ROUNDS; ++i) {
+      if (intento()) {
+        return true;
+      }
+      if (shared.failed.load()) {
+        return false;
+      }
+      std::this_thread::yield();
+    }
+
+    std::unique_lock<std::mutex> lock(shared.waitMutex);
+    while (!intento()) {
+      if (shared.failed.load()) {
+        return false;
+      }
+      shared.progress.wait(lock);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Takes a buffer returned by the writer, or a new one.
+   */
+  static std::string
+  takeBuffer(Shared& shared) {
+    std::string buffer;
+    shared.buffers.tryPop(buffer);
+    buffer.clear();
+    return buffer;
+  }
+
+  /**
+   * @brief Reads batches ending on a line boundary and queues them for the workers.
+   */
+  void
+  readStage(std::ifstream& entrada, Shared& shared, size_t ventana) {
+    std::string resto;
+    uint64_t secuencia = 0;
+    double ocupado = 0;
+
+    try {
+      while (!shared.failed.load()) {
+        // No se adelanta mas de la ventana al escritor
+        if (!waitFor(shared, [&]() {
+              return secuencia < shared.written.load(std::memory_order_acquire) + ventana;
+            })) {
+          break;
+        }
+
+        auto t0 = Clock::now();
+        Batch lote;
+        lote.sequence = secuencia;
+        lote.data = takeBuffer(shared);
+        lote.data.swap(resto);
+        size_t previo = lote.data.size();
+        lote.data.resize(previo + m_batchSize);
+        entrada.read(&lote.data[previo], static_cast<std::streamsize>(m_batchSize));
+        size_t leidos = static_cast<size_t>(entrada.gcount());
+        lote.data.resize(previo + leidos);
+        m_stats.bytesIn += leidos;
+        bool fin = (leidos < m_batchSize);
+
+        if (!fin) {
+          // La linea incompleta del final pasa al siguiente lote
+          size_t salto = lote.data.rfind('\n');
+          if (salto == std::string::npos) {
+            resto.swap(lote.data);
+            ocupado += seconds(t0, Clock::now());
+            continue;
+          }
+          resto.assign(lote.data, salto + 1, std::string::npos);
+          lote.data.resize(salto + 1);
+        }
+        ocupado += seconds(t0, Clock::now());
+
+        if (!lote.data.empty()) {
+          if (!waitFor(shared, [&]() { return shared.input.tryPush(std::move(lote)); })) {
+            break;
+          }
+          notify(shared);
+          secuencia++;
+        }
+        if (fin) {
+          break;
+        }
+      }
+    }
+    catch (const std::exception& e) {
+      fail(shared, e.what());
+    }
+
+    if (entrada.bad()) {
+      fail(shared, "Error al leer el archivo de entrada");
+    }
+    m_stats.readBusy = ocupado;
+    m_stats.batches = secuencia;
+    shared.total.store(secuencia);
+    shared.readDone.store(true, std::memory_order_release);
+    notify(shared);
+  }
+
+  /**
+   * @brief Ciphers batches until the reader is done and the input queue is empty.
+   */
+  void
+  cipherStage(Shared& shared, double& ocupado) {
+    try {
+      Cifrador cifrador(m_cifrador);
+      std::string linea;
+      std::string resultado;
+      Batch entrada;
+
+      while (!shared.failed.load()) {
+        bool leido = false;
+        if (!waitFor(shared, [&]() {
+              bool terminado = shared.readDone.load(std::memory_order_acquire);
+              leido = shared.input.tryPop(entrada);
+              return leido || terminado;
+            }) || !leido) {
+          break;
+        }
+        notify(shared);
+
+        auto t0 = Clock::now();
+        Batch lote;
+        lote.sequence = entrada.sequence;
+        lote.data = takeBuffer(shared);
+        lote.data.reserve(m_encrypt ? entrada.data.size() * 2 : entrada.data.size());
+
+        RecordParser::forEachLine(entrada.data.data(), entrada.data.size(),
+                                  [&](const char* inicio, size_t longitud) {
+          if (longitud == 0) {
+            return;
+          }
+          linea.assign(inicio, longitud);
+          if (m_encrypt) {
+            // Mismo filtro que CargarArchivo
+            if (!RecordCipher::isRecord(linea)) {
+              return;
+            }
+            cifrador.encrypt(linea, resultado);
+          }
+          else {
+            // Mismo filtro que los metodos Descifrar
+            cifrador.decrypt(linea, resultado);
+            if (!RecordCipher::isRecord(resultado)) {
+              return;
+            }
+          }
+          lote.data += resultado;
+          lote.data += '\n';
+          lote.records++;
+        }, m_encrypt ? RecordParser::LineEnding::Plain : RecordParser::LineEnding::Encrypted);
+        shared.buffers.tryPush(std::move(entrada.data));
+        ocupado += seconds(t0, Clock::now());
+
+        if (!waitFor(shared, [&]() { return shared.output.tryPush(std::move(lote)); })) {
+          return;
+        }
+        notify(shared);
+      }
+    }
+    catch (const std::exception& e) {
+      fail(shared, e.what());
+    }
+  }
+
+  /**
+   * @brief Writes the batches in file order as they arrive from the workers.
+   */
+  void
+  writeStage(std::ofstream& salida, Shared& shared) {
+    // Lotes que llegaron antes que alguno anterior
+    std::vector<Batch> pendientes;
+    uint64_t siguiente = 0;
+    double ocupado = 0;
+    Batch lote;
+
+    try {
+      while (!shared.failed.load()) {
+        bool completo = false;
+        if (!waitFor(shared, [&]() {
+              completo = shared.readDone.load(std::memory_order_acquire) &&
+                         siguiente == shared.total.load();
+              return completo || shared.output.tryPop(lote);
+            }) || completo) {
+          break;
+        }
+        notify(shared);
+        pendientes.push_back(std::move(lote));
+
+        bool avanzo = true;
+        while (avanzo) {
+          avanzo = false;
+          for (size_t i = 0; i < pendientes.size(); ++i) {
+            if (pendientes[i].sequence != siguiente) {
+              continue;
+            }
+            auto t0 = Clock::now();
+            salida.write(pendientes[i].data.data(),
+                         static_cast<std::streamsize>(pendientes[i].data.size()));
+            ocupado += seconds(t0, Clock::now());
+            m_stats.records += pendientes[i].records;
+            m_stats.bytesOut += pendientes[i].data.size();
+            if (!salida) {
+              fail(shared, "Error al escribir el archivo de salida");
+            }
+
+            shared.buffers.tryPush(std::move(pendientes[i].data));
+            pendientes[i] = std::move(pendientes.back());
+            pendientes.pop_back();
+            siguiente++;
+            shared.written.store(siguiente, std::memory_order_release);
+            notify(shared);
+            avanzo = true;
+            break;
+          }
+        }
+      }
+    }
+    catch (const std::exception& e) {
+      fail(shared, e.what());
+    }
+    m_stats.writeBusy = ocupado;
+  }
+
+  Cifrador m_cifrador;        // Copied into every worker
+  bool m_encrypt;             // Direction of the run
+  unsigned int m_workers;     // Cipher threads
+  size_t m_batchSize;         // Bytes read per batch
+  Stats m_stats;              // Measurements of the last run
+};
@@ -0,0 +1,106 @@
+#pragma once
+#include "Prerequisites.h"
+
+/**
+ * @brief Fixed-size pool of worker threads fed from a shared task queue.
+ * @details Tasks are run in submission order by whichever worker is free. Each call to
+ *          submit returns a std::future, so callers can collect results in the order
+ *          they need regardless of which task finishes first.
+ */
+class
+ThreadPool {
+public:
+  /**
+   * @brief Starts the worker threads.
+   * @param threads Number of workers; 0 uses defaultThreads().
+   */
+  explicit ThreadPool(unsigned int threads = 0) {
+    if (threads == 0) {
+      threads = defaultThreads();
+    }
+    m_workers.reserve(threads);
+    for (unsigned int i = 0; i < threads; ++i) {
+      m_workers.emplace_back([this]() { workerLoop(); });
+    }
+  }
+
+  /**
+   * @brief Finishes the queued tasks and joins every worker.
+   */
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto& worker : m_workers) {
+      worker.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * @brief Queues a task for execution.
+   * @param task Callable without arguments.
+   * @return A future holding the task result or the exception it threw.
+   */
+  template<typename Task>
+  auto
+  submit(Task&& task) -> std::future<decltype(task())> {
+    using Result = decltype(task());
+    auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<Task>(task));
+    std::future<Result> result = packaged->get_future();
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_tasks.emplace([packaged]() { (*packaged)(); });
+    }
+    m_cv.notify_one();
+    return result;
+  }
+
+  /**
+   * @brief Returns the number of worker threads.
+   */
+  unsigned int
+  size() const {
+    return static_cast<unsigned int>(m_workers.size());
+  }
+
+  /**
+   * @brief Returns the number of hardware threads, at least 1.
+   */
+  static unsigned int
+  defaultThreads() {
+    unsigned int threads = std::thread::hardware_concurrency();
+    return threads == 0 ? 1 : threads;
+  }
+
+private:
+  /**
+   * @brief Takes tasks from the queue until the pool is stopped and empty.
+   */
+  void
+  workerLoop() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+        if (m_stop && m_tasks.empty()) {
+          return;
+        }
+        task = std::move(m_tasks.front());
+        m_tasks.pop();
+      }
+      task();
+    }
+  }
+
+  std::vector<std::thread> m_workers;        // Worker threads
+  std::queue<std::function<void()>> m_tasks; // Pending tasks
+  std::mutex m_mutex;                        // Protects m_tasks and m_stop
+  std::condition_variable m_cv;              // Signals new tasks or shutdown
+  bool m_stop = false;                       // Set by the destructor
+};
@@ -1,5 +1,7 @@
 #pragma once
 #include "Prerequisites.h"
+#include "VigenereCracker.h"
+#include "VigenereClimber.h"
 
 /**
  * @class Vigenere
@@ -117,6 +119,7 @@ public:
   * 
   * @summary This function evaluates how well a decoded text matches common English words.
   * @param text The text to be evaluated.
+  * @return The number of characters covered by common words; higher is better.
   */
   static double 
   fitness(const std::string& text) {
@@ -133,52 +136,55 @@ public:
         pos += word.length();
       }
     }
-
+    return score;
   }
 
   /*
-  * @brief Breaks the Vigenere cipher encryption using a brute-force attack.
+  * @brief Breaks the Vigenere cipher encryption without knowing the key.
   * 
-  * @summary This function attempts to find the best key for decrypting a given text by trying all possible keys up to a specified length.
+  * @summary Uses VigenereCracker: the key length comes from the coincidence rate of letters
+  *          that share a shift and each key letter from the chi-squared of its column, so keys
+  *          of any length up to maxKeyLenght are found in milliseconds.
   * @param text The encrypted text to be decoded.
   * @param maxKeyLenght The maximum length of the key to be tested.
-  * 
+  * @return The recovered key, empty if the text has no letters.
   */
   static std::string 
   breakEncryption(const std::string& text, int maxKeyLenght) {
-    std::string bestKey;
-    std::string bestText;
-    std::string trailKey;
-    
-    double bestScore = std::numeric_limits<double>::infinity(); // Initialize to infinity for minimization
+    VigenereCracker::Result resultado =
+      VigenereCracker::crack(text, static_cast<size_t>(std::max(1, maxKeyLenght)));
+    std::string bestText = resultado.key.empty() ? text : Vigenere(resultado.key).decode(text);
 
-    std::function<void(int, int)>dfs=[&](int pos, int maxLen) {
-      if (pos == maxLen) {
-        Vigenere v(trailKey);
-        std::string decodedText = v.decode(text);
-        double score = fitness(decodedText);
-        if (score < bestScore) {
-          bestScore = score;
-          bestKey = trailKey;
-          bestText = decodedText;
-        }
-        return;
-      }
-      for (char c = 'A'; c <= 'Z'; ++c) {
-        trailKey[pos] = c;
-        dfs(pos + 1, maxLen);
-      }
-    };
+    std::cout << "***BRUTE FORCE ATTACK VIGENERE ***\n";
+    std::cout << "Best key: " << resultado.key << "\n";
+    std::cout << "Best decoded text: " << bestText << "\n";
+    return resultado.key;
+  }
 
-    for (int len = 1; len <= maxKeyLenght; ++len) {
-      trailKey.assign(len, 'A');
-      dfs(0, len);
-    }
+  /*
+  * @brief Breaks a short Vigenere ciphertext with quadgram hill climbing.
+  * 
+  * @summary Meant for texts whose key columns have too few letters for frequency analysis.
+  *          The key found by VigenereCracker seeds the first restart of its length and
+  *          VigenereClimber searches every length up to maxKeyLenght in parallel.
+  * @param text The encrypted text to be decoded.
+  * @param maxKeyLenght The maximum length of the key to be tested.
+  * @param quadgrams Quadgram table of the plaintext language.
+  * @return The recovered key, empty if the text has fewer than four letters.
+  */
+  static std::string 
+  breakEncryption(const std::string& text, int maxKeyLenght, const QuadgramTable& quadgrams) {
+    size_t maximo = static_cast<size_t>(std::max(1, maxKeyLenght));
+    VigenereClimber::Options opciones;
+    opciones.maxLength = maximo;
+    VigenereClimber::Result resultado =
+      VigenereClimber::crack(text, quadgrams, opciones, VigenereCracker::crack(text, maximo).key);
+    std::string bestText = resultado.key.empty() ? text : Vigenere(resultado.key).decode(text);
 
-    std::cout << "***BRUTE FORCE ATTACK VIGENERE ***\n";
-    std::cout << "Best key: " << bestKey << "\n";
+    std::cout << "***HILL CLIMBING ATTACK VIGENERE ***\n";
+    std::cout << "Best key: " << resultado.key << "\n";
     std::cout << "Best decoded text: " << bestText << "\n";
-    return bestKey;
+    return resultado.key;
   }
 
 private:
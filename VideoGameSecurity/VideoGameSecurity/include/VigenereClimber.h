@@ -0,0 +1,267 @@
+#pragma once
+#include "Prerequisites.h"
+#include "QuadgramTable.h"
+#include "ThreadPool.h"
+
+/**
+ * @brief Vigenere key search by hill climbing on quadgram scores, for short ciphertexts.
+ * @details When every key column has only a handful of letters their frequencies say little,
+ *          but the plaintext still has to read like the language four letters at a time.
+ *          The search keeps the decrypted letters of the current key and its quadgram score.
+ *          Changing key letter j only changes the letters at positions j, j + L, ... and the
+ *          quadgrams that cover them, so every one of the 26 values of a key letter is scored
+ *          by re-adding just those quadgrams; the text is never decrypted again. A restart
+ *          climbs one letter at a time until no change helps, then repeatedly kicks one or
+ *          two letters to random values and climbs again, keeping the result when it is not
+ *          worse. Restarts of every key length are independent and run on the ThreadPool.
+ */
+class
+VigenereClimber {
+public:
+  /**
+   * @brief Search settings.
+   */
+  struct
+  Options {
+    size_t minLength = 1;           // Shortest key length tried
+    size_t maxLength = 20;          // Longest key length tried
+    unsigned int restarts = 0;      // Restarts per length, 0 for two per thread
+    unsigned int threads = 0;       // Worker threads, 0 for one per core
+    unsigned int kicks = 100;       // Random changes tried after each climb
+    uint64_t seed = 0x5EED;         // Seed of the random starts and kicks
+  };
+
+  /**
+   * @brief Outcome of a search.
+   */
+  struct
+  Result {
+    std::string key;                                       // Best key, uppercase
+    size_t keyLength = 0;                                  // Chosen key length
+    double log10Probability = 0;                           // Mean per quadgram of the plaintext
+    std::vector<std::pair<size_t, double>> lengthScores;   // Mean per quadgram of each length
+    uint64_t evaluations = 0;                              // Key letters scored in total
+  };
+
+  /**
+   * @brief Searches the key of a text encrypted in a single Vigenere::encode call.
+   * @param text The ciphertext.
+   * @param table Quadgram table of the plaintext language.
+   * @param options Search settings.
+   * @param startKey Key the first restart of its length begins from, for example the
+   *                 one found by VigenereCracker; may be empty.
+   * @return The key; empty if the text has fewer than four letters or the table is empty.
+   */
+  static Result
+  crack(std::string_view text, const QuadgramTable& table, const Options& options,
+        const std::string& startKey = std::string()) {
+    Result result;
+    std::vector<uint8_t> letras;
+    for (char c : text) {
+      int letra = QuadgramTable::letterIndex(c);
+      if (letra >= 0) {
+        letras.push_back(static_cast<uint8_t>(letra));
+      }
+    }
+    size_t cuadrigramas = letras.size() >= 4 ? letras.size() - 3 : 0;
+    if (cuadrigramas == 0 || table.empty()) {
+      return result;
+    }
+
+    unsigned int hilos = options.threads != 0 ? options.threads : ThreadPool::defaultThreads();
+    unsigned int reinicios = options.restarts != 0 ? options.restarts : 2 * hilos;
+    size_t minimo = std::max<size_t>(1, options.minLength);
+    // Con muy pocas letras por columna cualquier texto cabe: la clave no pasa de ese limite
+    size_t maximo = std::min(std::max(minimo, options.maxLength),
+                             std::max<size_t>(1, letras.size() / MIN_COLUMN_LETTERS));
+    minimo = std::min(minimo, maximo);
+
+    // Una tarea por reinicio y longitud; las mas largas primero porque tardan mas
+    struct Tarea {
+      size_t longitud;
+      std::future<Climb> futuro;
+    };
+    std::vector<Tarea> tareas;
+    {
+      ThreadPool pool(hilos);
+      for (size_t L = maximo; L >= minimo; --L) {
+        for (unsigned int r = 0; r < reinicios; ++r) {
+          std::string inicio;
+          if (r == 0 && startKey.size() == L) {
+            inicio = startKey;
+          }
+          uint64_t semilla = options.seed ^ (L * 0x9E3779B97F4A7C15ull + r);
+          tareas.push_back({ L, pool.submit([&letras, &table, L, inicio, semilla, &options]() {
+            return climb(letras, table, L, inicio, semilla, options.kicks);
+          }) });
+        }
+        if (L == minimo) {
+          break;
+        }
+      }
+      for (Tarea& tarea : tareas) {
+        tarea.futuro.wait();
+      }
+    }
+
+    std::vector<Climb> mejores(maximo + 1);
+    for (Tarea& tarea : tareas) {
+      Climb subida = tarea.futuro.get();
+      result.evaluations += subida.evaluations;
+      if (mejores[tarea.longitud].key.empty() || subida.score > mejores[tarea.longitud].score) {
+        mejores[tarea.longitud] = std::move(subida);
+      }
+    }
+
+    // Los multiplos de la clave puntuan igual y cada letra extra ajusta algo mejor el texto:
+    // cada letra de la clave se cobra con una penalizacion fija y gana la mas corta en empate
+    double mejor = -std::numeric_limits<double>::infinity();
+    for (size_t L = minimo; L <= maximo; ++L) {
+      double total = table.log10Probability(mejores[L].score, cuadrigramas);
+      result.lengthScores.push_back({ L, total / cuadrigramas });
+      if (total - LENGTH_PENALTY * L > mejor) {
+        mejor = total - LENGTH_PENALTY * L;
+        result.keyLength = L;
+        result.log10Probability = total / cuadrigramas;
+      }
+    }
+    result.key = mejores[result.keyLength].key;
+    return result;
+  }
+
+  /**
+   * @brief Searches with the default settings.
+   */
+  static Result
+  crack(std::string_view text, const QuadgramTable& table) {
+    return crack(text, table, Options());
+  }
+
+private:
+  // Letras de texto minimas por letra de la clave
+  static constexpr size_t MIN_COLUMN_LETTERS = 4;
+
+  // Log10 de probabilidad que debe ganar el texto por cada letra mas de la clave
+  static constexpr double LENGTH_PENALTY = 1.5;
+
+  /**
+   * @brief Best key of one restart.
+   */
+  struct
+  Climb {
+    std::string key;
+    uint64_t score = 0;
+    uint64_t evaluations = 0;
+  };
+
+  /**
+   * @brief One restart: random or given start, climb, then kicks.
+   */
+  static Climb
+  climb(const std::vector<uint8_t>& cipher, const QuadgramTable& table, size_t L,
+        const std::string& start, uint64_t seed, unsigned int kicks) {
+    const size_t n = cipher.size();
+    const uint8_t* q = table.data();
+
+    // Cuadrigramas que cambian con cada letra de la clave, sin repetir
+    std::vector<std::vector<uint32_t>> afectados(L);
+    for (size_t j = 0; j < L; ++j) {
+      for (size_t i = j; i < n; i += L) {
+        size_t desde = i >= 3 ? i - 3 : 0;
+        for (size_t s = desde; s <= i && s + 3 < n; ++s) {
+          if (afectados[j].empty() || afectados[j].back() < s) {
+            afectados[j].push_back(static_cast<uint32_t>(s));
+          }
+        }
+      }
+    }
+
+    std::mt19937_64 azar(seed);
+    std::vector<uint8_t> clave(L);
+    for (size_t j = 0; j < L; ++j) {
+      clave[j] = j < start.size() && start[j] >= 'A' && start[j] <= 'Z'
+               ? static_cast<uint8_t>(start[j] - 'A')
+               : static_cast<uint8_t>(azar() % 26);
+    }
+    std::vector<uint8_t> plano(n);
+    for (size_t i = 0; i < n; ++i) {
+      plano[i] = static_cast<uint8_t>((cipher[i] + 26 - clave[i % L]) % 26);
+    }
+
+    Climb result;
+    auto sumar = [&](size_t j) {
+      uint64_t suma = 0;
+      for (uint32_t s : afectados[j]) {
+        suma += q[QuadgramTable::index(plano.data() + s)];
+      }
+      return suma;
+    };
+    auto poner = [&](size_t j, uint8_t letra) {
+      clave[j] = letra;
+      for (size_t i = j; i < n; i += L) {
+        plano[i] = static_cast<uint8_t>((cipher[i] + 26 - letra) % 26);
+      }
+    };
+
+    // Sube letra por letra hasta que ningun cambio mejora el puntaje
+    uint64_t puntaje = table.score(plano.data(), n);
+    auto subir = [&]() {
+      bool mejoro = true;
+      while (mejoro) {
+        mejoro = false;
+        for (size_t j = 0; j < L; ++j) {
+          uint8_t actual = clave[j];
+          uint64_t base = sumar(j);
+          uint64_t mejorSuma = base;
+          uint8_t mejorLetra = actual;
+          for (uint8_t letra = 0; letra < 26; ++letra) {
+            if (letra == actual) {
+              continue;
+            }
+            poner(j, letra);
+            uint64_t suma = sumar(j);
+            if (suma > mejorSuma) {
+              mejorSuma = suma;
+              mejorLetra = letra;
+            }
+          }
+          result.evaluations += 25;
+          poner(j, mejorLetra);
+          if (mejorLetra != actual) {
+            puntaje = puntaje - base + mejorSuma;
+            mejoro = true;
+          }
+        }
+      }
+    };
+
+    subir();
+    for (unsigned int k = 0; k < kicks; ++k) {
+      std::vector<uint8_t> claveAnterior = clave;
+      uint64_t puntajeAnterior = puntaje;
+      size_t cambios = 1 + azar() % std::min<size_t>(2, L);
+      for (size_t c = 0; c < cambios; ++c) {
+        size_t j = azar() % L;
+        uint64_t antes = sumar(j);
+        poner(j, static_cast<uint8_t>(azar() % 26));
+        puntaje = puntaje - antes + sumar(j);
+      }
+      subir();
+      if (puntaje < puntajeAnterior) {
+        for (size_t j = 0; j < L; ++j) {
+          if (clave[j] != claveAnterior[j]) {
+            poner(j, claveAnterior[j]);
+          }
+        }
+        puntaje = puntajeAnterior;
+      }
+    }
+
+    result.key.resize(L);
+    for (size_t j = 0; j < L; ++j) {
+      result.key[j] = static_cast<char>('A' + clave[j]);
+    }
+    result.score = puntaje;
+    return result;
+  }
+};
@@ -0,0 +1,341 @@
+#pragma once
+#include "Prerequisites.h"
+#include "FrequencyAnalysis.h"
+#include "CaesarCracker.h"
+#include "MappedFile.h"
+#include "RecordParser.h"
+
+/**
+ * @brief Recovers Vigenere keys with the index of coincidence and chi-squared columns.
+ * @details With a key of L letters, letter i of the text was shifted by key letter i % L.
+ *          Two letters L apart therefore share their shift, and they are equal about as
+ *          often as two letters of the language (0.07); letters at any other distance mix
+ *          two shifts and coincide about as often as random text (0.038). The key length is
+ *          the shortest distance whose coincidence rate is close to the best one, which is
+ *          the periodic form of the Kasiski examination. The letters are then split into L
+ *          columns and each column is solved like a Caesar cipher by rotating its histogram
+ *          against the language frequencies (CaesarCracker), so the whole attack works on
+ *          letter counts and never decrypts a candidate.
+ *
+ *          FileProtector::CifrarVigenere encrypts every record on its own, so the key starts
+ *          again at the first letter of each line. crackLines counts letters by their index
+ *          within the line once; the coincidence rate of a distance is computed between the
+ *          histograms of every pair of indexes that far apart, and the columns of a length
+ *          are those histograms folded together.
+ */
+class
+VigenereCracker {
+public:
+  /**
+   * @brief Outcome of an attack.
+   */
+  struct
+  Result {
+    std::string key;                                       // Recovered key, uppercase
+    size_t keyLength = 0;                                  // Chosen key length
+    double indexOfCoincidence = 0;                         // Mean index of the key columns
+    FrequencyAnalysis::Language language = FrequencyAnalysis::Language::English;   // Best language
+    std::vector<std::pair<size_t, double>> lengthScores;   // Coincidence rate of letters each length apart
+  };
+
+  /**
+   * @brief Count of each letter A-Z.
+   */
+  using Histogram = std::array<size_t, 26>;
+
+  /**
+   * @brief Cracks one text encrypted in a single Vigenere::encode call.
+   * @param text The ciphertext.
+   * @param maxLength Longest key length tried.
+   * @param languages Languages the plaintext may be in.
+   * @return The key; empty if the text has no letters.
+   */
+  static Result
+  crack(std::string_view text, size_t maxLength = 40,
+        const std::vector<FrequencyAnalysis::Language>& languages = CaesarCracker::defaultLanguages()) {
+    Result result;
+    std::vector<uint8_t> letras;
+    letras.reserve(text.size());
+    for (char c : text) {
+      int indice = letterIndex(c);
+      if (indice >= 0) {
+        letras.push_back(static_cast<uint8_t>(indice));
+      }
+    }
+    if (letras.empty() || maxLength == 0) {
+      return result;
+    }
+
+    // La longitud se estima con una muestra; las columnas se resuelven con todo el texto
+    size_t muestra = std::min(letras.size(), LENGTH_SAMPLE);
+    for (size_t L = 1; L <= maxLength; ++L) {
+      size_t iguales = 0;
+      size_t pares = 0;
+      for (size_t i = 0; i + L < muestra; ++i) {
+        iguales += letras[i] == letras[i + L];
+        pares++;
+      }
+      result.lengthScores.push_back({ L, pares > 0 ? static_cast<double>(iguales) / pares : 0 });
+    }
+
+    result.keyLength = chooseLength(result.lengthScores, letras.size());
+    std::vector<Histogram> columnas(result.keyLength, Histogram{});
+    for (size_t i = 0; i < letras.size(); ++i) {
+      columnas[i % result.keyLength][letras[i]]++;
+    }
+    solveColumns(columnas, languages, result);
+    return result;
+  }
+
+  /**
+   * @brief Cracks lines encrypted one by one, as FileProtector::CifrarVigenere does.
+   * @param lines The encrypted lines; the key restarts on every line.
+   * @param maxLength Longest key length tried.
+   * @param languages Languages the plaintext may be in.
+   * @return The key; empty if the lines have no letters.
+   */
+  static Result
+  crackLines(const std::vector<std::string_view>& lines, size_t maxLength = 40,
+             const std::vector<FrequencyAnalysis::Language>& languages = CaesarCracker::defaultLanguages()) {
+    Result result;
+    if (maxLength == 0) {
+      return result;
+    }
+    std::vector<Histogram> posiciones = positionHistograms(lines, MAX_POSITIONS);
+    if (posiciones.empty()) {
+      return result;
+    }
+
+    for (size_t L = 1; L <= maxLength; ++L) {
+      result.lengthScores.push_back({ L, coincidence(posiciones, L) });
+    }
+
+    result.keyLength = chooseLength(result.lengthScores, posiciones.size());
+    std::vector<Histogram> columnas;
+    if (posiciones.size() < MAX_POSITIONS) {
+      fold(posiciones, result.keyLength, columnas);
+    }
+    else {
+      // Hay lineas mas largas que las posiciones contadas: las columnas se cuentan completas
+      columnas.assign(result.keyLength, Histogram{});
+      for (std::string_view linea : lines) {
+        size_t c = 0;
+        for (char ch : linea) {
+          int indice = letterIndex(ch);
+          if (indice >= 0) {
+            columnas[c][indice]++;
+            if (++c == result.keyLength) {
+              c = 0;
+            }
+          }
+        }
+      }
+    }
+    solveColumns(columnas, languages, result);
+    return result;
+  }
+
+  /**
+   * @brief Cracks a file written by FileProtector::CifrarVigenere.
+   * @param path Path of the encrypted file.
+   * @param result Receives the key.
+   * @param maxLength Longest key length tried.
+   * @return False if the file could not be read or has no letters.
+   */
+  static bool
+  crackFile(const std::string& path, Result& result, size_t maxLength = 40) {
+    MappedFile archivo;
+    if (!archivo.open(path)) {
+      return false;
+    }
+    std::vector<std::string_view> lineas;
+    RecordParser::forEachLine(archivo.data(), archivo.size(), [&lineas](const char* linea, size_t longitud) {
+      if (longitud > 0) {
+        lineas.emplace_back(linea, longitud);
+      }
+    }, RecordParser::LineEnding::Encrypted);
+    result = crackLines(lineas, maxLength);
+    return !result.key.empty();
+  }
+
+  /**
+   * @brief Counts the letters of every line by their index among the letters of the line.
+   * @param lines The lines.
+   * @param maxPositions Letters after this index are not counted.
+   * @return One histogram per index, up to the longest line.
+   */
+  static std::vector<Histogram>
+  positionHistograms(const std::vector<std::string_view>& lines, size_t maxPositions) {
+    std::vector<Histogram> posiciones;
+    for (std::string_view linea : lines) {
+      size_t p = 0;
+      for (char c : linea) {
+        int indice = letterIndex(c);
+        if (indice < 0) {
+          continue;
+        }
+        if (p == maxPositions) {
+          break;
+        }
+        if (p == posiciones.size()) {
+          posiciones.push_back(Histogram{});
+        }
+        posiciones[p++][indice]++;
+      }
+    }
+    return posiciones;
+  }
+
+private:
+  // Letras usadas para estimar la longitud de un texto continuo
+  static constexpr size_t LENGTH_SAMPLE = 1 << 16;
+
+  // Posiciones por linea contadas por separado
+  static constexpr size_t MAX_POSITIONS = 1024;
+
+  // Fraccion de la mejor coincidencia que debe alcanzar la longitud elegida
+  static constexpr double LENGTH_MARGIN = 0.85;
+
+  // Coincidencia minima de letras con el mismo desplazamiento; el texto aleatorio da 0.038
+  static constexpr double MIN_COINCIDENCE = 0.05;
+
+  /**
+   * @brief Index 0-25 of an ASCII letter of either case, -1 for anything else.
+   */
+  static int
+  letterIndex(char c) {
+    unsigned char u = static_cast<unsigned char>(c);
+    if (u >= 'A' && u <= 'Z') {
+      return u - 'A';
+    }
+    if (u >= 'a' && u <= 'z') {
+      return u - 'a';
+    }
+    return -1;
+  }
+
+  /**
+   * @brief Adds the position histograms into L columns.
+   */
+  static void
+  fold(const std::vector<Histogram>& positions, size_t L, std::vector<Histogram>& columns) {
+    columns.assign(L, Histogram{});
+    for (size_t p = 0; p < positions.size(); ++p) {
+      Histogram& columna = columns[p % L];
+      for (int c = 0; c < 26; ++c) {
+        columna[c] += positions[p][c];
+      }
+    }
+  }
+
+  /**
+   * @brief Index of coincidence of the columns, weighted by their letter counts.
+   */
+  static double
+  meanIndex(const std::vector<Histogram>& columns) {
+    double suma = 0;
+    double pesos = 0;
+    for (const Histogram& columna : columns) {
+      size_t total = 0;
+      for (size_t n : columna) {
+        total += n;
+      }
+      if (total < 2) {
+        continue;
+      }
+      suma += FrequencyAnalysis::indexOfCoincidence(columna, total) * total;
+      pesos += static_cast<double>(total);
+    }
+    return pesos > 0 ? suma / pesos : 0;
+  }
+
+  /**
+   * @brief Rate at which letters at indexes p and p + L of the same line are equal.
+   */
+  static double
+  coincidence(const std::vector<Histogram>& positions, size_t L) {
+    double iguales = 0;
+    double pares = 0;
+    for (size_t p = 0; p + L < positions.size(); ++p) {
+      const Histogram& a = positions[p];
+      const Histogram& b = positions[p + L];
+      size_t na = 0;
+      size_t nb = 0;
+      for (int c = 0; c < 26; ++c) {
+        iguales += static_cast<double>(a[c]) * b[c];
+        na += a[c];
+        nb += b[c];
+      }
+      pares += static_cast<double>(na) * nb;
+    }
+    return pares > 0 ? iguales / pares : 0;
+  }
+
+  /**
+   * @brief Shortest length whose coincidence rate is close to the best one.
+   * @details Every multiple of the key length repeats the shift too, so each length is
+   *          scored with the mean rate of its multiples; on short texts this averages out
+   *          the noise that would otherwise let a multiple beat the true length.
+   * @param scores Coincidence rate of each length, starting at 1.
+   * @param letters Letters of the longest line; the length used when no distance repeats
+   *                the shift, which happens when the key is longer than the text.
+   */
+  static size_t
+  chooseLength(const std::vector<std::pair<size_t, double>>& scores, size_t letters) {
+    std::vector<double> medias(scores.size(), 0);
+    double mejor = 0;
+    for (size_t L = 1; L <= scores.size(); ++L) {
+      double suma = 0;
+      size_t n = 0;
+      for (size_t m = L; m <= scores.size(); m += L) {
+        suma += scores[m - 1].second;
+        n++;
+      }
+      medias[L - 1] = suma / n;
+      mejor = std::max(mejor, medias[L - 1]);
+    }
+    if (mejor < MIN_COINCIDENCE) {
+      return std::max<size_t>(1, std::min(letters, scores.size()));
+    }
+    for (size_t L = 1; L <= medias.size(); ++L) {
+      if (medias[L - 1] >= mejor * LENGTH_MARGIN) {
+        return L;
+      }
+    }
+    return 1;
+  }
+
+  /**
+   * @brief Solves every column as a Caesar cipher in the language that fits them best.
+   * @details Columns without letters keep 'A'; no letter of the input uses them.
+   */
+  static void
+  solveColumns(const std::vector<Histogram>& columns,
+               const std::vector<FrequencyAnalysis::Language>& languages, Result& result) {
+    double mejorTotal = std::numeric_limits<double>::infinity();
+    std::array<double, 26> chi;
+    for (FrequencyAnalysis::Language idioma : languages) {
+      std::string clave(columns.size(), 'A');
+      double total = 0;
+      for (size_t c = 0; c < columns.size(); ++c) {
+        size_t letras = 0;
+        for (size_t n : columns[c]) {
+          letras += n;
+        }
+        if (letras == 0) {
+          continue;
+        }
+        CaesarCracker::scoreShifts(columns[c], letras, idioma, chi);
+        int mejor = static_cast<int>(std::min_element(chi.begin(), chi.end()) - chi.begin());
+        clave[c] = static_cast<char>('A' + mejor);
+        total += chi[mejor];
+      }
+      if (total < mejorTotal) {
+        mejorTotal = total;
+        result.key = clave;
+        result.language = idioma;
+      }
+    }
+    result.indexOfCoincidence = meanIndex(columns);
+  }
+};
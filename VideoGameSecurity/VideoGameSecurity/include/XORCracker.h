@@ -0,0 +1,567 @@
+#pragma once
+#include "Prerequisites.h"
+#include "FrequencyAnalysis.h"
+#include "MappedFile.h"
+#include "RecordParser.h"
+#include "RecordCipher.h"
+
+/**
+ * @brief Recovers repeating XOR keys of any length from files written by
+ *        FileProtector::CifrarXOR.
+ * @details CifrarXOR encrypts every record line on its own, starting again at the first key
+ *          byte, so byte j of every line was XORed with key byte j % L. Because the key
+ *          restarts on every line, bytes at the same position of different lines share the
+ *          key byte whatever L is, and records are so regular by position that the classic
+ *          index of coincidence and Hamming tests favour long lengths. The length is found
+ *          instead from the key itself: the key byte of every line position is estimated on
+ *          its own, and L is the shortest period after which those estimates repeat. The
+ *          bytes of all lines are then sorted into L columns and each column is solved
+ *          independently: key bytes that turn the column into non-text are discarded and
+ *          the rest are ranked with the FrequencyAnalysis log-likelihood. Every step works
+ *          on byte counts gathered in one pass, so the cost grows linearly with the input.
+ *
+ *          The known-plaintext attack uses the record structure instead of letter
+ *          frequencies: records end in predictable text such as "@gmail.com", so every line
+ *          gives the key bytes under its last bytes directly. The votes of all lines are
+ *          added up by line position once and folded into the columns of each key length.
+ *          The key of each length is checked against a sample of the file, counting the
+ *          lines that decrypt to records with both ':' separators and a known ending.
+ */
+class
+XORCracker {
+public:
+  /**
+   * @brief Outcome of an attack.
+   */
+  struct
+  Result {
+    std::string key;                                       // Recovered key
+    size_t keyLength = 0;                                  // Chosen key length
+    double validRecords = 0;                               // Fraction of lines that decrypt to records
+    double cribMatches = 0;                                // Fraction of lines that end in a crib
+    std::vector<std::pair<size_t, double>> lengthScores;   // Score of each length tried
+  };
+
+  /**
+   * @brief How the key is searched.
+   */
+  enum class Attack {
+    Frequency,   // Letter frequencies of each column
+    Crib         // Known record endings, with frequencies for the columns they miss
+  };
+
+  /**
+   * @brief Endings found in the others field of common records, used as cribs.
+   */
+  static const std::vector<std::string>&
+  defaultCribs() {
+    static const std::vector<std::string> cribs = {
+      "@gmail.com", "@hotmail.com", "@yahoo.com", "@outlook.com", "@live.com",
+      "@icloud.com", "@protonmail.com", "@aol.com", ".com", ".net", ".org", ".es", ".mx"
+    };
+    return cribs;
+  }
+
+  /**
+   * @brief Counts of each byte value per key column.
+   */
+  using Histogram = std::array<uint64_t, 256>;
+
+  /**
+   * @brief Reads the encrypted lines of a file.
+   * @param file Mapped file; the returned views point into it.
+   * @param lines Receives the non-empty lines.
+   */
+  static void
+  splitLines(const MappedFile& file, std::vector<std::string_view>& lines) {
+    lines.clear();
+    RecordParser::forEachLine(file.data(), file.size(), [&lines](const char* linea, size_t longitud) {
+      if (longitud > 0) {
+        lines.emplace_back(linea, longitud);
+      }
+    }, RecordParser::LineEnding::Encrypted);
+  }
+
+  /**
+   * @brief Byte counts of each key column for a key length.
+   * @param lines Encrypted lines.
+   * @param keyLength Candidate key length.
+   */
+  static std::vector<Histogram>
+  columnHistograms(const std::vector<std::string_view>& lines, size_t keyLength) {
+    std::vector<Histogram> columnas(keyLength, Histogram{});
+    for (std::string_view linea : lines) {
+      size_t columna = 0;
+      for (char c : linea) {
+        columnas[columna][static_cast<unsigned char>(c)]++;
+        if (++columna == keyLength) {
+          columna = 0;
+        }
+      }
+    }
+    return columnas;
+  }
+
+  /**
+   * @brief Estimates the key byte of every line position on its own.
+   * @param lines Encrypted lines.
+   * @param maxPositions Highest number of positions estimated.
+   * @param language Expected plaintext language.
+   * @return Key byte of each position, or -1 where too few lines reach it.
+   */
+  static std::vector<int>
+  positionKeys(const std::vector<std::string_view>& lines, size_t maxPositions,
+               FrequencyAnalysis::Language language) {
+    size_t largo = 0;
+    for (std::string_view linea : lines) {
+      largo = std::max(largo, linea.size());
+    }
+    largo = std::min(largo, maxPositions);
+    std::vector<int> claves(largo, -1);
+    if (largo == 0) {
+      return claves;
+    }
+
+    std::vector<Histogram> posiciones = columnHistograms(lines, largo);
+    uint64_t minimo = std::max<uint64_t>(MIN_POSITION_SAMPLES, lines.size() / 100);
+    for (size_t p = 0; p < largo; ++p) {
+      uint64_t total = 0;
+      for (uint64_t n : posiciones[p]) {
+        total += n;
+      }
+      if (total >= minimo) {
+        claves[p] = solveColumn(posiciones[p], language);
+      }
+    }
+    return claves;
+  }
+
+  /**
+   * @brief How well the position keys repeat with each period.
+   * @param keys Key byte estimated for each position, -1 where unknown.
+   * @param maxLength Longest key length tried.
+   * @return (length, agreement) pairs: the fraction of known positions j >= L whose key
+   *         byte equals the one at j - L. Lengths without such pairs are left out.
+   */
+  static std::vector<std::pair<size_t, double>>
+  keyLengthScores(const std::vector<int>& keys, size_t maxLength) {
+    std::vector<std::pair<size_t, double>> result;
+    for (size_t longitud = 1; longitud <= maxLength && longitud < keys.size(); ++longitud) {
+      size_t pares = 0;
+      size_t iguales = 0;
+      for (size_t j = longitud; j < keys.size(); ++j) {
+        if (keys[j] < 0 || keys[j - longitud] < 0) {
+          continue;
+        }
+        pares++;
+        if (keys[j] == keys[j - longitud]) {
+          iguales++;
+        }
+      }
+      if (pares >= MIN_PERIOD_PAIRS) {
+        result.push_back({ longitud, static_cast<double>(iguales) / pares });
+      }
+    }
+    return result;
+  }
+
+  /**
+   * @brief Picks the key length from the period agreement of each length.
+   * @details Multiples of the true length agree as well as the length itself, so the
+   *          shortest length close to the best agreement is chosen.
+   * @param scores Agreement of each length.
+   * @param positions Length returned when no period is found.
+   */
+  static size_t
+  chooseKeyLength(const std::vector<std::pair<size_t, double>>& scores, size_t positions) {
+    double mejor = 0;
+    for (const auto& s : scores) {
+      mejor = std::max(mejor, s.second);
+    }
+    if (mejor < MIN_AGREEMENT) {
+      // La clave no se repite dentro de las lineas: es al menos tan larga como ellas
+      return positions;
+    }
+    for (const auto& s : scores) {
+      if (s.second >= mejor * LENGTH_MARGIN) {
+        return s.first;
+      }
+    }
+    return positions;
+  }
+
+  /**
+   * @brief Finds the most likely key byte of a column.
+   * @param column Byte counts of the column.
+   * @param language Expected plaintext language.
+   */
+  static unsigned char
+  solveColumn(const Histogram& column, FrequencyAnalysis::Language language) {
+    const std::array<double, 256>& logaritmos = FrequencyAnalysis::logTable(language);
+    std::vector<unsigned char> valores;
+    for (int b = 0; b < 256; ++b) {
+      if (column[b] != 0) {
+        valores.push_back(static_cast<unsigned char>(b));
+      }
+    }
+
+    // Se toleran unos pocos bytes que no son texto, de lineas partidas
+    // por un salto de linea dentro del cifrado
+    const std::array<bool, 256>& imprimible = FrequencyAnalysis::printableTable();
+    uint64_t total = 0;
+    for (unsigned char v : valores) {
+      total += column[v];
+    }
+    uint64_t tolerancia = total / 100;
+
+    unsigned char mejorClave = 0;
+    double mejorPuntaje = -std::numeric_limits<double>::infinity();
+    for (int k = 0; k < 256; ++k) {
+      double puntaje = 0;
+      uint64_t invalidos = 0;
+      for (unsigned char v : valores) {
+        if (!imprimible[v ^ k]) {
+          invalidos += column[v];
+        }
+        puntaje += column[v] * logaritmos[v ^ k];
+      }
+      if (invalidos <= tolerancia && puntaje > mejorPuntaje) {
+        mejorPuntaje = puntaje;
+        mejorClave = static_cast<unsigned char>(k);
+      }
+    }
+    // Si ninguna clave deja la columna como texto se usa la de mayor puntaje
+    if (mejorPuntaje == -std::numeric_limits<double>::infinity()) {
+      for (int k = 0; k < 256; ++k) {
+        double puntaje = 0;
+        for (unsigned char v : valores) {
+          puntaje += column[v] * logaritmos[v ^ k];
+        }
+        if (puntaje > mejorPuntaje) {
+          mejorPuntaje = puntaje;
+          mejorClave = static_cast<unsigned char>(k);
+        }
+      }
+    }
+    return mejorClave;
+  }
+
+  /**
+   * @brief Recovers the key of a set of encrypted lines.
+   * @param lines Encrypted lines, each one starting at the first key byte.
+   * @param maxLength Longest key length tried.
+   * @param language Expected plaintext language.
+   */
+  static Result
+  crack(const std::vector<std::string_view>& lines, size_t maxLength = 40,
+        FrequencyAnalysis::Language language = FrequencyAnalysis::Language::English) {
+    Result result;
+    if (lines.empty() || maxLength == 0) {
+      return result;
+    }
+    std::vector<int> posiciones = positionKeys(lines, MAX_POSITIONS, language);
+    result.lengthScores = keyLengthScores(posiciones, maxLength);
+    result.keyLength = chooseKeyLength(result.lengthScores, std::min(knownPrefix(posiciones), maxLength));
+    if (result.keyLength == 0) {
+      return result;
+    }
+
+    for (const Histogram& columna : columnHistograms(lines, result.keyLength)) {
+      result.key += static_cast<char>(solveColumn(columna, language));
+    }
+    result.validRecords = validFraction(lines, result.key);
+    return result;
+  }
+
+  /**
+   * @brief Recovers the key of a set of encrypted lines from known record endings.
+   * @details Each line votes, for every crib, for the key bytes that would turn its last
+   *          bytes into the crib. Wrong cribs scatter their votes while the right ones agree,
+   *          and endings that share text (".com", "mail.com") add up on the true key byte.
+   *          A second pass keeps only the crib of each line that best fits the first
+   *          consensus. Columns no crib reaches are solved by letter frequency.
+   * @param lines Encrypted lines, each one starting at the first key byte.
+   * @param maxLength Longest key length tried.
+   * @param cribs Expected record endings.
+   * @param language Expected plaintext language, for the columns without votes.
+   */
+  static Result
+  crackWithCribs(const std::vector<std::string_view>& lines, size_t maxLength = 40,
+                 const std::vector<std::string>& cribs = defaultCribs(),
+                 FrequencyAnalysis::Language language = FrequencyAnalysis::Language::English) {
+    Result result;
+    if (lines.empty() || maxLength == 0 || cribs.empty()) {
+      return result;
+    }
+
+    // Votos por posicion de linea, independientes de la longitud de la clave. En la
+    // primera vuelta vota cada crib; en la segunda cada linea vota solo con el crib que
+    // mejor coincide con el consenso de la primera
+    size_t largo = 0;
+    for (std::string_view linea : lines) {
+      largo = std::max(largo, linea.size());
+    }
+    std::vector<Histogram> votos(largo, Histogram{});
+    for (std::string_view linea : lines) {
+      for (const std::string& crib : cribs) {
+        addCribVotes(linea, crib, votos);
+      }
+    }
+    std::vector<int> posiciones = voteWinners(votos);
+
+    std::fill(votos.begin(), votos.end(), Histogram{});
+    for (std::string_view linea : lines) {
+      const std::string* elegido = nullptr;
+      long mejorAcuerdo = MIN_CRIB_AGREEMENT - 1;
+      for (const std::string& crib : cribs) {
+        if (crib.size() > linea.size()) {
+          continue;
+        }
+        size_t inicio = linea.size() - crib.size();
+        long acuerdo = 0;
+        for (size_t i = 0; i < crib.size(); ++i) {
+          int k = posiciones[inicio + i];
+          if (k >= 0) {
+            acuerdo += ((linea[inicio + i] ^ crib[i]) & 0xFF) == k ? 1 : -1;
+          }
+        }
+        if (acuerdo > mejorAcuerdo) {
+          mejorAcuerdo = acuerdo;
+          elegido = &crib;
+        }
+      }
+      if (elegido) {
+        addCribVotes(linea, *elegido, votos);
+      }
+    }
+
+    // Cada longitud arma su clave con los votos de las posiciones que caen en cada
+    // columna y se comprueba contra el archivo: registros con sus dos ':' y finales
+    // conocidos. Los multiplos de la longitud real descifran igual, gana la mas corta.
+    // Para comprobar basta una muestra repartida por todo el archivo; el paso es impar
+    // porque las lineas partidas por un '\n' del cifrado suelen alternar
+    std::vector<std::string_view> muestra;
+    size_t paso = (lines.size() + VERIFY_LINES - 1) / VERIFY_LINES | 1;
+    for (size_t i = 0; i < lines.size(); i += paso) {
+      muestra.push_back(lines[i]);
+    }
+    std::vector<std::string> claves;
+    double mejor = 0;
+    for (size_t longitud = 1; longitud <= maxLength; ++longitud) {
+      claves.push_back(keyFromVotes(muestra, votos, longitud, language));
+      double puntaje = validFraction(muestra, claves.back()) + cribFraction(muestra, claves.back(), cribs);
+      result.lengthScores.push_back({ longitud, puntaje });
+      mejor = std::max(mejor, puntaje);
+    }
+    for (const auto& s : result.lengthScores) {
+      if (s.second >= mejor * CRIB_MARGIN) {
+        result.keyLength = s.first;
+        break;
+      }
+    }
+
+    result.key = claves[result.keyLength - 1];
+    result.validRecords = validFraction(lines, result.key);
+    result.cribMatches = cribFraction(lines, result.key, cribs);
+    return result;
+  }
+
+  /**
+   * @brief Recovers the key of a file written by FileProtector::CifrarXOR.
+   * @param path Encrypted file.
+   * @param result Receives the key and the measurements.
+   * @param maxLength Longest key length tried.
+   * @param attack Search used.
+   * @param language Expected plaintext language.
+   * @return False if the file could not be read or is empty.
+   */
+  static bool
+  crackFile(const std::string& path, Result& result, size_t maxLength = 40,
+            Attack attack = Attack::Frequency,
+            FrequencyAnalysis::Language language = FrequencyAnalysis::Language::English) {
+    MappedFile archivo;
+    if (!archivo.open(path)) {
+      return false;
+    }
+    std::vector<std::string_view> lineas;
+    splitLines(archivo, lineas);
+    if (lineas.empty()) {
+      return false;
+    }
+    if (attack == Attack::Crib) {
+      result = crackWithCribs(lineas, maxLength, defaultCribs(), language);
+    }
+    else {
+      result = crack(lineas, maxLength, language);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Fraction of lines that decrypt to a user:password:others record with a key.
+   */
+  static double
+  validFraction(const std::vector<std::string_view>& lines, const std::string& key) {
+    if (lines.empty() || key.empty()) {
+      return 0;
+    }
+    size_t validas = 0;
+    std::string plano;
+    for (std::string_view linea : lines) {
+      plano.assign(linea);
+      for (size_t i = 0; i < plano.size(); ++i) {
+        plano[i] ^= key[i % key.size()];
+      }
+      if (RecordCipher::isRecord(plano)) {
+        validas++;
+      }
+    }
+    return static_cast<double>(validas) / lines.size();
+  }
+
+  /**
+   * @brief Fraction of lines that decrypt to text ending in one of the cribs.
+   */
+  static double
+  cribFraction(const std::vector<std::string_view>& lines, const std::string& key,
+               const std::vector<std::string>& cribs) {
+    if (lines.empty() || key.empty()) {
+      return 0;
+    }
+    size_t coinciden = 0;
+    for (std::string_view linea : lines) {
+      for (const std::string& crib : cribs) {
+        if (crib.size() > linea.size()) {
+          continue;
+        }
+        size_t inicio = linea.size() - crib.size();
+        size_t i = 0;
+        while (i < crib.size() && (linea[inicio + i] ^ key[(inicio + i) % key.size()]) == crib[i]) {
+          i++;
+        }
+        if (i == crib.size()) {
+          coinciden++;
+          break;
+        }
+      }
+    }
+    return static_cast<double>(coinciden) / lines.size();
+  }
+
+private:
+  /**
+   * @brief Adds up the votes of the line positions that share a key column.
+   */
+  static void
+  foldVotes(const std::vector<Histogram>& votes, size_t keyLength, std::vector<Histogram>& columns) {
+    columns.assign(keyLength, Histogram{});
+    for (size_t p = 0; p < votes.size(); ++p) {
+      Histogram& columna = columns[p % keyLength];
+      for (int b = 0; b < 256; ++b) {
+        columna[b] += votes[p][b];
+      }
+    }
+  }
+
+  /**
+   * @brief Builds the key of one length from the crib votes of each line position.
+   * @details Columns without votes are solved by letter frequency.
+   */
+  static std::string
+  keyFromVotes(const std::vector<std::string_view>& lines, const std::vector<Histogram>& votes,
+               size_t keyLength, FrequencyAnalysis::Language language) {
+    std::vector<Histogram> columnas;
+    foldVotes(votes, keyLength, columnas);
+    std::vector<Histogram> frecuencias;
+    std::string clave;
+    for (size_t c = 0; c < keyLength; ++c) {
+      const Histogram& columna = columnas[c];
+      size_t elegido = std::max_element(columna.begin(), columna.end()) - columna.begin();
+      if (columna[elegido] == 0) {
+        if (frecuencias.empty()) {
+          frecuencias = columnHistograms(lines, keyLength);
+        }
+        elegido = solveColumn(frecuencias[c], language);
+      }
+      clave += static_cast<char>(elegido);
+    }
+    return clave;
+  }
+
+  /**
+   * @brief Votes for the key bytes that turn the end of a line into a crib.
+   */
+  static void
+  addCribVotes(std::string_view line, const std::string& crib, std::vector<Histogram>& votes) {
+    if (crib.size() > line.size()) {
+      return;
+    }
+    size_t inicio = line.size() - crib.size();
+    for (size_t i = 0; i < crib.size(); ++i) {
+      votes[inicio + i][static_cast<unsigned char>(line[inicio + i] ^ crib[i])]++;
+    }
+  }
+
+  /**
+   * @brief Most voted key byte of each line position, or -1 where the vote is too thin
+   *        or too close.
+   */
+  static std::vector<int>
+  voteWinners(const std::vector<Histogram>& votes) {
+    std::vector<int> ganadores(votes.size(), -1);
+    for (size_t p = 0; p < votes.size(); ++p) {
+      uint64_t primero = 0;
+      uint64_t segundo = 0;
+      int mayor = 0;
+      for (int b = 0; b < 256; ++b) {
+        if (votes[p][b] > primero) {
+          segundo = primero;
+          primero = votes[p][b];
+          mayor = b;
+        }
+        else if (votes[p][b] > segundo) {
+          segundo = votes[p][b];
+        }
+      }
+      if (primero >= MIN_CRIB_VOTES && primero > segundo) {
+        ganadores[p] = mayor;
+      }
+    }
+    return ganadores;
+  }
+
+  /**
+   * @brief Number of positions before the first one without a key estimate.
+   */
+  static size_t
+  knownPrefix(const std::vector<int>& keys) {
+    return std::find(keys.begin(), keys.end(), -1) - keys.begin();
+  }
+
+  // Votos minimos para fijar el byte de clave de una posicion con cribs
+  static constexpr uint64_t MIN_CRIB_VOTES = 5;
+
+  // Con cribs, una longitud se elige si su comprobacion alcanza esta fraccion de la mejor
+  static constexpr double CRIB_MARGIN = 0.95;
+
+  // Lineas de la muestra con que se comprueba cada longitud
+  static constexpr size_t VERIFY_LINES = 2048;
+
+  // Acuerdo minimo (coincidencias menos diferencias) para que una linea vote con un crib
+  static constexpr long MIN_CRIB_AGREEMENT = 3;
+
+  // Pares de posiciones minimos para medir el acuerdo de una longitud
+  static constexpr size_t MIN_PERIOD_PAIRS = 3;
+
+  // Una longitud se elige si su coincidencia alcanza esta fraccion de la mejor
+  static constexpr double LENGTH_MARGIN = 0.8;
+
+  // Coincidencia minima para aceptar que la clave se repite dentro de las lineas
+  static constexpr double MIN_AGREEMENT = 0.3;
+
+  // Lineas minimas que deben llegar a una posicion para estimar su byte de clave
+  static constexpr uint64_t MIN_POSITION_SAMPLES = 50;
+
+  // Posiciones de linea estimadas como maximo
+  static constexpr size_t MAX_POSITIONS = 4096;
+};
@@ -1,5 +1,9 @@
 #pragma once 
 #include "Prerequisites.h"
+#include "XorKernel.h"
+#include "HexCodec.h"
+#include "XorBruteForce.h"
+#include "XorDictionaryAttack.h"
 
 /**
  * @brief Class for XOR-based encoding and decoding operations.
@@ -18,14 +22,30 @@ public:
    */
   std::string 
   encode(const std::string& input, const std::string& key) {
-    std::string output = input;
-     // Perform XOR operation for each character in the input
-    for (int i = 0; i < input.size(); i++) {
-        output[i] = input[i] ^ key[i % key.size()];
-    }
+    std::string output;
+    encode(input, key, output);
     return output;
   }
 
+  /**
+   * @brief Encodes a string into an existing buffer, reusing its memory.
+   * @details The key is expanded into a keystream only when it changes, and the XOR runs
+   *          on the widest SIMD kernel available (see XorKernel).
+   * @param input The input string to encode.
+   * @param key The key used for XOR encryption.
+   * @param output Receives the encoded string.
+   */
+  void
+  encode(const std::string& input, const std::string& key, std::string& output) {
+    if (m_kernel.key() != key) {
+      m_kernel.setKey(key);
+    }
+    output.resize(input.size());
+    if (!input.empty()) {
+      m_kernel.apply(input.data(), &output[0], input.size());
+    }
+  }
+
   /**
    * @brief Converts a hexadecimal string to a vector of bytes.
    * @param input The hexadecimal string to convert.
@@ -33,23 +53,14 @@ public:
    */
   std::vector<unsigned char> 
   HexToBytes(const std::string& input) {
-
     std::vector<unsigned char> bytes;
-    std::istringstream iss(input);
-    std::string hexValue;
-
-        // Parse each hexadecimal value from the input string
-        while (iss >> hexValue) {
-            if (hexValue.size() == 1) {
-                hexValue = "0" + hexValue; // Pad single-digit hex values
-            }
-            unsigned int byte;
-            std::stringstream ss;
-            ss << std::hex << hexValue;
-            ss >> byte;
-            bytes.push_back(static_cast<unsigned char>(byte));
-        }
-        return bytes;
+    std::string error;
+    // Acepta valores separados por espacios o pegados (see HexCodec::decode)
+    if (!HexCodec::decode(input, bytes, &error)) {
+        std::cout << "ERROR: " << error << "\n";
+        bytes.clear();
+    }
+    return bytes;
     }
 
     /**
@@ -58,9 +69,9 @@ public:
      */
     void 
     printHex(const std::string& input) {
-        for (unsigned char c : input) {
-            // Print each character as a two-digit hexadecimal value
-            std::cout << std::hex << std::setw(2) << std::setfill('0') << (int)c << " ";
+        // Each character as a two-digit hexadecimal value followed by a space
+        if (!input.empty()) {
+            std::cout << HexCodec::encode(input, " ") << " ";
         }
     }
 
@@ -79,53 +90,25 @@ public:
 
     /**
      * @brief Attempts to decode a XOR-encrypted string using a single-byte key.
+     * @details Prints the most likely keys whose plaintext is valid text, best first.
      * @param cifrado The encrypted data as a vector of bytes.
+     * @param topK Maximum number of keys printed.
      */
     void 
-    bruteForce_1Byte(const std::vector<unsigned char>& cifrado) {
-        for (int clave = 0; clave < 256; ++clave) {
-            std::string result;
-
-            // XOR each byte with the current key
-            for (unsigned char c : cifrado) {
-                result += static_cast<unsigned char>(c ^ clave);
-            }
-
-            // Check if the result is valid text
-            if (isValidText(result)) {
-                std::cout << "Clave 1 byte  : '" << static_cast<char>(clave)
-                          << "' (0x" << std::hex << std::setw(2) << std::setfill('0') << clave << ")\n";
-                std::cout << "Texto posible : " << result << "\n";
-            }
-        }
+    bruteForce_1Byte(const std::vector<unsigned char>& cifrado, size_t topK = 10) {
+        printRanking(XorBruteForce::rankKeys(cifrado.data(), cifrado.size(), 1, topK));
     }
 
     /**
      * @brief Attempts to decode a XOR-encrypted string using a two-byte key.
+     * @details Both key bytes are searched in parallel column by column (see XorBruteForce)
+     *          and the most likely keys are printed, best first.
      * @param cifrado The encrypted data as a vector of bytes.
+     * @param topK Maximum number of keys printed.
      */
     void 
-    bruteForce_2Byte(const std::vector<unsigned char>& cifrado) {
-
-      for (int b1 = 0; b1 < 256; ++b1) {
-          for (int b2 = 0; b2 < 256; ++b2) {
-              std::string result;
-              unsigned char key[2] = { static_cast<unsigned char>(b1), static_cast<unsigned char>(b2) };
-
-              // XOR each byte with the current two-byte key
-              for (int i = 0; i < cifrado.size(); i++) {
-                  result += cifrado[i] ^ key[i % 2];
-              }
-
-                // Check if the result is valid text
-              if (isValidText(result)) {
-                  std::cout << "Clave 2 bytes : '" << static_cast<char>(b1) << static_cast<char>(b2)
-                            << "' (0x" << std::hex << std::setw(2) << std::setfill('0') << b1
-                            << " 0x" << std::setw(2) << std::setfill('0') << b2 << ")\n";
-                  std::cout << "Texto posible : " << result << "\n";
-              }
-          }
-      }
+    bruteForce_2Byte(const std::vector<unsigned char>& cifrado, size_t topK = 10) {
+        printRanking(XorBruteForce::rankKeys(cifrado.data(), cifrado.size(), 2, topK));
     }
 
     /**
@@ -156,6 +139,67 @@ public:
       }
     }
 
+    /**
+     * @brief Attempts to decode a XOR-encrypted string with every word of a wordlist file.
+     * @details The wordlist is memory-mapped and shared out across threads, and every word
+     *          is also tried with the mangling rules (see XorDictionaryAttack). Prints the
+     *          keys that produce valid text, best first, and the candidates tried per second.
+     * @param cifrado The encrypted data as a vector of bytes.
+     * @param diccionario Path of a wordlist with one word per line.
+     * @param reglas Mangling rules, XorDictionaryAttack::Rules combined with |.
+     * @param hilos Worker threads, 0 for one per core.
+     * @param topK Maximum number of keys printed.
+     * @return False if the wordlist could not be read.
+     */
+    bool
+    bruteForceByWordlist(const std::vector<unsigned char>& cifrado, const std::string& diccionario,
+                         unsigned int reglas = XorDictionaryAttack::AllRules, unsigned int hilos = 0,
+                         size_t topK = 10) {
+        XorDictionaryAttack ataque(cifrado.data(), cifrado.size(), reglas);
+        std::vector<XorDictionaryAttack::Hit> resultados;
+        if (!ataque.run(diccionario, resultados, hilos, topK)) {
+            std::cout << "ERROR: " << ataque.error() << "\n";
+            return false;
+        }
+
+        std::vector<XorBruteForce::Candidate> candidatos;
+        for (auto& resultado : resultados) {
+            candidatos.push_back({ std::move(resultado.key), resultado.score, std::move(resultado.preview) });
+        }
+        printRanking(candidatos);
+
+        const XorDictionaryAttack::Stats& stats = ataque.stats();
+        std::ostringstream reporte;
+        reporte << std::fixed << std::setprecision(0) << stats.words << " palabras, "
+                << stats.candidates << " candidatos en " << std::setprecision(2) << stats.elapsed
+                << " s (" << std::setprecision(0) << stats.candidatesPerSecond() << " candidatos/s, "
+                << stats.fullChecks << " descifrados completos)";
+        std::cout << reporte.str() << "\n";
+        return true;
+    }
+
 private:
-    // No private members in this class
+    /**
+     * @brief Prints ranked brute-force candidates.
+     * @param candidatos Keys returned by XorBruteForce::rankKeys, best first.
+     */
+    void
+    printRanking(const std::vector<XorBruteForce::Candidate>& candidatos) {
+        if (candidatos.empty()) {
+            std::cout << "Ninguna clave produce texto valido\n";
+            return;
+        }
+        for (size_t i = 0; i < candidatos.size(); ++i) {
+            const std::string& clave = candidatos[i].key;
+            std::cout << std::dec << (i + 1) << ". Clave " << clave.size()
+                      << (clave.size() == 1 ? " byte  : '" : " bytes : '") << clave << "' ("
+                      << "0x" << HexCodec::encode(clave, " 0x");
+            std::ostringstream puntaje;
+            puntaje << std::fixed << std::setprecision(1) << candidatos[i].score;
+            std::cout << std::dec << ")  puntaje " << puntaje.str() << "\n";
+            std::cout << "Texto posible : " << candidatos[i].preview << "\n";
+        }
+    }
+
+    XorKernel m_kernel; // Keystream of the last key used by encode
 };
\ No newline at end of file
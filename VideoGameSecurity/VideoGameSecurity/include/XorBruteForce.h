@@ -0,0 +1,227 @@
+#pragma once
+#include "Prerequisites.h"
+#include "FrequencyAnalysis.h"
+#include "ThreadPool.h"
+
+/**
+ * @brief Exhaustive search of short repeating XOR keys, ranked by plaintext score.
+ * @details With a key of L bytes, byte i of the ciphertext depends only on key byte
+ *          i % L. The search therefore never builds candidate plaintexts: it counts the
+ *          byte values of each of the L columns once (in parallel over the input) and then
+ *          tests every key byte against the distinct values of its column. A key byte is
+ *          rejected at the first value that would decrypt to a non-printable byte, and the
+ *          survivors are scored with the additive log-likelihood of FrequencyAnalysis. The
+ *          best complete keys are the best combinations of column candidates, taken in
+ *          score order until topK keys are found. The result is the same set of keys the
+ *          old byte-by-byte search accepted, ordered from most to least likely.
+ */
+class
+XorBruteForce {
+public:
+  /**
+   * @brief A complete key and how its plaintext scored.
+   */
+  struct
+  Candidate {
+    std::string key;       // Key bytes
+    double score = 0;      // Log-likelihood of the whole plaintext; higher is better
+    std::string preview;   // Start of the plaintext
+  };
+
+  /**
+   * @brief A key byte that keeps a column printable.
+   */
+  struct
+  ColumnCandidate {
+    unsigned char key = 0;
+    double score = 0;
+  };
+
+  /**
+   * @brief Counts of each byte value per key column.
+   */
+  using Histogram = std::array<uint64_t, 256>;
+
+  /**
+   * @brief Finds the most likely keys of a given length.
+   * @param data Ciphertext.
+   * @param size Size of the ciphertext.
+   * @param keyLength Key length in bytes; every key of this length is considered.
+   * @param topK Maximum number of keys returned.
+   * @param language Expected plaintext language.
+   * @param threads Threads used to count the columns, 0 for one per core.
+   * @param previewSize Bytes of plaintext included in each candidate.
+   * @return Keys whose whole plaintext is printable, best first.
+   */
+  static std::vector<Candidate>
+  rankKeys(const unsigned char* data, size_t size, size_t keyLength, size_t topK = 10,
+           FrequencyAnalysis::Language language = FrequencyAnalysis::Language::English,
+           unsigned int threads = 0, size_t previewSize = 256) {
+    std::vector<Candidate> result;
+    if (keyLength == 0 || size == 0 || topK == 0) {
+      return result;
+    }
+
+    std::vector<Histogram> columnas = columnHistograms(data, size, keyLength, threads);
+    std::vector<std::vector<ColumnCandidate>> candidatos(keyLength);
+    for (size_t c = 0; c < keyLength; ++c) {
+      candidatos[c] = rankColumn(columnas[c], language);
+      if (candidatos[c].empty()) {
+        return result;
+      }
+    }
+
+    for (const std::vector<size_t>& eleccion : bestCombinations(candidatos, topK)) {
+      Candidate candidato;
+      for (size_t c = 0; c < keyLength; ++c) {
+        candidato.key += static_cast<char>(candidatos[c][eleccion[c]].key);
+        candidato.score += candidatos[c][eleccion[c]].score;
+      }
+      size_t mostrar = std::min(size, previewSize);
+      candidato.preview.resize(mostrar);
+      for (size_t i = 0; i < mostrar; ++i) {
+        candidato.preview[i] = static_cast<char>(data[i] ^ candidato.key[i % keyLength]);
+      }
+      result.push_back(std::move(candidato));
+    }
+    return result;
+  }
+
+  /**
+   * @brief Counts the byte values of each key column, splitting the input across threads.
+   * @param data Ciphertext.
+   * @param size Size of the ciphertext.
+   * @param keyLength Number of columns; byte i belongs to column i % keyLength.
+   * @param threads Threads to use, 0 for one per core.
+   */
+  static std::vector<Histogram>
+  columnHistograms(const unsigned char* data, size_t size, size_t keyLength,
+                   unsigned int threads = 0) {
+    if (threads == 0) {
+      threads = ThreadPool::defaultThreads();
+    }
+    // Por debajo de este tamano no compensa repartir el conteo
+    const size_t minimoPorHilo = 1 << 16;
+    size_t partes = std::min<size_t>(threads, std::max<size_t>(1, size / minimoPorHilo));
+
+    auto contar = [data, keyLength](size_t desde, size_t hasta) {
+      std::vector<Histogram> conteo(keyLength, Histogram{});
+      size_t columna = desde % keyLength;
+      for (size_t i = desde; i < hasta; ++i) {
+        conteo[columna][data[i]]++;
+        if (++columna == keyLength) {
+          columna = 0;
+        }
+      }
+      return conteo;
+    };
+
+    if (partes <= 1) {
+      return contar(0, size);
+    }
+
+    ThreadPool pool(static_cast<unsigned int>(partes));
+    std::vector<std::future<std::vector<Histogram>>> futuros;
+    size_t tamParte = (size + partes - 1) / partes;
+    for (size_t p = 0; p < partes; ++p) {
+      size_t desde = p * tamParte;
+      size_t hasta = std::min(size, desde + tamParte);
+      futuros.push_back(pool.submit([&contar, desde, hasta]() { return contar(desde, hasta); }));
+    }
+
+    std::vector<Histogram> total(keyLength, Histogram{});
+    for (auto& futuro : futuros) {
+      std::vector<Histogram> parcial = futuro.get();
+      for (size_t c = 0; c < keyLength; ++c) {
+        for (int b = 0; b < 256; ++b) {
+          total[c][b] += parcial[c][b];
+        }
+      }
+    }
+    return total;
+  }
+
+  /**
+   * @brief Tests the 256 values of one key byte against a column.
+   * @param column Byte counts of the column.
+   * @param language Expected plaintext language.
+   * @return The key bytes that keep the whole column printable, best score first.
+   */
+  static std::vector<ColumnCandidate>
+  rankColumn(const Histogram& column, FrequencyAnalysis::Language language) {
+    const std::array<bool, 256>& imprimible = FrequencyAnalysis::printableTable();
+    const std::array<double, 256>& logaritmos = FrequencyAnalysis::logTable(language);
+
+    // Solo importan los valores que aparecen en la columna
+    std::vector<unsigned char> valores;
+    for (int b = 0; b < 256; ++b) {
+      if (column[b] != 0) {
+        valores.push_back(static_cast<unsigned char>(b));
+      }
+    }
+
+    std::vector<ColumnCandidate> result;
+    for (int k = 0; k < 256; ++k) {
+      bool valida = true;
+      double puntaje = 0;
+      for (unsigned char v : valores) {
+        unsigned char plano = static_cast<unsigned char>(v ^ k);
+        if (!imprimible[plano]) {
+          valida = false;
+          break;
+        }
+        puntaje += column[v] * logaritmos[plano];
+      }
+      if (valida) {
+        result.push_back({ static_cast<unsigned char>(k), puntaje });
+      }
+    }
+    std::sort(result.begin(), result.end(),
+              [](const ColumnCandidate& a, const ColumnCandidate& b) { return a.score > b.score; });
+    return result;
+  }
+
+  /**
+   * @brief Picks the best combinations of one candidate per column.
+   * @details Best-first walk over the index tuples: starting from the best candidate of
+   *          every column, each step takes the best tuple not yet returned and queues its
+   *          neighbours, which differ in one column by one position.
+   * @param columns Candidates of each column, sorted best first.
+   * @param topK Number of combinations wanted.
+   * @return Index of the chosen candidate in each column, best combination first.
+   */
+  static std::vector<std::vector<size_t>>
+  bestCombinations(const std::vector<std::vector<ColumnCandidate>>& columns, size_t topK) {
+    using Entrada = std::pair<double, std::vector<size_t>>;
+    auto puntaje = [&columns](const std::vector<size_t>& indices) {
+      double total = 0;
+      for (size_t c = 0; c < columns.size(); ++c) {
+        total += columns[c][indices[c]].score;
+      }
+      return total;
+    };
+
+    std::vector<std::vector<size_t>> result;
+    std::priority_queue<Entrada> cola;
+    std::set<std::vector<size_t>> vistos;
+    std::vector<size_t> inicio(columns.size(), 0);
+    cola.push({ puntaje(inicio), inicio });
+    vistos.insert(inicio);
+
+    while (!cola.empty() && result.size() < topK) {
+      std::vector<size_t> mejor = cola.top().second;
+      cola.pop();
+      for (size_t c = 0; c < columns.size(); ++c) {
+        if (mejor[c] + 1 < columns[c].size()) {
+          std::vector<size_t> vecino = mejor;
+          vecino[c]++;
+          if (vistos.insert(vecino).second) {
+            cola.push({ puntaje(vecino), vecino });
+          }
+        }
+      }
+      result.push_back(std::move(mejor));
+    }
+    return result;
+  }
+};
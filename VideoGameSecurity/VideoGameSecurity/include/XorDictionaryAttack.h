@@ -0,0 +1,350 @@
+#pragma once
+#include "Prerequisites.h"
+#include "FrequencyAnalysis.h"
+#include "MappedFile.h"
+#include "RecordParser.h"
+#include "ThreadPool.h"
+
+/**
+ * @brief XOR dictionary attack over large wordlists.
+ * @details The wordlist is memory-mapped and cut into chunks at line boundaries, and the
+ *          chunks are shared out to the ThreadPool, so lists of tens of millions of words
+ *          are never copied into memory. Every word is expanded with the selected mangling
+ *          rules and each candidate key is first tried on a short prefix of the ciphertext:
+ *          almost every wrong key produces a non-printable byte within the first few
+ *          bytes. Only the candidates that survive the prefix are decrypted in full.
+ */
+class
+XorDictionaryAttack {
+public:
+  /**
+   * @brief Mangling rules applied to every word; combine them with |.
+   */
+  enum Rules : unsigned int {
+    None = 0,
+    CaseVariants = 1 << 0,   // lower, UPPER and Capitalized forms
+    AppendDigits = 1 << 1,   // word0 ... word9 and word00 ... word99
+    Leetspeak = 1 << 2,      // a->4 e->3 i->1 o->0 s->5 t->7, and a->@ s->$
+    AllRules = CaseVariants | AppendDigits | Leetspeak
+  };
+
+  /**
+   * @brief A key whose whole plaintext is text.
+   */
+  struct
+  Hit {
+    std::string key;       // Candidate that produced the plaintext
+    double score = 0;      // Log-likelihood of the plaintext; higher is better
+    std::string preview;   // Start of the plaintext
+  };
+
+  /**
+   * @brief Counters of the last run.
+   */
+  struct
+  Stats {
+    uint64_t words = 0;        // Words read from the wordlist
+    uint64_t candidates = 0;   // Keys tried after mangling
+    uint64_t fullChecks = 0;   // Candidates that passed the prefix
+    double elapsed = 0;        // Seconds spent
+
+    /**
+     * @brief Keys tried per second.
+     */
+    double
+    candidatesPerSecond() const {
+      return elapsed > 0 ? candidates / elapsed : 0;
+    }
+  };
+
+  /**
+   * @brief Prepares an attack on a ciphertext.
+   * @param data Ciphertext; it is copied.
+   * @param size Size of the ciphertext.
+   * @param rules Mangling rules.
+   * @param prefixSize Bytes tried before decrypting a candidate in full.
+   */
+  XorDictionaryAttack(const unsigned char* data, size_t size, unsigned int rules = AllRules,
+                      size_t prefixSize = 32)
+    : m_cipher(data, data + size), m_rules(rules), m_prefix(std::min(prefixSize, size)) {}
+
+  /**
+   * @brief Tries every word of a wordlist and its mangled forms.
+   * @param wordlist Path of a text file with one word per line.
+   * @param hits Receives the keys whose plaintext is text, best first.
+   * @param threads Worker threads, 0 for one per core.
+   * @param maxHits Maximum number of hits kept.
+   * @return False if the wordlist could not be read; see error().
+   */
+  bool
+  run(const std::string& wordlist, std::vector<Hit>& hits, unsigned int threads = 0,
+      size_t maxHits = 100) {
+    hits.clear();
+    maxHits = std::max<size_t>(1, maxHits);
+    m_stats = Stats();
+    m_error.clear();
+    auto inicio = std::chrono::steady_clock::now();
+
+    MappedFile archivo;
+    if (!archivo.open(wordlist)) {
+      m_error = "Cannot open the wordlist " + wordlist;
+      return false;
+    }
+    if (m_cipher.empty() || archivo.size() == 0) {
+      return true;
+    }
+
+    if (threads == 0) {
+      threads = ThreadPool::defaultThreads();
+    }
+    // Varios trozos por hilo para repartir bien la carga aunque las palabras varien
+    std::vector<std::pair<const char*, size_t>> trozos =
+      splitChunks(archivo.data(), archivo.size(), static_cast<size_t>(threads) * CHUNKS_PER_THREAD);
+
+    struct Parcial {
+      Stats stats;
+      std::vector<Hit> hits;
+    };
+    ThreadPool pool(threads);
+    std::vector<std::future<Parcial>> futuros;
+    for (const auto& trozo : trozos) {
+      futuros.push_back(pool.submit([this, trozo, maxHits]() {
+        Parcial parcial;
+        searchChunk(trozo.first, trozo.second, maxHits, parcial.stats, parcial.hits);
+        return parcial;
+      }));
+    }
+    for (auto& futuro : futuros) {
+      Parcial parcial = futuro.get();
+      m_stats.words += parcial.stats.words;
+      m_stats.candidates += parcial.stats.candidates;
+      m_stats.fullChecks += parcial.stats.fullChecks;
+      for (Hit& hit : parcial.hits) {
+        hits.push_back(std::move(hit));
+      }
+    }
+
+    keepBest(hits, maxHits);
+    m_stats.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+    return true;
+  }
+
+  /**
+   * @brief Counters of the last run.
+   */
+  const Stats&
+  stats() const {
+    return m_stats;
+  }
+
+  /**
+   * @brief Reason of the last failure.
+   */
+  const std::string&
+  error() const {
+    return m_error;
+  }
+
+  /**
+   * @brief Calls f with every distinct candidate a word produces under some rules.
+   * @param word The word.
+   * @param rules Mangling rules.
+   * @param f Callable taking const std::string&.
+   */
+  template<typename Callback>
+  static void
+  forEachVariant(std::string_view word, unsigned int rules, Callback&& f) {
+    // Formas base: mayusculas y leetspeak, sin repetir
+    std::string formas[MAX_BASES];
+    size_t numFormas = 0;
+    auto agregar = [&formas, &numFormas](const std::string& forma) {
+      for (size_t i = 0; i < numFormas; ++i) {
+        if (formas[i] == forma) {
+          return;
+        }
+      }
+      formas[numFormas++] = forma;
+    };
+
+    std::string original(word);
+    agregar(original);
+    if (rules & CaseVariants) {
+      std::string minusculas = original;
+      std::string mayusculas = original;
+      for (size_t i = 0; i < original.size(); ++i) {
+        minusculas[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(original[i])));
+        mayusculas[i] = static_cast<char>(std::toupper(static_cast<unsigned char>(original[i])));
+      }
+      std::string capital = minusculas;
+      if (!capital.empty()) {
+        capital[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(capital[0])));
+      }
+      agregar(minusculas);
+      agregar(mayusculas);
+      agregar(capital);
+    }
+    if (rules & Leetspeak) {
+      size_t sinLeet = numFormas;
+      for (size_t i = 0; i < sinLeet; ++i) {
+        agregar(leet(formas[i], "431057", "aeiost"));
+        agregar(leet(formas[i], "@$", "as"));
+      }
+    }
+
+    std::string candidato;
+    for (size_t i = 0; i < numFormas; ++i) {
+      f(formas[i]);
+      if (rules & AppendDigits) {
+        candidato = formas[i];
+        size_t largo = candidato.size();
+        for (int n = 0; n < 10; ++n) {
+          candidato.resize(largo);
+          candidato += static_cast<char>('0' + n);
+          f(candidato);
+        }
+        for (int n = 0; n < 100; ++n) {
+          candidato.resize(largo);
+          candidato += static_cast<char>('0' + n / 10);
+          candidato += static_cast<char>('0' + n % 10);
+          f(candidato);
+        }
+      }
+    }
+  }
+
+private:
+  // Formas base de una palabra como maximo: original, 3 de mayusculas y 2 leet de cada una
+  static constexpr size_t MAX_BASES = 12;
+
+  // Trozos del diccionario por hilo
+  static constexpr size_t CHUNKS_PER_THREAD = 8;
+
+  /**
+   * @brief Replaces letters of a word, in either case, by the symbols at the same index.
+   */
+  static std::string
+  leet(const std::string& word, const char* symbols, const char* letters) {
+    std::string result = word;
+    for (char& c : result) {
+      if (c == '\0') {
+        continue;
+      }
+      const char* p = std::strchr(letters, std::tolower(static_cast<unsigned char>(c)));
+      if (p != nullptr) {
+        c = symbols[p - letters];
+      }
+    }
+    return result;
+  }
+
+  /**
+   * @brief Cuts a buffer into about n pieces that end at line boundaries.
+   */
+  static std::vector<std::pair<const char*, size_t>>
+  splitChunks(const char* data, size_t size, size_t n) {
+    std::vector<std::pair<const char*, size_t>> trozos;
+    size_t objetivo = std::max<size_t>(1, size / std::max<size_t>(1, n));
+    size_t inicio = 0;
+    while (inicio < size) {
+      size_t fin = std::min(size, inicio + objetivo);
+      if (fin < size) {
+        const char* salto = static_cast<const char*>(std::memchr(data + fin, '\n', size - fin));
+        fin = salto != nullptr ? static_cast<size_t>(salto - data) + 1 : size;
+      }
+      trozos.push_back({ data + inicio, fin - inicio });
+      inicio = fin;
+    }
+    return trozos;
+  }
+
+  /**
+   * @brief Tries every word of a chunk of the wordlist.
+   */
+  void
+  searchChunk(const char* data, size_t size, size_t maxHits, Stats& stats,
+              std::vector<Hit>& hits) const {
+    const std::array<bool, 256>& imprimible = FrequencyAnalysis::printableTable();
+    const unsigned char* cifrado = m_cipher.data();
+
+    auto probar = [&](const std::string& clave) {
+      stats.candidates++;
+      // Prefijo: casi todas las claves falsas fallan en los primeros bytes
+      size_t k = 0;
+      for (size_t i = 0; i < m_prefix; ++i) {
+        if (!imprimible[cifrado[i] ^ static_cast<unsigned char>(clave[k])]) {
+          return;
+        }
+        if (++k == clave.size()) {
+          k = 0;
+        }
+      }
+      stats.fullChecks++;
+      Hit hit;
+      if (fullCheck(clave, hit)) {
+        hits.push_back(std::move(hit));
+        // Solo se guardan los mejores; se recorta al doble para no ordenar en cada acierto
+        if (hits.size() >= 2 * maxHits) {
+          keepBest(hits, maxHits);
+        }
+      }
+    };
+
+    RecordParser::forEachLine(data, size, [&](const char* linea, size_t longitud) {
+      if (longitud == 0) {
+        return;
+      }
+      stats.words++;
+      forEachVariant(std::string_view(linea, longitud), m_rules, probar);
+    });
+    keepBest(hits, maxHits);
+  }
+
+  /**
+   * @brief Sorts hits best first and drops all but the first n.
+   */
+  static void
+  keepBest(std::vector<Hit>& hits, size_t n) {
+    std::sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) { return a.score > b.score; });
+    if (hits.size() > n) {
+      hits.resize(n);
+    }
+  }
+
+  /**
+   * @brief Decrypts the whole ciphertext with a candidate.
+   * @return True if every byte is text.
+   */
+  bool
+  fullCheck(const std::string& key, Hit& hit) const {
+    const std::array<bool, 256>& imprimible = FrequencyAnalysis::printableTable();
+    // Primero solo se comprueba; el texto se arma para las claves que pasan
+    size_t k = 0;
+    for (size_t i = 0; i < m_cipher.size(); ++i) {
+      if (!imprimible[m_cipher[i] ^ static_cast<unsigned char>(key[k])]) {
+        return false;
+      }
+      if (++k == key.size()) {
+        k = 0;
+      }
+    }
+
+    std::string plano(m_cipher.size(), '\0');
+    for (size_t i = 0; i < m_cipher.size(); ++i) {
+      plano[i] = static_cast<char>(m_cipher[i] ^ static_cast<unsigned char>(key[i % key.size()]));
+    }
+    hit.key = key;
+    hit.score = FrequencyAnalysis::score(reinterpret_cast<const unsigned char*>(plano.data()),
+                                         plano.size(), FrequencyAnalysis::Language::English);
+    hit.preview = plano.substr(0, PREVIEW_SIZE);
+    return true;
+  }
+
+  // Bytes de texto incluidos en cada resultado
+  static constexpr size_t PREVIEW_SIZE = 256;
+
+  std::vector<unsigned char> m_cipher;   // Ciphertext under attack
+  unsigned int m_rules;                  // Mangling rules
+  size_t m_prefix;                       // Bytes checked before a full decrypt
+  Stats m_stats;                         // Counters of the last run
+  std::string m_error;                   // Reason of the last failure
+};
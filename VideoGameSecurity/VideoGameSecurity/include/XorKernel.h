@@ -0,0 +1,260 @@
+#pragma once
+#include "Prerequisites.h"
+#include "CpuFeatures.h"
+
+/**
+ * @brief Vectorized repeating-key XOR.
+ * @details The key is expanded once into a keystream whose length is a multiple of both
+ *          the key length and 64 bytes, so every vector of 16, 32 or 64 bytes can be loaded
+ *          from the keystream without splitting it at the key boundary, whatever the key
+ *          length. The widest kernel supported by the CPU (AVX-512, AVX2, SSE2 or a
+ *          64-bit scalar loop) is selected at run time.
+ */
+class
+XorKernel {
+public:
+  /**
+   * @brief Instruction set of a kernel.
+   */
+  enum class Isa {
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512
+  };
+
+  XorKernel() = default;
+
+  /**
+   * @brief Expands a key into its keystream.
+   * @param key The XOR key; an empty key leaves the data unchanged.
+   * @param isa Widest kernel allowed; lowered to what the CPU supports.
+   */
+  explicit XorKernel(const std::string& key, Isa isa = Isa::AVX512) {
+    setKey(key, isa);
+  }
+
+  /**
+   * @brief Replaces the key and rebuilds the keystream.
+   * @param key The XOR key.
+   * @param isa Widest kernel allowed; lowered to what the CPU supports.
+   */
+  void
+  setKey(const std::string& key, Isa isa = Isa::AVX512) {
+    m_key = key;
+    m_isa = supported(isa);
+    m_stream.clear();
+    m_period = 0;
+    if (key.empty()) {
+      return;
+    }
+
+    // Menor multiplo comun de la longitud de la clave y 64
+    size_t a = key.size();
+    size_t b = VECTOR_BYTES;
+    while (b != 0) {
+      size_t t = a % b;
+      a = b;
+      b = t;
+    }
+    m_period = key.size() / a * VECTOR_BYTES;
+
+    // Un vector extra al final permite cargar desde cualquier posicion del periodo
+    m_stream.resize(m_period + VECTOR_BYTES);
+    for (size_t i = 0; i < m_stream.size(); ++i) {
+      m_stream[i] = key[i % key.size()];
+    }
+  }
+
+  /**
+   * @brief The key the keystream was built from.
+   */
+  const std::string&
+  key() const {
+    return m_key;
+  }
+
+  /**
+   * @brief Kernel in use.
+   */
+  Isa
+  isa() const {
+    return m_isa;
+  }
+
+  /**
+   * @brief XORs a buffer with the key.
+   * @param in Source bytes.
+   * @param out Destination; may be the same as in.
+   * @param size Number of bytes.
+   * @param keyOffset Key position of the first byte, to continue a previous call.
+   */
+  void
+  apply(const char* in, char* out, size_t size, size_t keyOffset = 0) const {
+    if (m_period == 0 || size == 0) {
+      if (in != out && size != 0) {
+        std::memmove(out, in, size);
+      }
+      return;
+    }
+    size_t pos = keyOffset % m_key.size();
+    switch (m_isa) {
+#ifdef VGS_X86
+    case Isa::AVX512:
+      applyAvx512(in, out, size, pos);
+      break;
+    case Isa::AVX2:
+      applyAvx2(in, out, size, pos);
+      break;
+    case Isa::SSE2:
+      applySse2(in, out, size, pos);
+      break;
+#endif
+    default:
+      applyScalar(in, out, size, pos);
+      break;
+    }
+  }
+
+  /**
+   * @brief XORs a string in place.
+   */
+  void
+  apply(std::string& data, size_t keyOffset = 0) const {
+    if (!data.empty()) {
+      apply(data.data(), &data[0], data.size(), keyOffset);
+    }
+  }
+
+  /**
+   * @brief Returns the widest kernel not above the requested one that the CPU runs.
+   */
+  static Isa
+  supported(Isa requested) {
+    const CpuFeatures& cpu = CpuFeatures::get();
+    if (requested >= Isa::AVX512 && cpu.avx512) {
+      return Isa::AVX512;
+    }
+    if (requested >= Isa::AVX2 && cpu.avx2) {
+      return Isa::AVX2;
+    }
+    if (requested >= Isa::SSE2 && cpu.sse2) {
+      return Isa::SSE2;
+    }
+    return Isa::Scalar;
+  }
+
+  /**
+   * @brief Name of a kernel, for reports.
+   */
+  static const char*
+  name(Isa isa) {
+    switch (isa) {
+    case Isa::AVX512: return "AVX-512";
+    case Isa::AVX2:   return "AVX2";
+    case Isa::SSE2:   return "SSE2";
+    default:          return "escalar";
+    }
+  }
+
+private:
+  static constexpr size_t VECTOR_BYTES = 64;
+
+  /**
+   * @brief Advances a keystream position by a whole vector.
+   */
+  size_t
+  advance(size_t pos, size_t bytes) const {
+    pos += bytes;
+    return pos >= m_period ? pos - m_period : pos;
+  }
+
+  /**
+   * @brief Finishes the last bytes one at a time.
+   */
+  void
+  applyTail(const char* in, char* out, size_t size, size_t pos) const {
+    const char* ks = m_stream.data() + pos;
+    for (size_t i = 0; i < size; ++i) {
+      out[i] = in[i] ^ ks[i];
+    }
+  }
+
+  void
+  applyScalar(const char* in, char* out, size_t size, size_t pos) const {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+      uint64_t dato;
+      uint64_t clave;
+      std::memcpy(&dato, in + i, 8);
+      std::memcpy(&clave, m_stream.data() + pos, 8);
+      dato ^= clave;
+      std::memcpy(out + i, &dato, 8);
+      pos = advance(pos, 8);
+    }
+    applyTail(in + i, out + i, size - i, pos);
+  }
+
+#ifdef VGS_X86
+  VGS_TARGET("sse2")
+  void
+  applySse2(const char* in, char* out, size_t size, size_t pos) const {
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+      __m128i dato = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+      __m128i clave = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_stream.data() + pos));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_xor_si128(dato, clave));
+      pos = advance(pos, 16);
+    }
+    applyTail(in + i, out + i, size - i, pos);
+  }
+
+  VGS_TARGET("avx2")
+  void
+  applyAvx2(const char* in, char* out, size_t size, size_t pos) const {
+    size_t i = 0;
+    // Dos vectores por vuelta para mantener ocupadas las unidades de carga
+    for (; i + 64 <= size; i += 64) {
+      const __m256i* ks = reinterpret_cast<const __m256i*>(m_stream.data() + pos);
+      __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+      __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + 32));
+      a = _mm256_xor_si256(a, _mm256_loadu_si256(ks));
+      b = _mm256_xor_si256(b, _mm256_loadu_si256(ks + 1));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), a);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 32), b);
+      pos = advance(pos, 64);
+    }
+    for (; i + 32 <= size; i += 32) {
+      __m256i dato = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+      __m256i clave = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_stream.data() + pos));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_xor_si256(dato, clave));
+      pos = advance(pos, 32);
+    }
+    applyTail(in + i, out + i, size - i, pos);
+  }
+
+  VGS_TARGET("avx512f,avx512bw")
+  void
+  applyAvx512(const char* in, char* out, size_t size, size_t pos) const {
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+      __m512i dato = _mm512_loadu_si512(in + i);
+      __m512i clave = _mm512_loadu_si512(m_stream.data() + pos);
+      _mm512_storeu_si512(out + i, _mm512_xor_si512(dato, clave));
+      pos = advance(pos, 64);
+    }
+    // El resto se hace con una mascara en lugar de byte a byte
+    if (i < size) {
+      __mmask64 mascara = (1ULL << (size - i)) - 1;
+      __m512i dato = _mm512_maskz_loadu_epi8(mascara, in + i);
+      __m512i clave = _mm512_maskz_loadu_epi8(mascara, m_stream.data() + pos);
+      _mm512_mask_storeu_epi8(out + i, mascara, _mm512_xor_si512(dato, clave));
+    }
+  }
+#endif
+
+  std::string m_key;               // Key the keystream was built from
+  std::string m_stream;            // Key repeated over m_period bytes plus one vector
+  size_t m_period = 0;             // Length of the keystream cycle
+  Isa m_isa = Isa::Scalar;         // Kernel in use
+};
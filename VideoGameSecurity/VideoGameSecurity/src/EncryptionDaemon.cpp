@@ -0,0 +1,323 @@
+#include "EncryptionDaemon.h"
+#include "RecordParser.h"
+
+std::atomic<bool> EncryptionDaemon::s_stop{ false };
+
+EncryptionDaemon::EncryptionDaemon(const Config& config)
+  : m_config(config),
+    m_cipher(config.cipher, config.key) {
+  // La clave de los hashes depende del cifrado y su clave, cambiar cualquiera
+  // de los dos obliga a cifrar de nuevo todos los archivos
+  std::string secreto = std::to_string(static_cast<int>(config.cipher)) + ":" + config.key;
+  m_hashKey = SipHash::deriveKey(secreto, "daemon-state");
+}
+
+bool
+EncryptionDaemon::run() {
+  s_stop.store(false);
+
+  std::error_code ec;
+  std::filesystem::create_directories(m_config.targetFolder, ec);
+  if (!std::filesystem::is_directory(m_config.targetFolder, ec)) {
+    std::cout << "ERROR: No se pudo crear " << m_config.targetFolder << std::endl;
+    return false;
+  }
+
+  FolderWatcher vigilante;
+  if (!vigilante.open(m_config.sourceFolder, m_config.extension)) {
+    std::cout << "ERROR: No se pudo vigilar " << m_config.sourceFolder << std::endl;
+    return false;
+  }
+
+  loadState();
+  m_pool = std::make_unique<ThreadPool>(m_config.workers);
+
+  std::cout << "\n[DAEMON] Vigilando " << m_config.sourceFolder << " -> "
+            << m_config.targetFolder << " con " << RecordCipher::name(m_config.cipher)
+            << " (" << m_pool->size() << " hilos, "
+            << (vigilante.usesNotifications() ? "notificaciones" : "sondeo") << ")" << std::endl;
+
+  // Primero los archivos que llegaron mientras el daemon no corria
+  for (const std::string& nombre : vigilante.existing()) {
+    launch(nombre);
+  }
+
+  std::vector<std::string> cambios;
+  while (!s_stop.load()) {
+    if (m_config.once) {
+      collect(true);
+      break;
+    }
+
+    if (vigilante.wait(cambios, m_config.waitMs)) {
+      for (const std::string& nombre : cambios) {
+        launch(nombre);
+      }
+    }
+    if (collect(false)) {
+      saveState();
+    }
+  }
+
+  // Termina los archivos en curso antes de salir
+  collect(true);
+  saveState();
+  m_pool.reset();
+
+  std::cout << "\n[DAEMON] Cifrados: " << m_stats.encrypted
+            << ", sin cambios: " << m_stats.skipped
+            << ", con error: " << m_stats.failed
+            << ", lecturas repetidas: " << m_stats.retried << std::endl;
+  return true;
+}
+
+void
+EncryptionDaemon::requestStop() {
+  s_stop.store(true);
+}
+
+void
+EncryptionDaemon::launch(const std::string& nombre) {
+  // Un archivo que cambia mientras se cifra se vuelve a procesar al terminar
+  if (m_running.count(nombre) != 0) {
+    m_repeat.insert(nombre);
+    return;
+  }
+
+  auto previo = m_hashes.find(nombre);
+  uint64_t hashPrevio = (previo != m_hashes.end()) ? previo->second : 0;
+  m_running.emplace(nombre, m_pool->submit([this, nombre, hashPrevio]() {
+    return processFile(nombre, hashPrevio);
+  }));
+}
+
+bool
+EncryptionDaemon::collect(bool wait) {
+  bool cambio = false;
+  while (!m_running.empty()) {
+    std::vector<std::string> repetir;
+    bool pausa = false;
+
+    for (auto it = m_running.begin(); it != m_running.end(); ) {
+      if (!wait && it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        ++it;
+        continue;
+      }
+
+      Result resultado = it->second.get();
+      it = m_running.erase(it);
+
+      if (resultado.outcome == Outcome::Encrypted) {
+        m_hashes[resultado.name] = resultado.hash;
+        m_stats.encrypted++;
+        cambio = true;
+        std::cout << "[DAEMON] " << resultado.name << ": " << resultado.records
+                  << " registros cifrados" << std::endl;
+      }
+      else if (resultado.outcome == Outcome::Skipped) {
+        m_stats.skipped++;
+      }
+      else if (resultado.outcome == Outcome::Retry) {
+        m_stats.retried++;
+        if (!m_config.once) {
+          std::cout << "[DAEMON] " << resultado.name << ": cambio mientras se leia, "
+                    << "se cifrara con su proximo cambio" << std::endl;
+        }
+        else if (++m_retries[resultado.name] <= MAX_RETRIES) {
+          // Sin eventos que lo vuelvan a encolar: se lee de nuevo tras una pausa
+          m_repeat.insert(resultado.name);
+          pausa = true;
+        }
+        else {
+          m_stats.failed++;
+          std::cout << "ERROR: " << resultado.name << ": siguio cambiando durante "
+                    << MAX_RETRIES << " lecturas" << std::endl;
+        }
+      }
+      else {
+        m_stats.failed++;
+        std::cout << "ERROR: " << resultado.name << ": " << resultado.error << std::endl;
+      }
+
+      if (m_repeat.erase(resultado.name) != 0) {
+        repetir.push_back(resultado.name);
+      }
+    }
+
+    if (pausa && !repetir.empty()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(m_config.waitMs));
+    }
+    for (const std::string& nombre : repetir) {
+      launch(nombre);
+    }
+    if (!wait) {
+      break;
+    }
+  }
+  return cambio;
+}
+
+EncryptionDaemon::Result
+EncryptionDaemon::processFile(const std::string& nombre, uint64_t hashPrevio) const {
+  Result resultado;
+  resultado.name = nombre;
+
+  std::filesystem::path origen = std::filesystem::path(m_config.sourceFolder) / nombre;
+  std::filesystem::path destino = std::filesystem::path(m_config.targetFolder) / nombre;
+  std::filesystem::path temporal = std::filesystem::path(m_config.targetFolder) /
+                                   ("." + nombre + ".tmp");
+
+  try {
+    // Se lee por bloques: cada hilo solo guarda un bloque, la linea pendiente y el
+    // bloque de salida, aunque el archivo tenga varios GB
+    const size_t TAM_BLOQUE = 1 << 20;
+    std::ifstream archivo(origen, std::ios::binary);
+    if (!archivo.is_open()) {
+      resultado.error = "No se pudo abrir el archivo";
+      return resultado;
+    }
+    std::string bloque(TAM_BLOQUE, '\0');
+    auto leerBloques = [&](auto&& procesar) {
+      archivo.clear();
+      archivo.seekg(0);
+      while (archivo) {
+        archivo.read(&bloque[0], static_cast<std::streamsize>(bloque.size()));
+        size_t leidos = static_cast<size_t>(archivo.gcount());
+        if (leidos == 0) {
+          break;
+        }
+        procesar(bloque.data(), leidos);
+      }
+      return !archivo.bad();
+    };
+
+    // Primera lectura: solo el hash, un archivo sin cambios no se cifra
+    SipHash::Stream hash(m_hashKey);
+    if (!leerBloques([&](const char* datos, size_t leidos) { hash.update(datos, leidos); })) {
+      resultado.error = "No se pudo leer el archivo";
+      return resultado;
+    }
+    resultado.hash = hash.finish();
+
+    // Mismo contenido que la ultima vez y la copia cifrada sigue ahi
+    std::error_code ec;
+    if (resultado.hash == hashPrevio && std::filesystem::exists(destino, ec)) {
+      resultado.outcome = Outcome::Skipped;
+      return resultado;
+    }
+
+    // Se escribe en un temporal y se renombra, el destino nunca queda a medias
+    {
+      std::ofstream salida(temporal);
+      if (!salida.is_open()) {
+        resultado.error = "No se pudo crear " + temporal.string();
+        return resultado;
+      }
+
+      RecordCipher cifrador(m_cipher);
+      std::string linea;
+      std::string lineaCifrada;
+      std::string pendiente;
+      std::string bufferSalida;
+      bufferSalida.reserve(TAM_BLOQUE);
+
+      auto cifrarLinea = [&](const char* inicio, size_t longitud) {
+        linea.assign(inicio, longitud);
+        if (!RecordCipher::isRecord(linea)) {
+          return;
+        }
+        cifrador.encrypt(linea, lineaCifrada);
+        bufferSalida += lineaCifrada;
+        bufferSalida += '\n';
+        resultado.records++;
+        if (bufferSalida.size() >= TAM_BLOQUE) {
+          salida.write(bufferSalida.data(), bufferSalida.size());
+          bufferSalida.clear();
+        }
+      };
+
+      // Segunda lectura: cifra y vuelve a calcular el hash del contenido cifrado
+      SipHash::Stream hashCifrado(m_hashKey);
+      bool leido = leerBloques([&](const char* datos, size_t leidos) {
+        hashCifrado.update(datos, leidos);
+        pendiente.append(datos, leidos);
+        size_t salto = pendiente.rfind('\n');
+        if (salto != std::string::npos) {
+          RecordParser::forEachLine(pendiente.data(), salto + 1, cifrarLinea);
+          pendiente.erase(0, salto + 1);
+        }
+      });
+      RecordParser::forEachLine(pendiente.data(), pendiente.size(), cifrarLinea);
+      salida.write(bufferSalida.data(), bufferSalida.size());
+
+      if (!leido) {
+        resultado.error = "No se pudo leer el archivo";
+      }
+      else if (!salida) {
+        resultado.error = "No se pudo escribir " + temporal.string();
+      }
+      else if (hashCifrado.finish() != resultado.hash) {
+        // El productor lo cambio entre las dos lecturas
+        resultado.outcome = Outcome::Retry;
+      }
+      if (!leido || !salida || resultado.outcome == Outcome::Retry) {
+        salida.close();
+        std::filesystem::remove(temporal, ec);
+        return resultado;
+      }
+    }
+
+    std::filesystem::rename(temporal, destino, ec);
+    if (ec) {
+      std::filesystem::remove(temporal, ec);
+      resultado.error = "No se pudo reemplazar " + destino.string();
+      return resultado;
+    }
+    resultado.outcome = Outcome::Encrypted;
+  }
+  catch (const std::exception& e) {
+    resultado.error = e.what();
+  }
+  return resultado;
+}
+
+void
+EncryptionDaemon::loadState() {
+  m_hashes.clear();
+  std::ifstream estado(std::filesystem::path(m_config.targetFolder) / STATE_FILE);
+  std::string linea;
+  while (std::getline(estado, linea)) {
+    // Formato: hash en hexadecimal, un espacio y el nombre del archivo
+    size_t espacio = linea.find(' ');
+    if (espacio == std::string::npos || espacio == 0) {
+      continue;
+    }
+    try {
+      m_hashes[linea.substr(espacio + 1)] = std::stoull(linea.substr(0, espacio), nullptr, 16);
+    }
+    catch (const std::exception&) {
+      // Linea danada, el archivo simplemente se cifra de nuevo
+    }
+  }
+}
+
+void
+EncryptionDaemon::saveState() const {
+  std::filesystem::path ruta = std::filesystem::path(m_config.targetFolder) / STATE_FILE;
+  std::filesystem::path temporal = ruta;
+  temporal += ".tmp";
+
+  {
+    std::ofstream estado(temporal);
+    if (!estado.is_open()) {
+      return;
+    }
+    for (const auto& par : m_hashes) {
+      estado << std::hex << std::setw(16) << std::setfill('0') << par.second
+             << ' ' << par.first << '\n';
+    }
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(temporal, ruta, ec);
+}
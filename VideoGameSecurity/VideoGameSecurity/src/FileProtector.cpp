@@ -2,37 +2,13 @@
 
 bool
 FileProtector::CargarArchivo(const std::string& filename) {
-  registros.clear();
-
-  std::ifstream archivo(filename);
-  if (!archivo.is_open()) {
+  // Mapea el archivo en memoria, los registros apuntan directo a sus bytes
+  // y se separan las lineas sin copiar los campos
+  if (!registros.load(filename)) {
     std::cout << "ERROR: No se pudo abrir " << filename << std::endl;
     return false;
   }
 
-  std::string linea;
-
-  while (std::getline(archivo, linea)) {
-    // Salta lineas vacias
-    if (linea.empty()) {
-      continue;
-    }
-
-    // Busca los separadores
-    size_t pos1 = linea.find(':');
-    size_t pos2 = linea.find(':', pos1 + 1);
-
-    if (pos1 != std::string::npos && pos2 != std::string::npos) {
-      ImportantInfo dato;
-      dato.user = linea.substr(0, pos1);
-      dato.password = linea.substr(pos1 + 1, pos2 - pos1 - 1);
-      dato.others = linea.substr(pos2 + 1);
-
-      registros.push_back(dato);
-    }
-  }
-
-  archivo.close();
   std::cout << "\n[OK] Se cargaron " << registros.size() << " registros del archivo." << std::endl;
   return true;
 }
@@ -46,35 +22,14 @@ FileProtector::CifrarXOR(const std::string& archivoSalida,
     return false;
   }
 
-  // Abre el archivo de salida
-  std::ofstream salida(archivoSalida);
-  if (!salida.is_open()) {
-    std::cout << "ERROR: No se pudo crear " << archivoSalida << std::endl;
+  if (clave.empty()) {
+    std::cout << "ERROR: La clave XOR no puede estar vacia" << std::endl;
     return false;
   }
 
   // Crea el codificador XOR
-  XOREncoder codificador;
-
-  // Recorre los registros y los cifra
-  int contador = 0;
-  for (size_t i = 0; i < registros.size(); i++) {
-    // Crea una linea con los datos
-    std::string lineaOriginal = registros[i].user + ":" +
-                                registros[i].password + ":" +
-                                registros[i].others;
-
-    // Cifra la linea
-    std::string lineaCifrada = codificador.encode(lineaOriginal, clave);
-
-    // Escribe al archivo
-    salida << lineaCifrada << std::endl;
-    contador++;
-  }
-
-  salida.close();
-  std::cout << "\n[OK] Se cifraron " << contador << " registros con XOR" << std::endl;
-  return true;
+  RecordCipher codificador(CipherType::XOR, clave);
+  return CifrarRegistros(archivoSalida, codificador);
 }
 
 bool
@@ -85,442 +40,1189 @@ FileProtector::CifrarCaesar(const std::string& archivoSalida,
     return false;
   }
 
-  std::ofstream salida(archivoSalida);
-  if (!salida.is_open()) {
-    std::cout << "ERROR: No se pudo crear " << archivoSalida << std::endl;
+  // Crea el codificador Caesar
+  RecordCipher cesar(CipherType::Caesar, std::to_string(desplazamiento));
+  return CifrarRegistros(archivoSalida, cesar);
+}
+
+bool
+FileProtector::CifrarASCIIBinary(const std::string& archivoSalida) {
+  if (registros.empty()) {
+    std::cout << "ERROR: No hay registros para cifrar" << std::endl;
     return false;
   }
 
-  // Crea el codificador Caesar
-  CesarEncryption cesar;
-  int contador = 0;
-
-  for (size_t i = 0; i < registros.size(); i++) {
-    std::string lineaOriginal = registros[i].user + ":" +
-                                registros[i].password + ":" +
-                                registros[i].others;
+  // Crea el codificador ASCII-Binary
+  RecordCipher ascii(CipherType::AsciiBinary, "");
+  return CifrarRegistros(archivoSalida, ascii);
+}
 
-    // Cifra con Caesar
-    std::string lineaCifrada = cesar.encode(lineaOriginal, desplazamiento);
+bool
+FileProtector::CifrarVigenere(const std::string& archivoSalida,
+                              const std::string& clave) {
+  if (registros.empty()) {
+    std::cout << "ERROR: No hay registros para cifrar" << std::endl;
+    return false;
+  }
 
-    salida << lineaCifrada << std::endl;
-    contador++;
+  if (Vigenere::normalizeKey(clave).empty()) {
+    std::cout << "ERROR: La clave Vigenere debe contener letras" << std::endl;
+    return false;
   }
 
-  salida.close();
-  std::cout << "\n[OK] Se cifraron " << contador << " registros con Caesar" << std::endl;
-  return true;
+  // Crea el codificador Vigenere
+  RecordCipher vig(CipherType::Vigenere, clave);
+  return CifrarRegistros(archivoSalida, vig);
 }
 
 bool
-FileProtector::CifrarASCIIBinary(const std::string& archivoSalida) {
+FileProtector::CifrarDES(const std::string& archivoSalida,
+                         const std::string& clave,
+                         DesModes::Mode modo) {
   if (registros.empty()) {
     std::cout << "ERROR: No hay registros para cifrar" << std::endl;
     return false;
   }
 
+  // Verifica que la clave tenga exactamente 8 caracteres
+  if (clave.length() != 8) {
+    std::cout << "ERROR: La clave DES debe tener exactamente 8 caracteres" << std::endl;
+    return false;
+  }
+
+  if (modo != DesModes::Mode::ECB) {
+    return CifrarDESEncadenado(archivoSalida, clave, modo);
+  }
+
+  // Junta los bloques de 8 caracteres de todos los registros, el ultimo de cada uno con
+  // relleno de espacios, para que DesBitslice los cifre por lotes
+  std::vector<uint64_t> bloques;
+  bloques.reserve(registros.size() * 4);
+  for (size_t i = 0; i < registros.size(); i++) {
+    std::string_view linea = registros.line(i);
+    for (size_t j = 0; j < linea.size(); j += 8) {
+      char bloque[8];
+      std::memset(bloque, ' ', 8);
+      std::memcpy(bloque, linea.data() + j, std::min<size_t>(8, linea.size() - j));
+      bloques.push_back(DesCore::load(bloque, 8));
+    }
+  }
+  DesBitslice des(DES::keyFromString(clave).to_ullong());
+  des.encryptBlocks(bloques.data(), bloques.data(), bloques.size());
+
   std::ofstream salida(archivoSalida);
   if (!salida.is_open()) {
     std::cout << "ERROR: No se pudo crear " << archivoSalida << std::endl;
     return false;
   }
 
-  // Crea el codificador ASCII-Binary
-  AsciiBinary ascii;
+  // Cada registro toma sus bloques en orden
+  std::string lineaCifrada;
+  size_t siguiente = 0;
   int contador = 0;
-
   for (size_t i = 0; i < registros.size(); i++) {
-    std::string lineaOriginal = registros[i].user + ":" +
-                                registros[i].password + ":" +
-                                registros[i].others;
-
-    // Convierte a binario
-    std::string lineaCifrada = ascii.stringToBinary(lineaOriginal);
-
-    salida << lineaCifrada << std::endl;
+    size_t numBloques = (registros.line(i).size() + 7) / 8;
+    lineaCifrada.resize(numBloques * 8);
+    for (size_t b = 0; b < numBloques; b++) {
+      DesCore::store(bloques[siguiente++], &lineaCifrada[b * 8]);
+    }
+    salida << lineaCifrada << '\n';
     contador++;
   }
 
   salida.close();
-  std::cout << "\n[OK] Se cifraron " << contador << " registros con ASCII-Binary" << std::endl;
+  std::cout << "\n[OK] Se cifraron " << contador << " registros con DES" << std::endl;
   return true;
 }
 
 bool
-FileProtector::CifrarVigenere(const std::string& archivoSalida,
-                              const std::string& clave) {
-  if (registros.empty()) {
-    std::cout << "ERROR: No hay registros para cifrar" << std::endl;
-    return false;
-  }
+FileProtector::DescifrarXOR(const std::string& archivoCifrado,
+                            const std::string& clave) {
+  registros.clear();
 
-  std::ofstream salida(archivoSalida);
-  if (!salida.is_open()) {
-    std::cout << "ERROR: No se pudo crear " << archivoSalida << std::endl;
+  if (clave.empty()) {
+    std::cout << "ERROR: La clave XOR no puede estar vacia" << std::endl;
     return false;
   }
 
-  // Crea el codificador Vigenere
-  Vigenere vig(clave);
-  int contador = 0;
+  RecordCipher codificador(CipherType::XOR, clave);
+  return DescifrarArchivo(archivoCifrado, codificador);
+}
 
-  for (size_t i = 0; i < registros.size(); i++) {
-    std::string lineaOriginal = registros[i].user + ":" +
-                                registros[i].password + ":" +
-                                registros[i].others;
+bool
+FileProtector::DescifrarCaesar(const std::string& archivoCifrado,
+                               int desplazamiento) {
+  registros.clear();
 
-    // Cifra con Vigenere
-    std::string lineaCifrada = vig.encode(lineaOriginal);
+  RecordCipher cesar(CipherType::Caesar, std::to_string(desplazamiento));
+  return DescifrarArchivo(archivoCifrado, cesar);
+}
 
-    salida << lineaCifrada << std::endl;
-    contador++;
-  }
+bool
+FileProtector::DescifrarASCIIBinary(const std::string& archivoCifrado) {
+  registros.clear();
 
-  salida.close();
-  std::cout << "\n[OK] Se cifraron " << contador << " registros con Vigenere" << std::endl;
-  return true;
+  RecordCipher ascii(CipherType::AsciiBinary, "");
+  return DescifrarArchivo(archivoCifrado, ascii);
 }
 
 bool
-FileProtector::CifrarDES(const std::string& archivoSalida,
-                         const std::string& clave) {
-  if (registros.empty()) {
-    std::cout << "ERROR: No hay registros para cifrar" << std::endl;
+FileProtector::DescifrarVigenere(const std::string& archivoCifrado,
+                                 const std::string& clave) {
+  registros.clear();
+
+  if (Vigenere::normalizeKey(clave).empty()) {
+    std::cout << "ERROR: La clave Vigenere debe contener letras" << std::endl;
     return false;
   }
 
-  // Verifica que la clave tenga exactamente 8 caracteres
+  RecordCipher vig(CipherType::Vigenere, clave);
+  return DescifrarArchivo(archivoCifrado, vig);
+}
+
+bool
+FileProtector::DescifrarDES(const std::string& archivoCifrado,
+                            const std::string& clave) {
+  registros.clear();
+
   if (clave.length() != 8) {
     std::cout << "ERROR: La clave DES debe tener exactamente 8 caracteres" << std::endl;
     return false;
   }
 
-  std::ofstream salida(archivoSalida);
-  if (!salida.is_open()) {
-    std::cout << "ERROR: No se pudo crear " << archivoSalida << std::endl;
+  MappedFile entrada;
+  if (!entrada.open(archivoCifrado)) {
+    std::cout << "ERROR: No se pudo abrir " << archivoCifrado << std::endl;
     return false;
   }
 
-  // Convierte la clave a bitset de 64 bits
-  std::bitset<64> desClave;
-  for (int i = 0; i < 8; i++) {
-    unsigned char c = clave[i];
-    for (int j = 0; j < 8; j++) {
-      desClave[i * 8 + j] = (c >> (7 - j)) & 1;
+  std::vector<std::string_view> lineas;
+  RecordParser::forEachLine(entrada.data(), entrada.size(), [&lineas](const char* linea, size_t longitud) {
+    if (longitud > 0) {
+      lineas.emplace_back(linea, longitud);
     }
+  }, RecordParser::LineEnding::Encrypted);
+
+  // Los archivos CBC y CTR empiezan con una cabecera; los ECB no tienen
+  DesModes::Mode modo = DesModes::Mode::ECB;
+  if (!lineas.empty() && !DesModes::parseHeader(lineas.front(), modo)) {
+    std::cout << "ERROR: Modo DES desconocido en la cabecera de " << archivoCifrado << std::endl;
+    return false;
+  }
+  if (modo != DesModes::Mode::ECB) {
+    lineas.erase(lineas.begin());
+    return DescifrarDESEncadenado(lineas, clave, modo);
   }
 
-  // Crea el codificador DES
-  DES des(desClave);
+  // Junta los bloques de todas las lineas; un bloque incompleto se completa con ceros
+  std::vector<uint64_t> bloques;
+  bloques.reserve(entrada.size() / 8 + 1);
+  for (std::string_view linea : lineas) {
+    for (size_t j = 0; j < linea.size(); j += 8) {
+      bloques.push_back(DesCore::load(linea.data() + j, linea.size() - j));
+    }
+  }
+  DesBitslice des(DES::keyFromString(clave).to_ullong());
+  des.decryptBlocks(bloques.data(), bloques.data(), bloques.size());
+
+  // Rearma cada linea, quita el relleno de espacios y guarda los registros validos
+  std::string lineaOriginal;
+  size_t siguiente = 0;
   int contador = 0;
+  for (std::string_view linea : lineas) {
+    size_t numBloques = (linea.size() + 7) / 8;
+    lineaOriginal.resize(numBloques * 8);
+    for (size_t b = 0; b < numBloques; b++) {
+      DesCore::store(bloques[siguiente++], &lineaOriginal[b * 8]);
+    }
+    size_t endpos = lineaOriginal.find_last_not_of(" ");
+    if (endpos != std::string::npos) {
+      lineaOriginal.resize(endpos + 1);
+    }
+    if (registros.append(lineaOriginal)) {
+      contador++;
+    }
+  }
 
-  for (size_t i = 0; i < registros.size(); i++) {
-    std::string lineaOriginal = registros[i].user + ":" +
-      registros[i].password + ":" +
-      registros[i].others;
+  std::cout << "\n[OK] Se descifraron " << contador << " registros con DES" << std::endl;
+  return true;
+}
 
-    // DES trabaja con bloques de 8 caracteres
-    std::string lineaCifrada = "";
+bool
+FileProtector::CifrarDESEncadenado(const std::string& archivoSalida,
+                                   const std::string& clave,
+                                   DesModes::Mode modo,
+                                   bool agregar) {
+  // Un IV aleatorio por registro, asi cada linea se descifra por su cuenta
+  CryptoGenerator generador;
+  std::vector<std::string_view> lineas(registros.size());
+  std::vector<uint64_t> vectores(registros.size());
+  for (size_t i = 0; i < registros.size(); i++) {
+    lineas[i] = registros.line(i);
+    std::vector<uint8_t> iv = generador.generateIV(8);
+    vectores[i] = DesCore::load(reinterpret_cast<const char*>(iv.data()), 8);
+  }
 
-    // Procesa la linea en bloques de 8 caracteres
-    for (size_t j = 0; j < lineaOriginal.length(); j += 8) {
-      std::string bloque = lineaOriginal.substr(j, 8);
+  DesModes des(clave);
+  std::vector<std::string> cifradas;
+  des.encryptRecords(modo, lineas, vectores, cifradas);
 
-      // Rellena con espacios si es necesario
-      while (bloque.length() < 8) {
-        bloque += ' ';
-      }
+  bool faltaSalto = agregar && FaltaSaltoFinal(archivoSalida);
+  std::ofstream salida(archivoSalida, agregar ? std::ios::app : std::ios::out);
+  if (!salida.is_open()) {
+    std::cout << "ERROR: No se pudo crear " << archivoSalida << std::endl;
+    return false;
+  }
+  if (faltaSalto) {
+    salida << '\n';
+  }
+  if (!agregar) {
+    salida << DesModes::header(modo) << '\n';
+  }
+  for (const std::string& linea : cifradas) {
+    salida << linea << '\n';
+  }
 
-      // Convierte el bloque a bitset
-      std::bitset<64> bloqueOriginal = des.stringToBitset64(bloque);
+  salida.close();
+  std::cout << "\n[OK] Se cifraron " << cifradas.size() << " registros con DES ("
+            << DesModes::name(modo) << ")" << (agregar ? " y se agregaron al archivo" : "")
+            << std::endl;
+  return true;
+}
 
-      // Cifra el bloque
-      std::bitset<64> bloqueCifrado = des.encode(bloqueOriginal);
+bool
+FileProtector::DescifrarDESEncadenado(const std::vector<std::string_view>& lineas,
+                                      const std::string& clave,
+                                      DesModes::Mode modo) {
+  DesModes des(clave);
+  std::vector<std::string> descifradas;
+  std::string error;
+  if (!des.decryptRecords(modo, lineas, descifradas, &error)) {
+    std::cout << "ERROR: " << error << std::endl;
+    return false;
+  }
 
-      // Convierte de vuelta a string
-      lineaCifrada += des.bitset64ToString(bloqueCifrado);
+  int contador = 0;
+  for (const std::string& linea : descifradas) {
+    if (registros.append(linea)) {
+      contador++;
     }
+  }
+
+  std::cout << "\n[OK] Se descifraron " << contador << " registros con DES ("
+            << DesModes::name(modo) << ")" << std::endl;
+  return true;
+}
 
-    salida << lineaCifrada << std::endl;
+bool
+FileProtector::GuardarEnArchivo(const std::string& nombreArchivo) {
+  if (registros.empty()) {
+    std::cout << "ERROR: No hay datos para guardar" << std::endl;
+    return false;
+  }
+
+  std::ofstream salida(nombreArchivo);
+  if (!salida.is_open()) {
+    std::cout << "ERROR: No se pudo crear " << nombreArchivo << std::endl;
+    return false;
+  }
+
+  // Escribe cada registro, la linea ya tiene el formato user:password:others
+  int contador = 0;
+  for (size_t i = 0; i < registros.size(); i++) {
+    std::string_view linea = registros.line(i);
+    salida.write(linea.data(), linea.size());
+    salida << '\n';
     contador++;
   }
 
   salida.close();
-  std::cout << "\n[OK] Se cifraron " << contador << " registros con DES" << std::endl;
+  std::cout << "\n[OK] Se guardaron " << contador << " registros en el archivo" << std::endl;
   return true;
 }
 
+size_t
+FileProtector::NumeroRegistros() const {
+  return registros.size();
+}
+
+ImportantInfo
+FileProtector::ObtenerRegistro(size_t indice) const {
+  return registros.get(indice);
+}
+
 bool
-FileProtector::DescifrarXOR(const std::string& archivoCifrado,
-                            const std::string& clave) {
-  registros.clear();
+FileProtector::CifrarRegistros(const std::string& archivoSalida,
+                               RecordCipher& cifrador,
+                               bool agregar) {
+  // Si el archivo existente no termina en salto de linea, su ultimo registro
+  // quedaria pegado al primero de los nuevos
+  bool faltaSalto = agregar && FaltaSaltoFinal(archivoSalida);
 
-  std::ifstream entrada(archivoCifrado);
-  if (!entrada.is_open()) {
-    std::cout << "ERROR: No se pudo abrir " << archivoCifrado << std::endl;
+  // Abre el archivo de salida
+  std::ofstream salida(archivoSalida, agregar ? std::ios::app : std::ios::out);
+  if (!salida.is_open()) {
+    std::cout << "ERROR: No se pudo crear " << archivoSalida << std::endl;
     return false;
   }
+  if (faltaSalto) {
+    salida << '\n';
+  }
 
-  XOREncoder codificador;
+  // Recorre los registros y los cifra
+  std::string lineaOriginal;
   std::string lineaCifrada;
   int contador = 0;
+  for (size_t i = 0; i < registros.size(); i++) {
+    // La linea user:password:others ya esta junta en el buffer
+    lineaOriginal.assign(registros.line(i));
 
-  while (std::getline(entrada, lineaCifrada)) {
-    if (lineaCifrada.empty()) {
-      continue;
-    }
-
-    // Descifra la linea
-    std::string lineaOriginal = codificador.encode(lineaCifrada, clave);
-
-    // Extrae los campos
-    size_t pos1 = lineaOriginal.find(':');
-    size_t pos2 = lineaOriginal.find(':', pos1 + 1);
-
-    if (pos1 != std::string::npos && pos2 != std::string::npos) {
-      ImportantInfo dato;
-      dato.user = lineaOriginal.substr(0, pos1);
-      dato.password = lineaOriginal.substr(pos1 + 1, pos2 - pos1 - 1);
-      dato.others = lineaOriginal.substr(pos2 + 1);
+    // Cifra la linea
+    cifrador.encrypt(lineaOriginal, lineaCifrada);
 
-      registros.push_back(dato);
-      contador++;
-    }
+    // Escribe al archivo, el flujo junta las lineas en escrituras grandes
+    salida << lineaCifrada << '\n';
+    contador++;
   }
 
-  entrada.close();
-  std::cout << "\n[OK] Se descifraron " << contador << " registros con XOR" << std::endl;
+  salida.close();
+  std::cout << "\n[OK] Se cifraron " << contador << " registros con "
+            << RecordCipher::name(cifrador.type())
+            << (agregar ? " y se agregaron al archivo" : "") << std::endl;
   return true;
 }
 
 bool
-FileProtector::DescifrarCaesar(const std::string& archivoCifrado,
-                               int desplazamiento) {
-  registros.clear();
-
-  std::ifstream entrada(archivoCifrado);
-  if (!entrada.is_open()) {
+FileProtector::DescifrarArchivo(const std::string& archivoCifrado,
+                                RecordCipher& cifrador) {
+  MappedFile entrada;
+  if (!entrada.open(archivoCifrado)) {
     std::cout << "ERROR: No se pudo abrir " << archivoCifrado << std::endl;
     return false;
   }
 
-  CesarEncryption cesar;
   std::string lineaCifrada;
+  std::string lineaOriginal;
   int contador = 0;
 
-  while (std::getline(entrada, lineaCifrada)) {
-    if (lineaCifrada.empty()) {
-      continue;
+  RecordParser::forEachLine(entrada.data(), entrada.size(),
+                            [&](const char* linea, size_t longitud) {
+    if (longitud == 0) {
+      return;
     }
 
     // Descifra la linea
-    std::string lineaOriginal = cesar.decode(lineaCifrada, desplazamiento);
+    lineaCifrada.assign(linea, longitud);
+    cifrador.decrypt(lineaCifrada, lineaOriginal);
 
-    // Extrae los campos
-    size_t pos1 = lineaOriginal.find(':');
-    size_t pos2 = lineaOriginal.find(':', pos1 + 1);
+    // Copia los registros validos a los bloques del almacen
+    if (registros.append(lineaOriginal)) {
+      contador++;
+    }
+  }, RecordParser::LineEnding::Encrypted);
 
-    if (pos1 != std::string::npos && pos2 != std::string::npos) {
-      ImportantInfo dato;
-      dato.user = lineaOriginal.substr(0, pos1);
-      dato.password = lineaOriginal.substr(pos1 + 1, pos2 - pos1 - 1);
-      dato.others = lineaOriginal.substr(pos2 + 1);
+  std::cout << "\n[OK] Se descifraron " << contador << " registros con "
+            << RecordCipher::name(cifrador.type()) << std::endl;
+  return true;
+}
 
-      registros.push_back(dato);
-      contador++;
+bool
+FileProtector::CifrarStream(const std::string& archivoEntrada,
+                            const std::string& archivoSalida,
+                            CipherType tipo,
+                            const std::string& clave) {
+  try {
+    RecordCipher cifrador(tipo, clave);
+
+    long long contador = ProcesarStream(archivoEntrada, archivoSalida, cifrador, true);
+    if (contador < 0) {
+      return false;
     }
+
+    std::cout << "\n[OK] Se cifraron " << contador << " registros con "
+              << RecordCipher::name(tipo) << " (streaming)" << std::endl;
+    return true;
   }
+  catch (const std::exception& e) {
+    std::cout << "ERROR: " << e.what() << std::endl;
+    return false;
+  }
+}
 
-  entrada.close();
-  std::cout << "\n[OK] Se descifraron " << contador << " registros con Caesar" << std::endl;
-  return true;
+bool
+FileProtector::DescifrarStream(const std::string& archivoCifrado,
+                               const std::string& archivoSalida,
+                               CipherType tipo,
+                               const std::string& clave) {
+  try {
+    RecordCipher cifrador(tipo, clave);
+
+    long long contador = ProcesarStream(archivoCifrado, archivoSalida, cifrador, false);
+    if (contador < 0) {
+      return false;
+    }
+
+    std::cout << "\n[OK] Se descifraron " << contador << " registros con "
+              << RecordCipher::name(tipo) << " (streaming)" << std::endl;
+    return true;
+  }
+  catch (const std::exception& e) {
+    std::cout << "ERROR: " << e.what() << std::endl;
+    return false;
+  }
 }
 
 bool
-FileProtector::DescifrarASCIIBinary(const std::string& archivoCifrado) {
-  registros.clear();
+FileProtector::CifrarEnEtapas(const std::string& archivoEntrada,
+                              const std::string& archivoSalida,
+                              CipherType tipo,
+                              const std::string& clave,
+                              unsigned int hilos) {
+  try {
+    RecordCipher cifrador(tipo, clave);
+
+    long long contador = ProcesarEnEtapas(archivoEntrada, archivoSalida, cifrador, true, hilos);
+    if (contador < 0) {
+      return false;
+    }
 
-  std::ifstream entrada(archivoCifrado);
-  if (!entrada.is_open()) {
-    std::cout << "ERROR: No se pudo abrir " << archivoCifrado << std::endl;
+    std::cout << "\n[OK] Se cifraron " << contador << " registros con "
+              << RecordCipher::name(tipo) << " (por etapas)" << std::endl;
+    return true;
+  }
+  catch (const std::exception& e) {
+    std::cout << "ERROR: " << e.what() << std::endl;
     return false;
   }
+}
 
-  AsciiBinary ascii;
-  std::string lineaCifrada;
-  int contador = 0;
+bool
+FileProtector::DescifrarEnEtapas(const std::string& archivoCifrado,
+                                 const std::string& archivoSalida,
+                                 CipherType tipo,
+                                 const std::string& clave,
+                                 unsigned int hilos) {
+  try {
+    RecordCipher cifrador(tipo, clave);
+
+    long long contador = ProcesarEnEtapas(archivoCifrado, archivoSalida, cifrador, false, hilos);
+    if (contador < 0) {
+      return false;
+    }
+
+    std::cout << "\n[OK] Se descifraron " << contador << " registros con "
+              << RecordCipher::name(tipo) << " (por etapas)" << std::endl;
+    return true;
+  }
+  catch (const std::exception& e) {
+    std::cout << "ERROR: " << e.what() << std::endl;
+    return false;
+  }
+}
+
+bool
+FileProtector::CifrarParalelo(const std::string& archivoSalida,
+                              CipherType tipo,
+                              const std::string& clave,
+                              unsigned int hilos) {
+  if (registros.empty()) {
+    std::cout << "ERROR: No hay registros para cifrar" << std::endl;
+    return false;
+  }
+
+  try {
+    // Valida la clave una sola vez, cada fragmento trabaja con una copia
+    RecordCipher plantilla(tipo, clave);
+
+    std::ofstream salida(archivoSalida);
+    if (!salida.is_open()) {
+      std::cout << "ERROR: No se pudo crear " << archivoSalida << std::endl;
+      return false;
+    }
 
-  while (std::getline(entrada, lineaCifrada)) {
-    if (lineaCifrada.empty()) {
-      continue;
+    if (hilos == 0) {
+      hilos = ThreadPool::defaultThreads();
     }
 
-    // Convierte de binario a string
-    std::string lineaOriginal = ascii.binaryToString(lineaCifrada);
+    // Fragmentos suficientes para repartir la carga entre los hilos
+    size_t tamFragmento = registros.size() / (static_cast<size_t>(hilos) * 8);
+    if (tamFragmento < REGISTROS_POR_FRAGMENTO) {
+      tamFragmento = REGISTROS_POR_FRAGMENTO;
+    }
+    size_t numFragmentos = (registros.size() + tamFragmento - 1) / tamFragmento;
+
+    auto cifrarFragmento = [this, &plantilla, tamFragmento](size_t fragmento) {
+      RecordCipher cifrador(plantilla);
+      size_t inicio = fragmento * tamFragmento;
+      size_t fin = std::min(inicio + tamFragmento, registros.size());
+
+      std::string lineaOriginal;
+      std::string lineaCifrada;
+      std::string resultado;
+      for (size_t i = inicio; i < fin; i++) {
+        lineaOriginal.assign(registros.line(i));
+        cifrador.encrypt(lineaOriginal, lineaCifrada);
+        resultado += lineaCifrada;
+        resultado += '\n';
+      }
+      return resultado;
+    };
+
+    // El pool se declara despues de la tarea para que se detenga antes de destruirla
+    ThreadPool pool(hilos);
+
+    // Mantiene pocos fragmentos en vuelo para acotar la memoria
+    // y escribe cada uno en cuanto terminan los anteriores
+    size_t enVuelo = static_cast<size_t>(hilos) * 2;
+    std::deque<std::future<std::string>> pendientes;
+    size_t siguiente = 0;
+
+    while (siguiente < numFragmentos && pendientes.size() < enVuelo) {
+      pendientes.push_back(pool.submit([&cifrarFragmento, siguiente]() {
+        return cifrarFragmento(siguiente);
+      }));
+      siguiente++;
+    }
 
-    // Extrae los campos
-    size_t pos1 = lineaOriginal.find(':');
-    size_t pos2 = lineaOriginal.find(':', pos1 + 1);
+    while (!pendientes.empty()) {
+      std::string bloque = pendientes.front().get();
+      pendientes.pop_front();
 
-    if (pos1 != std::string::npos && pos2 != std::string::npos) {
-      ImportantInfo dato;
-      dato.user = lineaOriginal.substr(0, pos1);
-      dato.password = lineaOriginal.substr(pos1 + 1, pos2 - pos1 - 1);
-      dato.others = lineaOriginal.substr(pos2 + 1);
+      if (siguiente < numFragmentos) {
+        pendientes.push_back(pool.submit([&cifrarFragmento, siguiente]() {
+          return cifrarFragmento(siguiente);
+        }));
+        siguiente++;
+      }
 
-      registros.push_back(dato);
-      contador++;
+      salida.write(bloque.data(), bloque.size());
     }
-  }
 
-  entrada.close();
-  std::cout << "\n[OK] Se descifraron " << contador << " registros con ASCII-Binary" << std::endl;
-  return true;
+    if (!salida) {
+      std::cout << "ERROR: No se pudo escribir en " << archivoSalida << std::endl;
+      return false;
+    }
+
+    std::cout << "\n[OK] Se cifraron " << registros.size() << " registros con "
+              << RecordCipher::name(tipo) << " en " << hilos << " hilos" << std::endl;
+    return true;
+  }
+  catch (const std::exception& e) {
+    std::cout << "ERROR: " << e.what() << std::endl;
+    return false;
+  }
 }
 
 bool
-FileProtector::DescifrarVigenere(const std::string& archivoCifrado,
+FileProtector::GuardarContenedor(const std::string& archivoSalida,
+                                 CipherType tipo,
                                  const std::string& clave) {
-  registros.clear();
+  if (registros.empty()) {
+    std::cout << "ERROR: No hay registros para cifrar" << std::endl;
+    return false;
+  }
 
-  std::ifstream entrada(archivoCifrado);
-  if (!entrada.is_open()) {
-    std::cout << "ERROR: No se pudo abrir " << archivoCifrado << std::endl;
+  try {
+    RecordCipher cifrador(tipo, clave);
+
+    // Sal aleatoria para el valor de comprobacion de la clave
+    CryptoGenerator generador;
+    std::vector<uint8_t> sal = generador.generateSalt(16);
+    SipHash::Key salKey;
+    std::copy(sal.begin(), sal.end(), salKey.begin());
+
+    ContainerWriter contenedor;
+    if (!contenedor.create(archivoSalida, tipo, clave, salKey)) {
+      std::cout << "ERROR: No se pudo crear " << archivoSalida << std::endl;
+      return false;
+    }
+
+    std::string lineaOriginal;
+    std::string lineaCifrada;
+    for (size_t i = 0; i < registros.size(); i++) {
+      lineaOriginal.assign(registros.line(i));
+      cifrador.encrypt(lineaOriginal, lineaCifrada);
+      contenedor.add(lineaCifrada);
+    }
+
+    if (!contenedor.finish()) {
+      std::cout << "ERROR: No se pudo escribir en " << archivoSalida << std::endl;
+      return false;
+    }
+
+    // Indice ciego de usuarios junto al contenedor, con su propia sal
+    std::vector<std::string_view> usuarios;
+    usuarios.reserve(registros.size());
+    for (size_t i = 0; i < registros.size(); i++) {
+      usuarios.push_back(registros.user(i));
+    }
+    sal = generador.generateSalt(16);
+    std::copy(sal.begin(), sal.end(), salKey.begin());
+    if (!BlindIndex::write(archivoSalida + ".idx", clave, salKey, usuarios)) {
+      std::cout << "ERROR: No se pudo crear " << archivoSalida << ".idx" << std::endl;
+      return false;
+    }
+
+    std::cout << "\n[OK] Se cifraron " << registros.size() << " registros con "
+              << RecordCipher::name(tipo) << " en el contenedor" << std::endl;
+    return true;
+  }
+  catch (const std::exception& e) {
+    std::cout << "ERROR: " << e.what() << std::endl;
     return false;
   }
+}
 
-  Vigenere vig(clave);
-  std::string lineaCifrada;
-  int contador = 0;
+bool
+FileProtector::AgregarCifrado(const std::string& archivoCifrado,
+                              CipherType tipo,
+                              const std::string& clave) {
+  if (registros.empty()) {
+    std::cout << "ERROR: No hay registros para cifrar" << std::endl;
+    return false;
+  }
+
+  try {
+    RecordCipher cifrador(tipo, clave);
 
-  while (std::getline(entrada, lineaCifrada)) {
-    if (lineaCifrada.empty()) {
-      continue;
+    // Una clave distinta dejaria un archivo que ninguna clave descifra completo
+    DesModes::Mode modo = DesModes::Mode::ECB;
+    if (!ClaveCorrespondeArchivo(archivoCifrado, cifrador, clave, modo)) {
+      return false;
     }
+    if (modo != DesModes::Mode::ECB) {
+      return CifrarDESEncadenado(archivoCifrado, clave, modo, true);
+    }
+    return CifrarRegistros(archivoCifrado, cifrador, true);
+  }
+  catch (const std::exception& e) {
+    std::cout << "ERROR: " << e.what() << std::endl;
+    return false;
+  }
+}
 
-    // Descifra la linea
-    std::string lineaOriginal = vig.decode(lineaCifrada);
+bool
+FileProtector::ClaveCorrespondeArchivo(const std::string& archivoCifrado,
+                                       RecordCipher& cifrador,
+                                       const std::string& clave,
+                                       DesModes::Mode& modo) {
+  // Solo el comienzo del archivo, sin la ultima linea si quedo cortada
+  const size_t LECTURA_MAXIMA = 1 << 16;
+  const size_t LINEAS_MUESTRA = 64;
+  modo = DesModes::Mode::ECB;
+  std::ifstream existente(archivoCifrado, std::ios::binary);
+  if (!existente.is_open()) {
+    return true;
+  }
+  std::string inicio(LECTURA_MAXIMA, '\0');
+  existente.read(&inicio[0], static_cast<std::streamsize>(inicio.size()));
+  inicio.resize(static_cast<size_t>(existente.gcount()));
+  if (inicio.size() == LECTURA_MAXIMA && inicio.rfind('\n') != std::string::npos) {
+    inicio.resize(inicio.rfind('\n') + 1);
+  }
 
-    // Extrae los campos
-    size_t pos1 = lineaOriginal.find(':');
-    size_t pos2 = lineaOriginal.find(':', pos1 + 1);
+  // Las lineas vacias se conservan: pueden ser un '\n' dentro de un registro cifrado
+  std::vector<std::string_view> lineas;
+  RecordParser::forEachLine(inicio.data(), inicio.size(), [&lineas](const char* linea, size_t longitud) {
+    lineas.emplace_back(linea, longitud);
+  }, RecordParser::LineEnding::Encrypted);
+  if (std::all_of(lineas.begin(), lineas.end(), [](std::string_view linea) { return linea.empty(); })) {
+    return true;
+  }
+  if (cifrador.type() == CipherType::DES) {
+    if (!DesModes::parseHeader(lineas.front(), modo)) {
+      std::cout << "ERROR: Modo DES desconocido en la cabecera de " << archivoCifrado << std::endl;
+      return false;
+    }
+    if (modo != DesModes::Mode::ECB) {
+      lineas.erase(lineas.begin());
+    }
+  }
+  if (lineas.size() > LINEAS_MUESTRA) {
+    lineas.resize(LINEAS_MUESTRA);
+  }
 
-    if (pos1 != std::string::npos && pos2 != std::string::npos) {
-      ImportantInfo dato;
-      dato.user = lineaOriginal.substr(0, pos1);
-      dato.password = lineaOriginal.substr(pos1 + 1, pos2 - pos1 - 1);
-      dato.others = lineaOriginal.substr(pos2 + 1);
+  // Un registro descifrado no tiene caracteres de control
+  auto esRegistro = [](const std::string& registro) {
+    return RecordCipher::isRecord(registro) &&
+           std::none_of(registro.begin(), registro.end(), [](char c) {
+             unsigned char u = static_cast<unsigned char>(c);
+             return (u < 0x20 && u != '\t') || u == 0x7F;
+           });
+  };
+
+  size_t validos = 0;
+  size_t invalidos = 0;
+  if (modo != DesModes::Mode::ECB) {
+    // Las lineas CBC y CTR son hexadecimales, nunca se parten
+    lineas.erase(std::remove_if(lineas.begin(), lineas.end(),
+                                [](std::string_view linea) { return linea.empty(); }),
+                 lineas.end());
+    DesModes des(clave);
+    std::vector<std::string> descifradas;
+    if (des.decryptRecords(modo, lineas, descifradas, nullptr)) {
+      for (const std::string& registro : descifradas) {
+        (esRegistro(registro) ? validos : invalidos)++;
+      }
+    }
+    else {
+      invalidos = lineas.size();
+    }
+  }
+  else {
+    // Un salto de linea dentro del cifrado parte el registro en varias lineas. Se busca
+    // la division de la muestra en registros completos (de 1 a PARTES_MAXIMAS lineas
+    // unidas por '\n') que deje menos lineas sueltas; una linea suelta cuenta como
+    // invalida y el registro siguiente empieza en la linea de despues. Asi un trozo que
+    // por si solo parece un registro no arrastra a los registros que le siguen
+    const size_t PARTES_MAXIMAS = 4;
+    struct Division {
+      size_t invalidos = 0;
+      size_t validos = 0;
+    };
+    size_t total = lineas.size();
+    std::vector<Division> mejor(total + 1);
+    std::string lineaCifrada;
+    std::string lineaOriginal;
+    for (size_t i = total; i-- > 0;) {
+      // Linea suelta; una vacia fuera de un registro no cuenta
+      mejor[i] = mejor[i + 1];
+      if (!lineas[i].empty()) {
+        mejor[i].invalidos++;
+      }
 
-      registros.push_back(dato);
-      contador++;
+      lineaCifrada.clear();
+      for (size_t partes = 1; partes <= PARTES_MAXIMAS && i + partes <= total; ++partes) {
+        if (partes > 1) {
+          lineaCifrada += '\n';
+        }
+        std::string_view linea = lineas[i + partes - 1];
+        lineaCifrada.append(linea.data(), linea.size());
+        cifrador.decrypt(lineaCifrada, lineaOriginal);
+        if (!esRegistro(lineaOriginal)) {
+          continue;
+        }
+        const Division& resto = mejor[i + partes];
+        if (resto.invalidos < mejor[i].invalidos ||
+            (resto.invalidos == mejor[i].invalidos && resto.validos + 1 > mejor[i].validos)) {
+          mejor[i].invalidos = resto.invalidos;
+          mejor[i].validos = resto.validos + 1;
+        }
+      }
     }
+    validos = mejor[0].validos;
+    invalidos = mejor[0].invalidos;
   }
 
-  entrada.close();
-  std::cout << "\n[OK] Se descifraron " << contador << " registros con Vigenere" << std::endl;
+  if (validos == 0 || invalidos * 4 > validos) {
+    std::cout << "ERROR: La clave no corresponde a los registros de " << archivoCifrado << std::endl;
+    return false;
+  }
   return true;
 }
 
 bool
-FileProtector::DescifrarDES(const std::string& archivoCifrado,
-                            const std::string& clave) {
-  registros.clear();
-
-  if (clave.length() != 8) {
-    std::cout << "ERROR: La clave DES debe tener exactamente 8 caracteres" << std::endl;
+FileProtector::FaltaSaltoFinal(const std::string& archivo) {
+  std::ifstream existente(archivo, std::ios::binary | std::ios::ate);
+  if (!existente.is_open() || existente.tellg() <= 0) {
     return false;
   }
+  char ultimo = '\n';
+  existente.seekg(-1, std::ios::end);
+  existente.get(ultimo);
+  return ultimo != '\n';
+}
 
-  std::ifstream entrada(archivoCifrado);
-  if (!entrada.is_open()) {
-    std::cout << "ERROR: No se pudo abrir " << archivoCifrado << std::endl;
+bool
+FileProtector::AgregarAContenedor(const std::string& archivoContenedor,
+                                  const std::string& clave) {
+  if (registros.empty()) {
+    std::cout << "ERROR: No hay registros para cifrar" << std::endl;
     return false;
   }
 
-  // Convierte la clave a bitset de 64 bits
-  std::bitset<64> desClave;
-  for (int i = 0; i < 8; i++) {
-    unsigned char c = clave[i];
-    for (int j = 0; j < 8; j++) {
-      desClave[i * 8 + j] = (c >> (7 - j)) & 1;
+  try {
+    // Solo lee la cabecera y comprueba la clave: ni los registros ni el indice se leen
+    ContainerWriter contenedor;
+    std::string error;
+    if (!contenedor.append(archivoContenedor, clave, error)) {
+      std::cout << "ERROR: " << error << std::endl;
+      return false;
+    }
+    RecordCipher cifrador(contenedor.cipher(), clave);
+    uint64_t primero = contenedor.size();
+
+    std::string lineaOriginal;
+    std::string lineaCifrada;
+    for (size_t i = 0; i < registros.size(); i++) {
+      lineaOriginal.assign(registros.line(i));
+      cifrador.encrypt(lineaOriginal, lineaCifrada);
+      contenedor.add(lineaCifrada);
+    }
+
+    if (!contenedor.finish()) {
+      std::cout << "ERROR: No se pudo escribir en " << archivoContenedor << std::endl;
+      return false;
+    }
+
+    // Agrega una tabla con los usuarios nuevos al indice ciego, conservando su sal
+    std::vector<std::string_view> usuarios;
+    usuarios.reserve(registros.size());
+    for (size_t i = 0; i < registros.size(); i++) {
+      usuarios.push_back(registros.user(i));
+    }
+    if (!BlindIndex::append(archivoContenedor + ".idx", clave, primero, usuarios, error)) {
+      std::cout << "AVISO: No se actualizo el indice ciego: " << error << std::endl;
     }
+
+    std::cout << "\n[OK] Se agregaron " << registros.size() << " registros con "
+              << RecordCipher::name(cifrador.type()) << " al contenedor" << std::endl;
+    return true;
+  }
+  catch (const std::exception& e) {
+    std::cout << "ERROR: " << e.what() << std::endl;
+    return false;
   }
+}
+
+bool
+FileProtector::DescifrarContenedor(const std::string& archivoContenedor,
+                                   const std::string& clave) {
+  return LeerRangoContenedor(archivoContenedor, clave, 0, UINT64_MAX);
+}
 
-  // Crea el codificador DES
-  DES des(desClave);
+bool
+FileProtector::LeerRangoContenedor(const std::string& archivoContenedor,
+                                   const std::string& clave,
+                                   uint64_t desde,
+                                   uint64_t cantidad) {
+  registros.clear();
+
+  ContainerReader lector;
+  std::unique_ptr<RecordCipher> cifrador = AbrirContenedor(archivoContenedor, clave, lector);
+  if (!cifrador) {
+    return false;
+  }
+
+  if (desde > lector.size()) {
+    std::cout << "ERROR: El contenedor solo tiene " << lector.size() << " registros" << std::endl;
+    return false;
+  }
+
+  // Solo se tocan los registros del rango
+  uint64_t hasta = desde + std::min(cantidad, lector.size() - desde);
   std::string lineaCifrada;
+  std::string lineaOriginal;
   int contador = 0;
 
-  while (std::getline(entrada, lineaCifrada)) {
-    if (lineaCifrada.empty()) {
-      continue;
+  try {
+    for (uint64_t i = desde; i < hasta; i++) {
+      lineaCifrada.assign(lector.record(i));
+      cifrador->decrypt(lineaCifrada, lineaOriginal);
+      if (registros.append(lineaOriginal)) {
+        contador++;
+      }
     }
+  }
+  catch (const std::exception& e) {
+    std::cout << "ERROR: " << e.what() << std::endl;
+    return false;
+  }
 
-    // Descifra la linea en bloques de 8 caracteres
-    std::string lineaOriginal = "";
+  std::cout << "\n[OK] Se descifraron " << contador << " registros con "
+            << RecordCipher::name(cifrador->type()) << " del contenedor" << std::endl;
+  return true;
+}
 
-    for (size_t j = 0; j < lineaCifrada.length(); j += 8) {
-      std::string bloque = lineaCifrada.substr(j, 8);
+bool
+FileProtector::LeerRegistroContenedor(const std::string& archivoContenedor,
+                                      const std::string& clave,
+                                      uint64_t indice,
+                                      ImportantInfo& registro) {
+  ContainerReader lector;
+  std::unique_ptr<RecordCipher> cifrador = AbrirContenedor(archivoContenedor, clave, lector);
+  if (!cifrador) {
+    return false;
+  }
 
-      // Convierte el bloque a bitset
-      std::bitset<64> bloqueCifrado = des.stringToBitset64(bloque);
+  if (indice >= lector.size()) {
+    std::cout << "ERROR: El contenedor solo tiene " << lector.size() << " registros" << std::endl;
+    return false;
+  }
 
-      // Descifra el bloque
-      std::bitset<64> bloqueOriginal = des.decode(bloqueCifrado);
+  try {
+    std::string lineaCifrada(lector.record(indice));
+    std::string lineaOriginal;
+    cifrador->decrypt(lineaCifrada, lineaOriginal);
 
-      // Convierte de vuelta a string
-      lineaOriginal += des.bitset64ToString(bloqueOriginal);
+    RecordSpan campos;
+    if (!RecordParser::parseLine(lineaOriginal.data(), 0, lineaOriginal.size(), campos)) {
+      std::cout << "ERROR: El registro " << indice << " no tiene el formato esperado" << std::endl;
+      return false;
     }
 
-    // Quita espacios al final si los hay
-    size_t endpos = lineaOriginal.find_last_not_of(" ");
-    if (endpos != std::string::npos) {
-      lineaOriginal = lineaOriginal.substr(0, endpos + 1);
-    }
+    registro.user = std::string(campos.user(lineaOriginal.data()));
+    registro.password = std::string(campos.password(lineaOriginal.data()));
+    registro.others = std::string(campos.others(lineaOriginal.data()));
+    return true;
+  }
+  catch (const std::exception& e) {
+    std::cout << "ERROR: " << e.what() << std::endl;
+    return false;
+  }
+}
 
-    // Extrae los campos
-    size_t pos1 = lineaOriginal.find(':');
-    size_t pos2 = lineaOriginal.find(':', pos1 + 1);
+bool
+FileProtector::BuscarPorUsuario(const std::string& archivoContenedor,
+                                const std::string& clave,
+                                const std::string& usuario,
+                                ImportantInfo& registro) {
+  BlindIndex indice;
+  if (!indice.open(archivoContenedor + ".idx", clave)) {
+    std::cout << "ERROR: " << indice.error() << std::endl;
+    return false;
+  }
 
-    if (pos1 != std::string::npos && pos2 != std::string::npos) {
-      ImportantInfo dato;
-      dato.user = lineaOriginal.substr(0, pos1);
-      dato.password = lineaOriginal.substr(pos1 + 1, pos2 - pos1 - 1);
-      dato.others = lineaOriginal.substr(pos2 + 1);
+  ContainerReader lector;
+  std::unique_ptr<RecordCipher> cifrador = AbrirContenedor(archivoContenedor, clave, lector);
+  if (!cifrador) {
+    return false;
+  }
 
-      registros.push_back(dato);
-      contador++;
+  try {
+    std::string lineaCifrada;
+    std::string lineaOriginal;
+
+    // Confirma cada candidato, dos usuarios pueden compartir el mismo hash
+    for (uint64_t candidato : indice.find(usuario)) {
+      lineaCifrada.assign(lector.record(candidato));
+      cifrador->decrypt(lineaCifrada, lineaOriginal);
+
+      RecordSpan campos;
+      if (RecordParser::parseLine(lineaOriginal.data(), 0, lineaOriginal.size(), campos) &&
+          campos.user(lineaOriginal.data()) == usuario) {
+        registro.user = usuario;
+        registro.password = std::string(campos.password(lineaOriginal.data()));
+        registro.others = std::string(campos.others(lineaOriginal.data()));
+        return true;
+      }
     }
   }
+  catch (const std::exception& e) {
+    std::cout << "ERROR: " << e.what() << std::endl;
+    return false;
+  }
 
-  entrada.close();
-  std::cout << "\n[OK] Se descifraron " << contador << " registros con DES" << std::endl;
+  std::cout << "No se encontro el usuario " << usuario << std::endl;
+  return false;
+}
+
+bool
+FileProtector::RecuperarClaveXOR(const std::string& archivoCifrado,
+                                 std::string& clave,
+                                 XORCracker::Attack ataque,
+                                 size_t longitudMaxima) {
+  auto inicio = std::chrono::steady_clock::now();
+  XORCracker::Result resultado;
+  if (!XORCracker::crackFile(archivoCifrado, resultado, longitudMaxima, ataque)) {
+    std::cout << "ERROR: No se pudo leer " << archivoCifrado << std::endl;
+    return false;
+  }
+  double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+
+  std::ostringstream reporte;
+  reporte << std::fixed << std::setprecision(1)
+          << "Longitud de clave: " << resultado.keyLength
+          << ", registros validos: " << resultado.validRecords * 100 << "%";
+  if (ataque == XORCracker::Attack::Crib) {
+    reporte << ", con final conocido: " << resultado.cribMatches * 100 << "%";
+  }
+  reporte << std::setprecision(3) << ", " << segundos << " s";
+  std::cout << reporte.str() << '\n';
+
+  if (resultado.validRecords == 0) {
+    std::cout << "No se encontro una clave que descifre registros" << std::endl;
+    return false;
+  }
+  clave = resultado.key;
+  std::cout << "\n[OK] Clave encontrada: \"" << clave << "\" (0x" << HexCodec::encode(clave) << ")" << std::endl;
   return true;
 }
 
 bool
-FileProtector::GuardarEnArchivo(const std::string& nombreArchivo) {
-  if (registros.empty()) {
-    std::cout << "ERROR: No hay datos para guardar" << std::endl;
+FileProtector::RecuperarClaveCaesar(const std::string& archivoCifrado,
+                                    int& desplazamiento,
+                                    unsigned int hilos) {
+  auto inicio = std::chrono::steady_clock::now();
+  CaesarCracker::FileResult resultado;
+  if (!CaesarCracker::crackFile(archivoCifrado, resultado, hilos)) {
+    std::cout << "ERROR: " << archivoCifrado << " no se pudo leer o no contiene letras" << std::endl;
     return false;
   }
+  double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+
+  std::ostringstream reporte;
+  reporte << std::fixed << std::setprecision(1)
+          << "Lineas: " << resultado.lines.size()
+          << ", chi-cuadrado: " << resultado.best.chiSquared
+          << " (" << FrequencyAnalysis::name(resultado.best.language) << ")"
+          << ", lineas con el mismo desplazamiento: " << resultado.agreement * 100 << "%"
+          << std::setprecision(3) << ", " << segundos << " s";
+  std::cout << reporte.str() << '\n';
+
+  desplazamiento = resultado.best.key;
+  std::cout << "\n[OK] Desplazamiento encontrado: " << desplazamiento << std::endl;
+  return true;
+}
 
-  std::ofstream salida(nombreArchivo);
-  if (!salida.is_open()) {
-    std::cout << "ERROR: No se pudo crear " << nombreArchivo << std::endl;
+bool
+FileProtector::RecuperarClaveVigenere(const std::string& archivoCifrado,
+                                      std::string& clave,
+                                      size_t longitudMaxima) {
+  auto inicio = std::chrono::steady_clock::now();
+  VigenereCracker::Result resultado;
+  if (!VigenereCracker::crackFile(archivoCifrado, resultado, longitudMaxima)) {
+    std::cout << "ERROR: " << archivoCifrado << " no se pudo leer o no contiene letras" << std::endl;
     return false;
   }
+  double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+
+  std::ostringstream reporte;
+  reporte << std::fixed << std::setprecision(4)
+          << "Longitud de clave: " << resultado.keyLength
+          << ", indice de coincidencia: " << resultado.indexOfCoincidence
+          << " (" << FrequencyAnalysis::name(resultado.language) << ")"
+          << std::setprecision(3) << ", " << segundos << " s";
+  std::cout << reporte.str() << '\n';
+
+  clave = resultado.key;
+  std::cout << "\n[OK] Clave encontrada: \"" << clave << "\"" << std::endl;
+  return true;
+}
 
-  // Escribe cada registro
-  int contador = 0;
-  for (size_t i = 0; i < registros.size(); i++) {
-    salida << registros[i].user << ":"
-      << registros[i].password << ":"
-      << registros[i].others << std::endl;
-    contador++;
+bool
+FileProtector::RecuperarClaveDES(const std::string& archivoCifrado,
+                                 const std::string& mascara,
+                                 std::string& clave,
+                                 const std::string& inicioConocido,
+                                 const std::string& archivoAvance,
+                                 unsigned int hilos) {
+  DesKeySearch::Keyspace espacio;
+  if (!espacio.parseMask(mascara)) {
+    std::cout << "ERROR: " << espacio.error() << std::endl;
+    return false;
   }
 
-  salida.close();
-  std::cout << "\n[OK] Se guardaron " << contador << " registros en el archivo" << std::endl;
+  DesKeySearch::Options opciones;
+  opciones.crib = inicioConocido;
+  opciones.threads = hilos;
+  opciones.checkpointPath = archivoAvance;
+  bool mostroAvance = false;
+  opciones.onProgress = [&mostroAvance](const DesKeySearch::Progress& avance) {
+    std::ostringstream linea;
+    linea << std::fixed << std::setprecision(1)
+          << "\rProbadas " << avance.done << " de " << avance.total
+          << " (" << 100.0 * avance.done / avance.total << "%), "
+          << avance.keysPerSecond / 1e6 << " millones de claves/s"
+          << std::setprecision(0) << ", faltan " << avance.remainingSeconds << " s   ";
+    std::cout << linea.str() << std::flush;
+    mostroAvance = true;
+  };
+
+  DesKeySearch::Result resultado;
+  std::string error;
+  if (!DesKeySearch::searchFile(archivoCifrado, espacio, opciones, resultado, &error)) {
+    std::cout << "ERROR: " << error << std::endl;
+    return false;
+  }
+  if (mostroAvance) {
+    std::cout << '\n';
+  }
+
+  std::ostringstream reporte;
+  reporte << "Modo: " << DesModes::name(resultado.mode)
+          << ", motor: " << DesBitslice::name(resultado.engine)
+          << ", hilos: " << resultado.threads << '\n'
+          << "Claves probadas: " << resultado.tested << " de " << resultado.total;
+  if (resultado.resumedFrom > 0) {
+    reporte << " (retomada desde la clave " << resultado.resumedFrom << ")";
+  }
+  reporte << std::fixed << std::setprecision(1)
+          << ", " << resultado.keysPerSecond / 1e6 << " millones de claves/s"
+          << std::setprecision(3) << ", " << resultado.seconds << " s"
+          << ", candidatas: " << resultado.candidates;
+  std::cout << reporte.str() << '\n';
+
+  if (!resultado.found) {
+    if (resultado.exhausted) {
+      std::cout << "Ninguna clave de la mascara descifra " << archivoCifrado << std::endl;
+    }
+    else {
+      std::cout << "Busqueda detenida en la clave " << resultado.nextIndex
+                << "; se retoma con el mismo archivo de avance" << std::endl;
+    }
+    return false;
+  }
+
+  clave = resultado.key;
+  std::cout << "Registros de muestra validos: " << resultado.validSamples << " de " << resultado.samples << '\n'
+            << "Primer registro: " << resultado.plaintext << '\n';
+  if (resultado.equivalents.size() > 1) {
+    std::cout << "Claves equivalentes:";
+    for (const std::string& equivalente : resultado.equivalents) {
+      std::cout << " \"" << equivalente << "\"";
+    }
+    std::cout << '\n';
+  }
+  std::cout << "\n[OK] Clave encontrada: \"" << clave << "\"" << std::endl;
   return true;
-}
\ No newline at end of file
+}
+
+bool
+FileProtector::MedirMotoresDES(size_t bloques) {
+  std::vector<DesBitslice::BenchmarkResult> medidas = DesBitslice::benchmark(bloques);
+  bool coinciden = true;
+  std::ostringstream reporte;
+  reporte << std::fixed << std::setprecision(1);
+  for (const DesBitslice::BenchmarkResult& medida : medidas) {
+    reporte << DesBitslice::name(medida.engine) << ": " << medida.nanosecondsPerBlock << " ns por bloque"
+            << ", " << medida.speedup << "x";
+    if (!medida.identical) {
+      reporte << ", NO coincide con el escalar";
+      coinciden = false;
+    }
+    reporte << '\n';
+  }
+  std::cout << reporte.str();
+
+  if (!coinciden) {
+    std::cout << "ERROR: Un motor DES no da el mismo resultado que el escalar" << std::endl;
+    return false;
+  }
+  std::cout << "\n[OK] Se midieron " << medidas.size() << " motores DES con " << bloques << " bloques" << std::endl;
+  return true;
+}
+
+std::unique_ptr<RecordCipher>
+FileProtector::AbrirContenedor(const std::string& archivoContenedor,
+                               const std::string& clave,
+                               ContainerReader& lector) {
+  if (!lector.open(archivoContenedor)) {
+    std::cout << "ERROR: " << lector.error() << std::endl;
+    return nullptr;
+  }
+
+  // Rechaza una clave equivocada antes de descifrar nada
+  if (!lector.checkKey(clave)) {
+    std::cout << "ERROR: La clave no corresponde a este contenedor" << std::endl;
+    return nullptr;
+  }
+
+  try {
+    return std::make_unique<RecordCipher>(lector.header().cipher, clave);
+  }
+  catch (const std::exception& e) {
+    std::cout << "ERROR: " << e.what() << std::endl;
+    return nullptr;
+  }
+}
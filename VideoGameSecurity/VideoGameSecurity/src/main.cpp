@@ -5,6 +5,8 @@
 #include "AsciiBinary.h"
 #include "Vigenere.h"
 #include "DES.h"
+#include "EncryptionDaemon.h"
+#include <csignal>
 
 void
 mostrarMenu() {
@@ -13,7 +15,8 @@ mostrarMenu() {
   std::cout << "**********************************************" << std::endl;
   std::cout << "1. Cifrar archivo                " << std::endl;
   std::cout << "2. Descifrar archivo             " << std::endl;
-  std::cout << "3. Salir                         " << std::endl;
+  std::cout << "3. Vigilar carpeta (modo daemon) " << std::endl;
+  std::cout << "4. Salir                         " << std::endl;
   std::cout << "Seleccione una opcion: ";
 
 }
@@ -85,8 +88,211 @@ mostrarAdvertencia() {
   std::cout << "******************************************" << std::endl;
 }
 
+void
+detenerDaemon(int) {
+  EncryptionDaemon::requestStop();
+}
+
+/*
+* @brief Cifra en segundo plano los archivos nuevos o modificados de la carpeta de origen
+* @param origen Carpeta vigilada
+* @param destino Carpeta de los archivos cifrados
+* @param tipo Tipo de cifrado, del 1 al 5 como en el menu
+* @param clave Clave del cifrado (desplazamiento en Caesar)
+* @param hilos Archivos cifrados a la vez, 0 usa todos los nucleos
+* @param unaVez true para cifrar los archivos actuales y terminar
+* @return true si el daemon pudo iniciar
+*/
+bool
+ejecutarDaemon(const std::string& origen,
+               const std::string& destino,
+               const std::string& tipo,
+               const std::string& clave,
+               unsigned int hilos,
+               bool unaVez) {
+  if (tipo.size() != 1 || tipo[0] < '1' || tipo[0] > '5') {
+    std::cout << "\nOpcion de cifrado no valida" << std::endl;
+    return false;
+  }
+
+  try {
+    EncryptionDaemon::Config config;
+    config.sourceFolder = origen;
+    config.targetFolder = destino;
+    config.cipher = static_cast<CipherType>(tipo[0] - '0');
+    config.key = clave;
+    config.workers = hilos;
+    config.once = unaVez;
+
+    EncryptionDaemon daemon(config);
+    if (!unaVez) {
+      std::cout << "Presione Ctrl+C para detener el daemon" << std::endl;
+    }
+
+    // Ctrl+C detiene el daemon despues de los archivos en curso
+    std::signal(SIGINT, detenerDaemon);
+    bool ok = daemon.run();
+    std::signal(SIGINT, SIG_DFL);
+    return ok;
+  }
+  catch (const std::exception& e) {
+    std::cout << "ERROR: " << e.what() << std::endl;
+    return false;
+  }
+}
+
+/*
+* @brief Lee una variable de entorno
+* @return Su valor, vacio si no existe
+*/
+std::string
+variableDeEntorno(const char* nombre) {
+  std::string valor;
+#ifdef _WIN32
+  // getenv esta marcado como inseguro con las comprobaciones SDL de MSVC
+  char* copia = nullptr;
+  size_t longitud = 0;
+  if (_dupenv_s(&copia, &longitud, nombre) == 0 && copia != nullptr) {
+    valor = copia;
+    free(copia);
+  }
+#else
+  if (const char* entorno = std::getenv(nombre)) {
+    valor = entorno;
+  }
+#endif
+  return valor;
+}
+
+/*
+* @brief Obtiene la clave del daemon sin que aparezca en la linea de comandos
+* @param archivoClave Archivo con la clave en su primera linea, vacio si no se indico
+* @param clave Recibe la clave
+* @return true si se obtuvo una clave no vacia
+* @details Orden: archivo indicado, variable de entorno VGS_CLAVE y, si no hay ninguno,
+*          la entrada estandar. El archivo debe ser legible solo por su dueno.
+*/
+bool
+leerClaveDaemon(const std::string& archivoClave, std::string& clave) {
+  clave.clear();
+  if (!archivoClave.empty()) {
+    std::error_code ec;
+    std::filesystem::perms permisos = std::filesystem::status(archivoClave, ec).permissions();
+    if (ec) {
+      std::cout << "ERROR: No se pudo abrir " << archivoClave << std::endl;
+      return false;
+    }
+#ifndef _WIN32
+    const std::filesystem::perms otros = std::filesystem::perms::group_all |
+                                         std::filesystem::perms::others_all;
+    if ((permisos & otros) != std::filesystem::perms::none) {
+      std::cout << "ERROR: " << archivoClave << " no debe ser legible por otros usuarios (chmod 600)"
+                << std::endl;
+      return false;
+    }
+#else
+    (void)permisos;
+#endif
+    std::ifstream archivo(archivoClave);
+    std::getline(archivo, clave);
+  }
+  else {
+    clave = variableDeEntorno("VGS_CLAVE");
+    if (clave.empty()) {
+      std::cout << "Ingrese la clave: ";
+      std::getline(std::cin, clave);
+    }
+  }
+
+  if (!clave.empty() && clave.back() == '\r') {
+    clave.pop_back();
+  }
+  if (clave.empty()) {
+    std::cout << "ERROR: La clave no puede estar vacia" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/*
+* @brief Comprueba que un archivo cifrado admite agregar registros con su propia clave
+* @details Para XOR y DES cifra conjuntos aleatorios de registros en la carpeta temporal y
+*          les agrega registros nuevos con la misma clave, que debe aceptarse, y con otra
+*          clave, que debe rechazarse. XOR tambien usa la clave de ejemplo de archivos/Claves.txt
+* @return true si todas las pruebas dieron el resultado esperado
+*/
+bool
+comprobarAgregado() {
+  const int RONDAS = 100;
+  const int REGISTROS = 200;
+  const std::string CARACTERES =
+    "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789._-@!";
+  std::mt19937 generador(12345);
+  auto texto = [&](size_t minimo, size_t variacion) {
+    std::string resultado(minimo + generador() % variacion, ' ');
+    for (char& c : resultado) {
+      c = CARACTERES[generador() % CARACTERES.size()];
+    }
+    return resultado;
+  };
+  auto escribirRegistros = [&](const std::string& ruta, int cantidad) {
+    std::ofstream archivo(ruta);
+    for (int i = 0; i < cantidad; i++) {
+      archivo << texto(3, 10) << ":" << texto(4, 12) << ":" << texto(5, 20) << "\n";
+    }
+  };
+
+  std::filesystem::path carpeta = std::filesystem::temp_directory_path();
+  std::string crudos = (carpeta / "vgs_agregar_crudos.txt").string();
+  std::string nuevos = (carpeta / "vgs_agregar_nuevos.txt").string();
+  std::string cifrado = (carpeta / "vgs_agregar_cifrado.txt").string();
+  int fallos = 0;
+
+  for (CipherType tipo : { CipherType::XOR, CipherType::DES }) {
+    int rechazadas = 0;
+    int aceptadasErroneas = 0;
+    for (int ronda = 0; ronda < RONDAS; ronda++) {
+      bool esXor = tipo == CipherType::XOR;
+      std::string clave = (esXor && ronda == 0) ? "Fmuril123" : (esXor ? texto(4, 10) : texto(8, 1));
+      std::string otra = esXor ? texto(4, 10) : texto(8, 1);
+      escribirRegistros(crudos, REGISTROS);
+      escribirRegistros(nuevos, 10);
+
+      // Los mensajes de cada operacion no se muestran
+      std::ostringstream silencio;
+      std::streambuf* salida = std::cout.rdbuf(silencio.rdbuf());
+      FileProtector original;
+      original.CargarArchivo(crudos);
+      bool cifro = esXor ? original.CifrarXOR(cifrado, clave) : original.CifrarDES(cifrado, clave);
+      FileProtector agregado;
+      agregado.CargarArchivo(nuevos);
+      bool conOtra = agregado.AgregarCifrado(cifrado, tipo, otra);
+      bool conClave = agregado.AgregarCifrado(cifrado, tipo, clave);
+      std::cout.rdbuf(salida);
+
+      if (!cifro || !conClave) {
+        rechazadas++;
+      }
+      if (conOtra) {
+        aceptadasErroneas++;
+      }
+    }
+    std::cout << RecordCipher::name(tipo) << ": " << RONDAS - rechazadas << "/" << RONDAS
+              << " agregados con la misma clave, " << aceptadasErroneas
+              << " aceptados con otra clave" << std::endl;
+    fallos += rechazadas + aceptadasErroneas;
+  }
+
+  std::remove(crudos.c_str());
+  std::remove(nuevos.c_str());
+  std::remove(cifrado.c_str());
+  std::cout << (fallos == 0 ? "[OK] Comprobacion de agregado correcta" : "ERROR: Comprobacion de agregado fallida")
+            << std::endl;
+  return fallos == 0;
+}
+
 int
-main() {
+main(int argc, char* argv[]) {
   FileProtector protector;
   std::string opcion;
 
@@ -94,6 +300,52 @@ main() {
   const std::string CARPETA_CRUDOS = "archivos/Datos crudos/";
   const std::string CARPETA_CIFRADOS = "archivos/Datos cif/";
 
+  // Comprobacion de AgregarCifrado: --comprobar-agregado
+  if (argc == 2 && std::string(argv[1]) == "--comprobar-agregado") {
+    return comprobarAgregado() ? 0 : 1;
+  }
+
+  // Modo daemon sin menu: --daemon <tipo> [hilos] [--una-vez] [--clave-archivo <ruta>]
+  // La clave nunca va en los argumentos: cualquier usuario los ve con ps
+  if (argc >= 2 && std::string(argv[1]) == "--daemon") {
+    bool usoValido = argc >= 3;
+    unsigned int hilos = 0;
+    bool unaVez = false;
+    std::string archivoClave;
+    for (int i = 3; i < argc && usoValido; i++) {
+      std::string argumento = argv[i];
+      if (argumento == "--una-vez") {
+        unaVez = true;
+      }
+      else if (argumento == "--clave-archivo" && i + 1 < argc) {
+        archivoClave = argv[++i];
+      }
+      else if (!argumento.empty() &&
+               argumento.find_first_not_of("0123456789") == std::string::npos) {
+        hilos = static_cast<unsigned int>(std::strtoul(argumento.c_str(), nullptr, 10));
+      }
+      else {
+        usoValido = false;
+      }
+    }
+    if (!usoValido) {
+      std::cout << "Uso: " << argv[0] << " --daemon <tipo 1-5> [hilos] [--una-vez]"
+                << " [--clave-archivo <ruta>]" << std::endl;
+      std::cout << "La clave se lee de --clave-archivo, de la variable VGS_CLAVE o de la entrada estandar"
+                << std::endl;
+      return 1;
+    }
+    // ASCII-Binary no usa clave, como en el menu
+    std::string tipo = argv[2];
+    std::string clave;
+    bool usaClave = tipo != std::to_string(static_cast<int>(CipherType::AsciiBinary));
+    if (usaClave && !leerClaveDaemon(archivoClave, clave)) {
+      return 1;
+    }
+    return ejecutarDaemon(CARPETA_CRUDOS, CARPETA_CIFRADOS, tipo, clave, hilos, unaVez)
+           ? 0 : 1;
+  }
+
   std::cout << "\n**********************************************" << std::endl;
   std::cout << "*     SISTEMA DE CIFRADO DE ARCHIVOS         *" << std::endl;
   std::cout << "**********************************************" << std::endl;
@@ -194,7 +446,19 @@ main() {
           std::cout << "\nIngrese la clave (EXACTAMENTE 8 caracteres): ";
           std::getline(std::cin, clave);
 
-          if (protector.CifrarDES(rutaSalida, clave)) {
+          // ECB es el formato original; CBC y CTR usan un IV por registro
+          std::string modoTexto;
+          std::cout << "Modo (1 = ECB, 2 = CBC, 3 = CTR) [1]: ";
+          std::getline(std::cin, modoTexto);
+          DesModes::Mode modo = DesModes::Mode::ECB;
+          if (modoTexto == "2") {
+            modo = DesModes::Mode::CBC;
+          }
+          else if (modoTexto == "3") {
+            modo = DesModes::Mode::CTR;
+          }
+
+          if (protector.CifrarDES(rutaSalida, clave, modo)) {
             std::cout << "\nArchivo cifrado exitosamente!" << std::endl;
             std::cout << "Guardado como: " << rutaSalida << std::endl;
           }
@@ -300,6 +564,30 @@ main() {
       }
     }
     else if (opcion == "3") {
+      // Vigilar carpeta
+      std::string tipoCifrado;
+      std::string clave;
+
+      std::cout << "\n******** MODO DAEMON ********" << std::endl;
+      std::cout << "Los archivos nuevos o modificados en " << CARPETA_CRUDOS
+                << " se cifraran en " << CARPETA_CIFRADOS << std::endl;
+      mostrarMenuCifrados();
+      std::getline(std::cin, tipoCifrado);
+      mostrarInfoCifrado(tipoCifrado);
+
+      if (tipoCifrado == "2") {
+        std::cout << "\nIngrese el desplazamiento (1-25): ";
+        std::getline(std::cin, clave);
+      }
+      else if (tipoCifrado != "3") {
+        mostrarAdvertencia();
+        std::cout << "\nIngrese la clave de cifrado: ";
+        std::getline(std::cin, clave);
+      }
+
+      ejecutarDaemon(CARPETA_CRUDOS, CARPETA_CIFRADOS, tipoCifrado, clave, 0, false);
+    }
+    else if (opcion == "4") {
       std::cout << "\nCerrando programa..." << std::endl;
       break;
     }